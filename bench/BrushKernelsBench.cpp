@@ -0,0 +1,124 @@
+// Times BrushKernels' scalar versions against the paths the build picked
+// (SSE2, plus AVX2 with JUICEBOX_AVX2) on 257-texel rows, the width of a
+// stamp at the largest brush radius, and checks both give the same bytes.
+// Exits with 1 if any kernel's output differs.
+//
+//   cmake -S . -B build -DJUICEBOX_BENCHMARKS=ON [-DJUICEBOX_AVX2=ON]
+//   cmake --build build --target BrushKernelsBench && ./build/BrushKernelsBench
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "painter/BrushKernels.h"
+
+namespace {
+    constexpr u32 ROW = 257;
+    constexpr u32 ROWS = 257;        // One full stamp per pass
+    constexpr u32 PASSES = 200;
+    constexpr f32 RADIUS = 128.0f;
+    constexpr f32 STRENGTH = 256.0f;
+
+    std::mt19937 generator(1234);
+
+    // Texels around a few base colours, so REPLACE finds something to replace
+    std::vector<u32> MakeTexels(u32 count) {
+        const u32 bases[] = { 0xFF804020u, 0xFF20A0C0u, 0xFFE0E0E0u, 0xFF101010u };
+        std::vector<u32> texels(count);
+        for (u32& texel : texels) {
+            u32 color = bases[generator() % 4];
+            for (u32 channel = 0; channel < 24; channel += 8) {
+                s32 value = (s32)((color >> channel) & 0xFF) + (s32)(generator() % 41) - 20;
+                value = std::min(std::max(value, 0), 255);
+                color = (color & ~(0xFFu << channel)) | ((u32)value << channel);
+            }
+            texel = color;
+        }
+        return texels;
+    }
+
+    // Weights as a soft brush writes them: full, falling off and zero
+    std::vector<u16> MakeWeights(u32 count) {
+        std::vector<u16> weights(count);
+        for (u32 r = 0; r < count / ROW; ++r)
+            BrushKernels::Scalar::SoftRound(0, RADIUS, (f32)r - RADIUS, ROW, RADIUS, RADIUS * 0.5f, STRENGTH, &weights[r * ROW]);
+        return weights;
+    }
+
+    template<typename Kernel>
+    f64 Time(Kernel kernel) {
+        auto start = std::chrono::steady_clock::now();
+        for (u32 pass = 0; pass < PASSES; ++pass)
+            for (u32 r = 0; r < ROWS; ++r)
+                kernel(r);
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / PASSES;
+    }
+
+    bool failed = false;
+
+    // Runs both versions on copies of the same output, then compares them
+    template<typename T, typename Scalar, typename Dispatched>
+    void Compare(const char* name, const std::vector<T>& initial, Scalar scalar, Dispatched dispatched) {
+        std::vector<T> expected = initial, actual = initial;
+        const f64 scalarMs = Time([&](u32 r) { scalar(r, expected.data()); });
+        const f64 dispatchedMs = Time([&](u32 r) { dispatched(r, actual.data()); });
+        const bool same = std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(T)) == 0;
+        failed |= !same;
+
+        std::cout << name << ": scalar " << scalarMs << " ms, dispatched " << dispatchedMs << " ms per stamp ("
+                  << scalarMs / dispatchedMs << "x)" << (same ? "" : ", OUTPUT DIFFERS") << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << "BrushKernels, " << ROW << "x" << ROWS << " texels per stamp, paths:"
+#if defined(JUICEBOX_BRUSH_SSE2)
+              << " SSE2"
+#endif
+#if defined(JUICEBOX_BRUSH_AVX2)
+              << " AVX2"
+#endif
+              << std::endl;
+
+    const u32 count = ROW * ROWS;
+    const std::vector<u32> texels = MakeTexels(count);
+    const std::vector<u16> weights = MakeWeights(count);
+    const std::vector<u32> palette = { 0xFF000000u, 0xFFFFFFFFu, 0xFFFF0000u, 0xFF00FF00u, 0xFF0000FFu, 0xFF808080u };
+    const std::vector<u32> clut = MakeTexels(16);
+    const u32 color = 0xFFC03060u;
+    const u32 target = texels[count / 2];
+
+    // An odd centre puts the rim between texels, and rows past the radius come out empty
+    const f32 centerX = RADIUS + 0.37f;
+    auto dy = [&](u32 r) { return (f32)r - RADIUS + 0.21f; };
+
+    const std::vector<u16> noWeights(count, 0);
+    Compare("HardRound", noWeights,
+        [&](u32 r, u16* out) { BrushKernels::Scalar::HardRound(0, centerX, dy(r), ROW, RADIUS, STRENGTH, out + r * ROW); },
+        [&](u32 r, u16* out) { BrushKernels::HardRound(0, centerX, dy(r), ROW, RADIUS, STRENGTH, out + r * ROW); });
+    Compare("SoftRound", noWeights,
+        [&](u32 r, u16* out) { BrushKernels::Scalar::SoftRound(0, centerX, dy(r), ROW, RADIUS, RADIUS * 0.5f, STRENGTH, out + r * ROW); },
+        [&](u32 r, u16* out) { BrushKernels::SoftRound(0, centerX, dy(r), ROW, RADIUS, RADIUS * 0.5f, STRENGTH, out + r * ROW); });
+
+    // In place, so every pass works on what the previous one left; both sides see the same sequence
+    Compare("Blend", texels,
+        [&](u32 r, u32* out) { BrushKernels::Scalar::Blend(out + r * ROW, &weights[r * ROW], ROW, color); },
+        [&](u32 r, u32* out) { BrushKernels::Blend(out + r * ROW, &weights[r * ROW], ROW, color); });
+    Compare("Replace", texels,
+        [&](u32 r, u32* out) { BrushKernels::Scalar::Replace(out + r * ROW, &weights[r * ROW], ROW, target, 24, color); },
+        [&](u32 r, u32* out) { BrushKernels::Replace(out + r * ROW, &weights[r * ROW], ROW, target, 24, color); });
+    Compare("Snap", texels,
+        [&](u32 r, u32* out) { BrushKernels::Scalar::Snap(out + r * ROW, &weights[r * ROW], ROW, palette.data(), (u32)palette.size()); },
+        [&](u32 r, u32* out) { BrushKernels::Snap(out + r * ROW, &weights[r * ROW], ROW, palette.data(), (u32)palette.size()); });
+
+    const std::vector<u8> noIndices(count, 0);
+    Compare("NearestIndex", noIndices,
+        [&](u32 r, u8* out) { BrushKernels::Scalar::NearestIndex(&texels[r * ROW], ROW, clut.data(), (u32)clut.size(), out + r * ROW); },
+        [&](u32 r, u8* out) { BrushKernels::NearestIndex(&texels[r * ROW], ROW, clut.data(), (u32)clut.size(), out + r * ROW); });
+
+    return failed ? 1 : 0;
+}
@@ -1,22 +1,33 @@
 #include "Application.h"
 #include <iostream>
 
-Application::Application() : device(nullptr), driver(nullptr), smgr(nullptr) {
+#include "helpers/BootProfiler.h"
+
+Application::Application()
+    : device(nullptr), driver(nullptr), smgr(nullptr),
+      textures(std::make_unique<TextureCache>()),
+      _guiStarted(false) {
 }
 
 Application::~Application() {
+    // Workers decode through the driver, so they stop before it goes
+    textures.reset();
+
     if (device) {
         device->drop();
     }
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui::DestroyContext();
+    if (_guiStarted) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     std::cout << "Shutdown Application" << std::endl;
 }
 
 bool Application::BeginCore() {
     this->_windowResolution = WindowResolution::Get();
+    BootProfiler::Phase("Desktop resolution");
 
     // 4. Create the main device using the fetched resolution
     device = createDevice(
@@ -37,6 +48,9 @@ bool Application::BeginCore() {
     driver = device->getVideoDriver();
     driver->setTextureCreationFlag(irr::video::ETCF_CREATE_MIP_MAPS, false);
     smgr = device->getSceneManager();
+    BootProfiler::Phase("Device");
+
+    textures->Attach(driver, device->getFileSystem());
 
     return true;
 }
@@ -49,4 +63,31 @@ void Application::BeginGUI() {
     
     ImGui::StyleColorsDark();
     ImGui_ImplOpenGL3_Init("#version 130");
+    _guiStarted = true;
+    BootProfiler::Phase("GUI");
+}
+
+bool Application::BeginHeadless(dimension2d<u32> size) {
+    SIrrlichtCreationParameters parameters;
+    parameters.DriverType = EDT_BURNINGSVIDEO;
+    parameters.DeviceType = EIDT_CONSOLE;
+    parameters.WindowSize = size;
+    parameters.Bits = 32;
+    parameters.EventReceiver = &receiver;
+
+    device = createDeviceEx(parameters);
+    if (!device) {
+        parameters.DeviceType = EIDT_BEST;
+        device = createDeviceEx(parameters);
+    }
+    if (!device) {
+        std::cout << "No software renderer available (console device or display)" << std::endl;
+        return false;
+    }
+
+    driver = device->getVideoDriver();
+    driver->setTextureCreationFlag(irr::video::ETCF_CREATE_MIP_MAPS, false);
+    smgr = device->getSceneManager();
+    textures->Attach(driver, device->getFileSystem());
+    return true;
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <irrlicht.h>
+#include <memory>
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "JuiceBoxEventListener.h"
 #include "helpers/WindowResolution.h"
+#include "io/TextureCache.h"
 
 using namespace irr;
 using namespace core;
@@ -20,12 +22,19 @@ public:
     IVideoDriver* driver;
     ISceneManager* smgr;
     JuiceBoxEventListener receiver;
+    std::unique_ptr<TextureCache> textures; // Reads files from construction, decodes once the device exists
 
     Application(); // Constructor declaration
     ~Application(); // Destructor declaration
 
     bool BeginCore();
     void BeginGUI();
+
+    // Software rendering without a window where Irrlicht was built with the
+    // console device, otherwise in a small window (an X server such as Xvfb
+    // is enough). No GUI.
+    bool BeginHeadless(dimension2d<u32> size);
 private:
     dimension2d<u32> _windowResolution;
+    bool _guiStarted;
 };
\ No newline at end of file
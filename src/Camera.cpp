@@ -39,6 +39,19 @@ void Camera::Rotate()
     _phi += mouseDelta.Y * _sensitivity;  
     if (_phi > 89.0f) _phi = 89.0f;
     if (_phi < -89.0f) _phi = -89.0f;
+    _applyOrbit();
+}
+
+void Camera::SetOrbit(f32 radius, f32 theta, f32 phi)
+{
+    _cameraRadius = radius > 0.0f ? radius : _cameraRadius;
+    _theta = theta;
+    _phi = core::clamp(phi, -89.0f, 89.0f);
+    _applyOrbit();
+}
+
+void Camera::_applyOrbit()
+{
     f32 r = _cameraRadius;
     f32 radTheta = _theta * DEGTORAD;
     f32 radPhi = _phi * DEGTORAD;
@@ -24,6 +24,10 @@ public:
     void SetUpVector(vector3df up) { _camera->setUpVector(up); }
     void Rotate();
 
+    // Orbit around the origin, in degrees (used to save and restore the view)
+    void GetOrbit(f32& radius, f32& theta, f32& phi) const { radius = _cameraRadius; theta = _theta; phi = _phi; }
+    void SetOrbit(f32 radius, f32 theta, f32 phi);
+
 private:
     ICameraSceneNode* _camera;
     Application& _application;
@@ -44,4 +48,5 @@ private:
     static constexpr int ORTHO_FAR = 100;
 
     void _setInitialPosition();
+    void _applyOrbit();
 };
\ No newline at end of file
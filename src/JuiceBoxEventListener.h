@@ -1,6 +1,7 @@
 #pragma once
 
 #include <irrlicht.h>
+#include <vector>
 
 using namespace irr;
 using namespace core;
@@ -21,12 +22,25 @@ public:
         const s32 DragThreshold = 4; 
     } MouseState;
 
+    // Every left-button position since the last EndFrame, in arrival order.
+    // MouseState only keeps the newest one, which leaves gaps in fast strokes.
+    struct SMouseSample {
+        position2di Position;
+    };
+    std::vector<SMouseSample> MouseSamples;
+    static constexpr u32 MAX_MOUSE_SAMPLES = 512; // Oldest are dropped if a frame stalls
+
     bool KeyIsDown[KEY_KEY_CODES_COUNT];
+    bool KeyWasDown[KEY_KEY_CODES_COUNT]; // Key state from previous frame
+    bool ControlDown; // Either Ctrl key, as of the last key event
 
     JuiceBoxEventListener() {
-        for (u32 i = 0; i < KEY_KEY_CODES_COUNT; ++i)
+        for (u32 i = 0; i < KEY_KEY_CODES_COUNT; ++i) {
             KeyIsDown[i] = false;
+            KeyWasDown[i] = false;
+        }
         
+        ControlDown = false;
         MouseState.LeftButtonDown = false;
         MouseState.WasLeftButtonDown = false;  // NEW: Initialize
         MouseState.IsDragging = false;
@@ -48,6 +62,7 @@ public:
                     MouseState.Position = position2di(event.MouseInput.X, event.MouseInput.Y);
                     MouseState.ClickPosition = MouseState.Position;
                     MouseState.LastPosition = MouseState.Position;
+                    _addSample();
                     break;
 
                 case EMIE_LMOUSE_LEFT_UP:
@@ -59,6 +74,8 @@ public:
                     MouseState.LastPosition = MouseState.Position;
                     MouseState.Position.X = event.MouseInput.X;
                     MouseState.Position.Y = event.MouseInput.Y;
+                    if (MouseState.LeftButtonDown)
+                        _addSample();
 
                     // If button is held, check if we should start dragging
                     if (MouseState.LeftButtonDown && !MouseState.IsDragging) {
@@ -77,6 +94,7 @@ public:
         
         else if (event.EventType == EET_KEY_INPUT_EVENT) {
             KeyIsDown[event.KeyInput.Key] = event.KeyInput.PressedDown;
+            ControlDown = event.KeyInput.Control;
             return false;
         }
         
@@ -88,6 +106,11 @@ public:
         return KeyIsDown[keyCode];
     }
 
+    // True only on the frame the key went down (for one-shot actions)
+    bool IsKeyPressed(EKEY_CODE keyCode) const {
+        return KeyIsDown[keyCode] && !KeyWasDown[keyCode];
+    }
+
     core::vector2di GetMouseDelta() const {
         return MouseState.Position - MouseState.LastPosition;
     }
@@ -95,9 +118,19 @@ public:
     // NEW: Call this at the end of each frame to update previous state
     void EndFrame() {
         MouseState.WasLeftButtonDown = MouseState.LeftButtonDown;
+        MouseSamples.clear();
+        for (u32 i = 0; i < KEY_KEY_CODES_COUNT; ++i)
+            KeyWasDown[i] = KeyIsDown[i];
     }
 
     void UpdateLastPosition() {
         MouseState.LastPosition = MouseState.Position;
     }
+
+private:
+    void _addSample() {
+        if (MouseSamples.size() >= MAX_MOUSE_SAMPLES)
+            MouseSamples.erase(MouseSamples.begin());
+        MouseSamples.push_back({ MouseState.Position });
+    }
 };
\ No newline at end of file
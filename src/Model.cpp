@@ -1,4 +1,6 @@
 #include "Model.h"
+#include <algorithm>
+#include <chrono>
 
 Model::Model(Application &application)
 :_application(application),
@@ -23,8 +25,12 @@ void Model::GenerateDefault()
         _mesh->setPosition(vector3df(0, 0, 0));
         _mesh->setMaterialFlag(EMF_LIGHTING, false);
         
-        // Load and apply the crate texture
-        ITexture* crateTexture = _application.driver->getTexture("assets/crate.png");
+        // Load and apply the crate texture. It decodes on a worker; the
+        // placeholder shows until then, unless something replaced it first.
+        ITexture* crateTexture = _application.textures->Request(DEFAULT_TEXTURE_PATH, [this](ITexture* texture) {
+            if (_mesh && _application.textures->IsPlaceholder(_mesh->getMaterial(0).getTexture(0)))
+                _mesh->setMaterialTexture(0, texture);
+        });
         if (crateTexture) {
             _mesh->setMaterialTexture(0, crateTexture);
         }
@@ -33,6 +39,194 @@ void Model::GenerateDefault()
     _application.smgr->addLightSceneNode(0, vector3df(0, 10, -10), SColorf(1.0f, 1.0f, 1.0f), 40.0f);
 }
 
+bool Model::CreatePrimitive(PrimitiveType type, const Primitives::Params& params)
+{
+    if (!_mesh)
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    SMesh* primitive = Primitives::Create(type, params);
+    if (!primitive) {
+        std::cout << "Failed to create primitive: " << Primitives::Name(type) << std::endl;
+        return false;
+    }
+
+    _replaceMesh(primitive);
+
+    u32 vertexCount = 0, triangleCount = 0;
+    for (u32 i = 0; i < primitive->getMeshBufferCount(); ++i) {
+        vertexCount += primitive->getMeshBuffer(i)->getVertexCount();
+        triangleCount += primitive->getMeshBuffer(i)->getIndexCount() / 3;
+    }
+
+    f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Primitive: " << Primitives::Name(type) << ", " << vertexCount << " vertices, "
+              << triangleCount << " triangles, " << primitive->getMeshBufferCount() << " buffers in "
+              << milliseconds << " ms" << std::endl;
+    return true;
+}
+
+bool Model::SaveProject(const std::string& path, const ProjectFile::CameraState& camera)
+{
+    if (!_mesh)
+        return false;
+
+#ifdef _WIN32
+    // Windows locks a mapped file against writes and renames. Elsewhere the
+    // save appends to it or renames over it, and the mapping is unaffected.
+    if (_mapping && _mapping->GetPath() == path)
+        _detachMapping();
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    ProjectFile::ProjectData data;
+    data.camera = camera;
+
+    IMesh* mesh = _mesh->getMesh();
+    std::vector<SavedBuffer> saved;
+    for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+    {
+        IMeshBuffer* mb = mesh->getMeshBuffer(i);
+        if (mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT)
+            continue;
+
+        ProjectFile::BufferView view;
+        view.vertices = (const S3DVertex*)mb->getVertices();
+        view.vertexCount = mb->getVertexCount();
+        view.indices = mb->getIndices();
+        view.indexCount = mb->getIndexCount();
+        view.bounds = mb->getBoundingBox();
+
+        // Only buffers edited since the last save or load are hashed again
+        SavedBuffer entry;
+        entry.source = mb;
+        entry.vertexChangedId = mb->getChangedID_Vertex();
+        entry.indexChangedId = mb->getChangedID_Index();
+        const SavedBuffer* previous = saved.size() < _savedBuffers.size() ? &_savedBuffers[saved.size()] : nullptr;
+        bool sameBuffer = previous && previous->source == mb;
+
+        entry.hashes.vertices = sameBuffer && previous->vertexChangedId == entry.vertexChangedId && previous->hashes.vertices
+            ? previous->hashes.vertices
+            : ProjectFile::HashPayload(view.vertices, view.vertexCount * sizeof(S3DVertex));
+        entry.hashes.indices = sameBuffer && previous->indexChangedId == entry.indexChangedId && previous->hashes.indices
+            ? previous->hashes.indices
+            : ProjectFile::HashPayload(view.indices, view.indexCount * sizeof(u16));
+
+        view.vertexHash = entry.hashes.vertices;
+        view.indexHash = entry.hashes.indices;
+        data.buffers.push_back(view);
+        saved.push_back(entry);
+    }
+
+    ITexture* texture = _mesh->getMaterial(0).getTexture(0);
+    if (_application.textures->IsPlaceholder(texture))
+        texture = nullptr;
+    void* pixels = texture ? texture->lock(ETLM_READ_ONLY) : nullptr;
+    if (pixels) {
+        data.texture.pixels = pixels;
+        data.texture.width = texture->getSize().Width;
+        data.texture.height = texture->getSize().Height;
+        data.texture.pitch = texture->getPitch();
+        data.texture.format = texture->getColorFormat();
+    }
+
+    ProjectFile::SaveReport report;
+    bool written = ProjectFile::Save(path, data, false, &report);
+    if (pixels)
+        texture->unlock();
+
+    if (written) {
+        _savedBuffers = std::move(saved);
+        f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Saved " << path << " in " << milliseconds << " ms: " << report.chunksWritten << " chunks written ("
+                  << report.bytesWritten / 1024 << " KB), " << report.chunksReused << " reused ("
+                  << report.bytesReused / 1024 << " KB)" << (report.compacted ? ", compacted" : "") << std::endl;
+    }
+    return written;
+}
+
+bool Model::LoadProject(const std::string& path, ProjectFile::CameraState& camera, bool& hasCamera)
+{
+    if (!_mesh)
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    ProjectFile::LoadedProject project;
+    if (!ProjectFile::Load(path, _application.driver, project))
+        return false;
+
+    _replaceMesh(project.mesh);
+    _mapping = project.file;
+
+    // The stored hashes describe the buffers exactly as loaded
+    for (u32 i = 0; i < project.mesh->getMeshBufferCount() && i < project.hashes.size(); ++i)
+    {
+        IMeshBuffer* mb = project.mesh->getMeshBuffer(i);
+        SavedBuffer entry;
+        entry.source = mb;
+        entry.vertexChangedId = mb->getChangedID_Vertex();
+        entry.indexChangedId = mb->getChangedID_Index();
+        entry.hashes = project.hashes[i];
+        _savedBuffers.push_back(entry);
+    }
+
+    if (project.texture) {
+        // Reloading the same project replaces its texture rather than adding a second copy
+        io::path name = (path + "#texture").c_str();
+        ITexture* old = _application.driver->findTexture(name);
+        if (old) {
+            for (u32 i = 0; i < _mesh->getMaterialCount(); ++i)
+                _mesh->getMaterial(i).setTexture(0, nullptr);
+            _application.driver->removeTexture(old);
+        }
+
+        ITexture* texture = _application.driver->addTexture(name, project.texture);
+        project.texture->drop();
+        if (texture)
+            _mesh->setMaterialTexture(0, texture);
+    }
+
+    camera = project.camera;
+    hasCamera = project.hasCamera;
+
+    f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << path << " in " << milliseconds << " ms" << std::endl;
+    return true;
+}
+
+bool Model::ImportObj(const std::string& path)
+{
+    if (!_mesh)
+        return false;
+
+    ObjImporter::Report report;
+    SMesh* mesh = ObjImporter::Load(path, report);
+    if (!mesh)
+        return false;
+
+    _replaceMesh(mesh);
+
+    // Files without normals get smooth ones, split at hard edges like edited meshes
+    if (!report.hasNormals) {
+        _topology.resize(mesh->getMeshBufferCount());
+        for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+            Normals::RecalculateAll(mesh->getMeshBuffer(i), _topology[i]);
+    }
+
+    report.Print("Import");
+    return true;
+}
+
+std::shared_ptr<const MeshSnapshot> Model::CaptureSnapshot()
+{
+    if (!_mesh)
+        return nullptr;
+
+    // Buffers untouched since the last capture are shared with it, not copied
+    _snapshot = MeshSnapshot::Capture(_mesh->getMesh(), _snapshot.get());
+    return _snapshot;
+}
+
 void Model::UpdateMesh(vector3df vertexCurrent, vector3df vertexNew)
 {
     if (!_mesh) 
@@ -40,12 +234,16 @@ void Model::UpdateMesh(vector3df vertexCurrent, vector3df vertexNew)
 
     IMesh* mesh = _mesh->getMesh();
     u32 bufferCount = mesh->getMeshBufferCount();
+    if (_movedVertices.size() < bufferCount)
+        _movedVertices.resize(bufferCount);
 
     // Iterate through all mesh buffers (a mesh can have multiple)
     for (u32 i = 0; i < bufferCount; ++i) 
     {
         IMeshBuffer* mb = mesh->getMeshBuffer(i);
         
+        bool moved = false;
+
         // Ensure we are working with standard vertices
         if (mb->getVertexType() == EVT_STANDARD) 
         {
@@ -58,6 +256,8 @@ void Model::UpdateMesh(vector3df vertexCurrent, vector3df vertexNew)
                 if (vertices[j].Pos.equals(vertexCurrent, 0.001f)) 
                 {
                     vertices[j].Pos = vertexNew;
+                    _movedVertices[i].push_back(j);
+                    moved = true;
                 }
             }
         }
@@ -68,13 +268,111 @@ void Model::UpdateMesh(vector3df vertexCurrent, vector3df vertexNew)
             for (u32 j = 0; j < mb->getVertexCount(); ++j)
             {
                 if (vertices[j].Pos.equals(vertexCurrent, 0.001f))
+                {
                     vertices[j].Pos = vertexNew;
+                    moved = true;
+                }
             }
         }
+
+        // CRITICAL: Inform the hardware that the vertex data has changed.
+        // Only touched buffers, so snapshots keep sharing the others.
+        if (moved)
+            mb->setDirty(EBT_VERTEX);
+    }
+}
+
+void Model::RefreshNormals()
+{
+    if (!_mesh)
+        return;
+
+    IMesh* mesh = _mesh->getMesh();
+    u32 bufferCount = mesh->getMeshBufferCount();
+    if (_topology.size() < bufferCount)
+        _topology.resize(bufferCount);
+
+    for (u32 i = 0; i < bufferCount && i < _movedVertices.size(); ++i)
+    {
+        std::vector<u32>& moved = _movedVertices[i];
+        if (moved.empty())
+            continue;
+
+        IMeshBuffer* mb = mesh->getMeshBuffer(i);
+        if (mb->getVertexType() == EVT_STANDARD)
+        {
+            Normals::UpdateIncremental(mb, _topology[i], moved.data(), (u32)moved.size());
+            mb->setDirty(EBT_VERTEX);
+        }
+        moved.clear();
     }
+}
+
+MeshCleanup::Report Model::Cleanup(f32 mergeDistance, bool mergeAcrossSeams)
+{
+    if (!_mesh)
+        return MeshCleanup::Report();
+
+    // Indices are rewritten, so any selection would point at the wrong elements
+    ClearAll();
+    _movedVertices.clear();
+
+    MeshCleanup::Report report = MeshCleanup::Run(_mesh->getMesh(), mergeDistance, mergeAcrossSeams);
+    report.Print("Cleanup");
+    return report;
+}
+
+UVPack::Report Model::PackUVs(const UVPack::Settings& settings)
+{
+    if (!_mesh)
+        return UVPack::Report();
 
-    // CRITICAL: Inform the hardware that the vertex data has changed
-    _mesh->getMesh()->setDirty(EBT_VERTEX);
+    // Only UVs change, in place, so selections and mapped buffers stay valid
+    UVPack::Report report = UVPack::Run(_mesh->getMesh(), settings);
+    report.Print("Pack UVs");
+    return report;
+}
+
+Unwrap::Report Model::UnwrapUVs(const UVPack::Settings& settings)
+{
+    if (!_mesh)
+        return Unwrap::Report();
+
+    // Cutting closed islands adds vertices, which mapped buffers cannot take
+    _detachMapping();
+    IMesh* mesh = _mesh->getMesh();
+    Unwrap::Report report = Unwrap::Run(mesh);
+    report.Print("Unwrap");
+    UVPack::Run(mesh, settings).Print("Pack UVs");
+    return report;
+}
+
+TextureAtlas::Report Model::BuildTextureAtlas(const TextureAtlas::Settings& settings)
+{
+    if (!_mesh)
+        return TextureAtlas::Report();
+
+    std::vector<SMaterial> materials;
+    for (u32 i = 0; i < _mesh->getMaterialCount(); ++i) {
+        if (_application.textures->IsPlaceholder(_mesh->getMaterial(i).getTexture(0))) {
+            std::cout << "Texture atlas: a texture is still loading" << std::endl;
+            return TextureAtlas::Report();
+        }
+        materials.push_back(_mesh->getMaterial(i));
+    }
+
+    // Building again packs the previous atlas like any other texture, then drops it
+    ITexture* previous = _application.driver->findTexture(ATLAS_TEXTURE_NAME);
+
+    TextureAtlas::Result result;
+    TextureAtlas::Report report = TextureAtlas::Build(_mesh->getMesh(), materials, _application.driver, ATLAS_TEXTURE_NAME, settings, result);
+    if (result.mesh)
+        _replaceMesh(result.mesh, result.materials);
+    if (previous && result.texture && previous != result.texture)
+        _application.driver->removeTexture(previous);
+
+    report.Print("Texture atlas");
+    return report;
 }
 
 void Model::AddSelectedVertex(vector3df position)
@@ -88,15 +386,7 @@ void Model::AddSelectedVertex(vector3df position)
     }
 
     // 2. If we reached here, the vertex is unique
-    ISceneNode* selected = _application.smgr->addCubeSceneNode(0.5f);
-    selected->setPosition(position);
-    selected->setMaterialFlag(EMF_LIGHTING, true);
-    selected->setMaterialFlag(EMF_ZBUFFER, false);
-    selected->setMaterialFlag(EMF_ZWRITE_ENABLE, false);
-
-    selected->getMaterial(0).EmissiveColor.set(255, 0, 255, 0);
-
-    _selectedVertices.push_back(selected);
+    _selectedVertices.push_back(_createVertexMarker(position));
 }
 
 std::vector<ISceneNode *> Model::GetSelectedVertices()
@@ -114,7 +404,274 @@ void Model::ClearSelectedVertices()
     _selectedVertices.clear();
 }
 
+void Model::BeginSoftSelection(f32 radius, FalloffCurve curve)
+{
+    if (!_mesh || _selectedVertices.empty())
+        return;
+
+    // Positions change between drags, so the index is rebuilt when a drag starts
+    SoftSelection::BuildIndex(_mesh->getMesh(), radius, _vertexGrid, _vertexRefs);
+
+    std::vector<vector3df> centres;
+    centres.reserve(_selectedVertices.size());
+    for (ISceneNode* node : _selectedVertices)
+    {
+        if (node) centres.push_back(node->getPosition());
+    }
+
+    SoftSelection::Gather(_vertexGrid, _vertexRefs, centres, radius, curve, _softSelection);
+    _softSelectionActive = true;
+}
+
+void Model::MoveSoftSelection(vector3df delta)
+{
+    if (!_mesh || !_softSelectionActive)
+        return;
+
+    IMesh* mesh = _mesh->getMesh();
+    if (_movedVertices.size() < mesh->getMeshBufferCount())
+        _movedVertices.resize(mesh->getMeshBufferCount());
+
+    for (const SoftSelection::Entry& entry : _softSelection)
+    {
+        S3DVertex* vertices = (S3DVertex*)mesh->getMeshBuffer(entry.bufferIndex)->getVertices();
+        vertices[entry.vertexIndex].Pos += delta * entry.weight;
+        _movedVertices[entry.bufferIndex].push_back(entry.vertexIndex);
+    }
+
+    for (ISceneNode* node : _selectedVertices)
+    {
+        if (node) node->setPosition(node->getPosition() + delta);
+    }
+
+    for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+    {
+        if (!_movedVertices[i].empty())
+            mesh->getMeshBuffer(i)->setDirty(EBT_VERTEX);
+    }
+}
+
+void Model::EndSoftSelection()
+{
+    if (!_softSelectionActive)
+        return;
+
+    _softSelection.clear();
+    _softSelectionActive = false;
+
+    IMesh* mesh = _mesh->getMesh();
+    for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+        mesh->getMeshBuffer(i)->recalculateBoundingBox();
+    static_cast<SMesh*>(mesh)->recalculateBoundingBox();
+}
+
+void Model::AddSelectedFace(const FaceSelection& face)
+{
+    for (const FaceSelection& selected : _selectedFaces)
+    {
+        if (selected.bufferIndex == face.bufferIndex &&
+            selected.triangleIndex1 == face.triangleIndex1)
+        {
+            return;
+        }
+    }
+
+    _selectedFaces.push_back(face);
+}
+
+void Model::ClearSelectedFaces()
+{
+    _selectedFaces.clear();
+}
+
+bool Model::ExtrudeSelectedFaces(f32 distance)
+{
+    return _applyFaceOperator(FaceOps::Extrude, distance, "Extrude");
+}
+
+bool Model::InsetSelectedFaces(f32 amount)
+{
+    return _applyFaceOperator(FaceOps::Inset, amount, "Inset");
+}
+
 void Model::ClearAll()
 {
     ClearSelectedVertices();
+    ClearSelectedFaces();
+}
+
+void Model::_replaceMesh(SMesh* mesh, const std::vector<SMaterial>& materials)
+{
+    // Everything cached against the old buffers is stale now
+    EndSoftSelection();
+    ClearAll();
+    _movedVertices.clear();
+    _topology.clear();
+
+    // setMesh copies the new buffers' default materials, keep the node's look
+    // instead unless the caller has the materials to use
+    SMaterial material = _mesh->getMaterial(0);
+    _mesh->setMesh(mesh);
+    mesh->drop();
+    for (u32 i = 0; i < _mesh->getMaterialCount(); ++i)
+        _mesh->getMaterial(i) = i < materials.size() ? materials[i] : material;
+
+    // The old buffers are gone, so nothing points into a mapped project anymore
+    // and the last snapshot has nothing left to share with
+    _mapping.reset();
+    _snapshot.reset();
+    _savedBuffers.clear();
+}
+
+void Model::_detachMapping()
+{
+    if (!_mapping)
+        return;
+
+    // Copy every buffer into memory it owns. Irrlicht frees the old storage
+    // whenever an array grows, which must never happen to mapped data.
+    IMesh* mesh = _mesh->getMesh();
+    for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+    {
+        IMeshBuffer* mb = mesh->getMeshBuffer(i);
+        if (mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT)
+            continue;
+
+        SMeshBuffer* buffer = static_cast<SMeshBuffer*>(mb);
+        core::array<S3DVertex> vertices(buffer->Vertices);
+        core::array<u16> indices(buffer->Indices);
+        buffer->Vertices.swap(vertices);
+        buffer->Indices.swap(indices);
+        buffer->setDirty(EBT_VERTEX_AND_INDEX);
+    }
+
+    _mapping.reset();
+}
+
+ISceneNode* Model::_createVertexMarker(vector3df position)
+{
+    ISceneNode* selected = _application.smgr->addCubeSceneNode(0.5f);
+    selected->setPosition(position);
+    selected->setMaterialFlag(EMF_LIGHTING, true);
+    selected->setMaterialFlag(EMF_ZBUFFER, false);
+    selected->setMaterialFlag(EMF_ZWRITE_ENABLE, false);
+
+    selected->getMaterial(0).EmissiveColor.set(255, 0, 255, 0);
+
+    return selected;
+}
+
+bool Model::_applyFaceOperator(FaceOps::Operator op, f32 value, const char* name)
+{
+    if (!_mesh || _selectedFaces.empty())
+        return false;
+
+    _detachMapping();
+    IMesh* mesh = _mesh->getMesh();
+
+    // Group the selection by buffer so each buffer is grown exactly once
+    std::vector<FaceSelection> faces = _selectedFaces;
+    std::stable_sort(faces.begin(), faces.end(), [](const FaceSelection& a, const FaceSelection& b) {
+        return a.bufferIndex < b.bufferIndex;
+    });
+
+    FaceOps::Result total;
+    bool failed = false;
+
+    for (size_t start = 0; start < faces.size();)
+    {
+        size_t end = start;
+        while (end < faces.size() && faces[end].bufferIndex == faces[start].bufferIndex) ++end;
+
+        u32 bufferIndex = faces[start].bufferIndex;
+        IMeshBuffer* mb = bufferIndex < mesh->getMeshBufferCount() ? mesh->getMeshBuffer(bufferIndex) : nullptr;
+
+        if (mb && mb->getVertexType() == EVT_STANDARD && mb->getIndexType() == EIT_16BIT)
+        {
+            _scratch.Reset();
+            FaceOps::Result result = op(static_cast<SMeshBuffer*>(mb), &faces[start], (u32)(end - start), value, _scratch);
+
+            failed |= !result.success;
+            total.facesProcessed += result.facesProcessed;
+            total.verticesAdded += result.verticesAdded;
+            total.indicesAdded += result.indicesAdded;
+        }
+
+        start = end;
+    }
+
+    static_cast<SMesh*>(mesh)->recalculateBoundingBox();
+    _syncFaceSelection();
+
+    std::cout << name << ": " << total.facesProcessed << " faces, +"
+              << total.verticesAdded << " vertices, +"
+              << total.indicesAdded / 3 << " triangles" << std::endl;
+
+    if (failed)
+        std::cout << name << ": skipped a buffer (would exceed " << FaceOps::MAX_VERTICES << " vertices)" << std::endl;
+
+    return total.facesProcessed > 0;
+}
+
+void Model::_syncFaceSelection()
+{
+    IMesh* mesh = _mesh->getMesh();
+    const matrix4& world = _mesh->getAbsoluteTransformation();
+    std::vector<vector3df> positions;
+    positions.reserve(_selectedFaces.size() * 4);
+
+    // Refresh the stored corners from the (possibly rewritten) triangles
+    for (FaceSelection& face : _selectedFaces)
+    {
+        IMeshBuffer* mb = mesh->getMeshBuffer(face.bufferIndex);
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+
+        u32 corners[4];
+        u32 cornerCount = 0;
+        u32 triangles[2] = { face.triangleIndex1, face.triangleIndex2 };
+        for (u32 t = 0; t < (face.isQuad ? 2u : 1u); ++t)
+        {
+            for (u32 k = 0; k < 3; ++k)
+            {
+                u32 index = indices[triangles[t] + k];
+                bool known = false;
+                for (u32 c = 0; c < cornerCount; ++c) known |= corners[c] == index;
+                if (!known && cornerCount < 4) corners[cornerCount++] = index;
+            }
+        }
+
+        u32* vertexIndices[4] = { &face.vertexIndex1, &face.vertexIndex2, &face.vertexIndex3, &face.vertexIndex4 };
+        vector3df* worldPositions[4] = { &face.worldPos1, &face.worldPos2, &face.worldPos3, &face.worldPos4 };
+        for (u32 c = 0; c < cornerCount; ++c)
+        {
+            *vertexIndices[c] = corners[c];
+            *worldPositions[c] = vertices[corners[c]].Pos;
+            world.transformVect(*worldPositions[c]);
+            positions.push_back(*worldPositions[c]);
+        }
+    }
+
+    // One marker per distinct corner, reusing the existing nodes where possible
+    std::sort(positions.begin(), positions.end(), [](const vector3df& a, const vector3df& b) {
+        if (a.X != b.X) return a.X < b.X;
+        if (a.Y != b.Y) return a.Y < b.Y;
+        return a.Z < b.Z;
+    });
+    positions.erase(std::unique(positions.begin(), positions.end(), [](const vector3df& a, const vector3df& b) {
+        return a.equals(b, FaceOps::POSITION_EPSILON);
+    }), positions.end());
+
+    while (_selectedVertices.size() > positions.size())
+    {
+        _selectedVertices.back()->remove();
+        _selectedVertices.pop_back();
+    }
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        if (i < _selectedVertices.size())
+            _selectedVertices[i]->setPosition(positions[i]);
+        else
+            _selectedVertices.push_back(_createVertexMarker(positions[i]));
+    }
 }
@@ -4,8 +4,24 @@
 #include <cmath>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <string>
 #include "Application.h"
+#include "Types.h"
 #include "helpers/Mesh.h"
+#include "helpers/FaceOps.h"
+#include "helpers/ScratchArena.h"
+#include "helpers/Normals.h"
+#include "helpers/SpatialGrid.h"
+#include "helpers/SoftSelection.h"
+#include "helpers/MeshCleanup.h"
+#include "helpers/UVPack.h"
+#include "helpers/Unwrap.h"
+#include "helpers/TextureAtlas.h"
+#include "helpers/Primitives.h"
+#include "io/ProjectFile.h"
+#include "io/ObjImporter.h"
+#include "io/MeshSnapshot.h"
 
 using namespace irr;
 using namespace core;
@@ -13,17 +29,46 @@ using namespace scene;
 
 class Model {
     public:
+        static constexpr const char* DEFAULT_TEXTURE_PATH = "assets/crate.png";
+        static constexpr const char* ATLAS_TEXTURE_NAME = "#atlas";
+
         Model(Application& application);
         ~Model();
         IMeshSceneNode* GetMesh() { return _mesh; }
         void GenerateDefault();
+        bool CreatePrimitive(PrimitiveType type, const Primitives::Params& params); // Replaces the current mesh
+        // Native project files (.jbx); a loaded mesh is mapped from the file, not copied
+        bool SaveProject(const std::string& path, const ProjectFile::CameraState& camera);
+        bool LoadProject(const std::string& path, ProjectFile::CameraState& camera, bool& hasCamera);
+
+        bool ImportObj(const std::string& path); // Replaces the current mesh
+        std::shared_ptr<const MeshSnapshot> CaptureSnapshot(); // For work on other threads, copy-on-write per buffer
+
         void UpdateMesh(vector3df vertexCurrent, vector3df vertexNew);
+        void RefreshNormals(); // Recomputes normals around vertices moved since the last call
+        MeshCleanup::Report Cleanup(f32 mergeDistance, bool mergeAcrossSeams = false);
+        UVPack::Report PackUVs(const UVPack::Settings& settings); // Rewrites UVs in place
+        Unwrap::Report UnwrapUVs(const UVPack::Settings& settings); // LSCM, then packed
+        TextureAtlas::Report BuildTextureAtlas(const TextureAtlas::Settings& settings); // Replaces the current mesh
 
         // Vertices
         void AddSelectedVertex(vector3df position);
         std::vector<ISceneNode*> GetSelectedVertices();
         void ClearSelectedVertices();
 
+        // Proportional editing (soft selection)
+        void BeginSoftSelection(f32 radius, FalloffCurve curve);
+        void MoveSoftSelection(vector3df delta);
+        void EndSoftSelection();
+        bool IsSoftSelectionActive() { return _softSelectionActive; }
+
+        // Faces
+        void AddSelectedFace(const FaceSelection& face);
+        const std::vector<FaceSelection>& GetSelectedFaces() { return _selectedFaces; }
+        void ClearSelectedFaces();
+        bool ExtrudeSelectedFaces(f32 distance);
+        bool InsetSelectedFaces(f32 amount);
+
         void ClearAll();
     private:
         Application& _application;
@@ -32,4 +77,41 @@ class Model {
 
         // Vertices
         std::vector<ISceneNode*> _selectedVertices;
+
+        // Faces
+        std::vector<FaceSelection> _selectedFaces;
+        ScratchArena _scratch;
+
+        // Soft selection
+        SpatialGrid _vertexGrid;
+        std::vector<SoftSelection::VertexRef> _vertexRefs;
+        std::vector<SoftSelection::Entry> _softSelection;
+        bool _softSelectionActive = false;
+
+        // Normals (per mesh buffer)
+        std::vector<Normals::Topology> _topology;
+        std::vector<std::vector<u32>> _movedVertices;
+
+        // Mapped project backing the current mesh, if it was loaded from disk
+        std::shared_ptr<MappedFile> _mapping;
+
+        // Last capture, the base the next one shares unchanged buffers with
+        std::shared_ptr<const MeshSnapshot> _snapshot;
+
+        // Content hashes of each buffer as last saved or loaded, keyed by
+        // Irrlicht's changed IDs so a save only hashes the edited buffers
+        struct SavedBuffer {
+            const IMeshBuffer* source = nullptr;
+            u32 vertexChangedId = 0;
+            u32 indexChangedId = 0;
+            ProjectFile::BufferHashes hashes;
+        };
+        std::vector<SavedBuffer> _savedBuffers;
+
+        // `materials`, one per buffer, replace the node's; empty keeps its look
+        void _replaceMesh(SMesh* mesh, const std::vector<SMaterial>& materials = {});
+        void _detachMapping();
+        ISceneNode* _createVertexMarker(vector3df position);
+        bool _applyFaceOperator(FaceOps::Operator op, f32 value, const char* name);
+        void _syncFaceSelection();
 };
\ No newline at end of file
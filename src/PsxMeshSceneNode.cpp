@@ -0,0 +1,469 @@
+#include "PsxMeshSceneNode.h"
+#include <cstddef>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+
+// Windows' gl.h stops at OpenGL 1.1
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#define GL_ACTIVE_TEXTURE 0x84E0
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+
+#ifndef _WIN32
+extern "C" void (*glXGetProcAddressARB(const GLubyte* name))();
+#endif
+
+namespace {
+    // The GL 2.0 entry points the preview needs, loaded once a context exists
+    struct GlFunctions {
+        void (APIENTRY* ActiveTexture)(GLenum);
+        void (APIENTRY* GenBuffers)(GLsizei, GLuint*);
+        void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*);
+        void (APIENTRY* BindBuffer)(GLenum, GLuint);
+        void (APIENTRY* BufferData)(GLenum, ptrdiff_t, const void*, GLenum);
+        GLuint (APIENTRY* CreateShader)(GLenum);
+        void (APIENTRY* DeleteShader)(GLuint);
+        void (APIENTRY* ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*);
+        void (APIENTRY* CompileShader)(GLuint);
+        void (APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+        GLuint (APIENTRY* CreateProgram)();
+        void (APIENTRY* DeleteProgram)(GLuint);
+        void (APIENTRY* AttachShader)(GLuint, GLuint);
+        void (APIENTRY* BindAttribLocation)(GLuint, GLuint, const char*);
+        void (APIENTRY* LinkProgram)(GLuint);
+        void (APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+        void (APIENTRY* UseProgram)(GLuint);
+        GLint (APIENTRY* GetUniformLocation)(GLuint, const char*);
+        void (APIENTRY* Uniform1i)(GLint, GLint);
+        void (APIENTRY* Uniform1f)(GLint, GLfloat);
+        void (APIENTRY* Uniform2f)(GLint, GLfloat, GLfloat);
+        void (APIENTRY* VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+        void (APIENTRY* EnableVertexAttribArray)(GLuint);
+        void (APIENTRY* DisableVertexAttribArray)(GLuint);
+        bool loaded = false;
+    };
+
+    GlFunctions gl;
+
+    void* procAddress(const char* name) {
+#ifdef _WIN32
+        return (void*)wglGetProcAddress(name);
+#else
+        return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+    }
+
+    template<class Fn>
+    bool load(Fn& fn, const char* name) {
+        fn = (Fn)procAddress(name);
+        return fn != nullptr;
+    }
+
+    bool loadFunctions() {
+        if (gl.loaded)
+            return true;
+
+        gl.loaded =
+            load(gl.ActiveTexture, "glActiveTexture") &&
+            load(gl.GenBuffers, "glGenBuffers") && load(gl.DeleteBuffers, "glDeleteBuffers") &&
+            load(gl.BindBuffer, "glBindBuffer") && load(gl.BufferData, "glBufferData") &&
+            load(gl.CreateShader, "glCreateShader") && load(gl.DeleteShader, "glDeleteShader") &&
+            load(gl.ShaderSource, "glShaderSource") && load(gl.CompileShader, "glCompileShader") &&
+            load(gl.GetShaderiv, "glGetShaderiv") && load(gl.GetShaderInfoLog, "glGetShaderInfoLog") &&
+            load(gl.CreateProgram, "glCreateProgram") && load(gl.DeleteProgram, "glDeleteProgram") &&
+            load(gl.AttachShader, "glAttachShader") && load(gl.BindAttribLocation, "glBindAttribLocation") &&
+            load(gl.LinkProgram, "glLinkProgram") && load(gl.GetProgramiv, "glGetProgramiv") &&
+            load(gl.GetProgramInfoLog, "glGetProgramInfoLog") && load(gl.UseProgram, "glUseProgram") &&
+            load(gl.GetUniformLocation, "glGetUniformLocation") && load(gl.Uniform1i, "glUniform1i") &&
+            load(gl.Uniform1f, "glUniform1f") && load(gl.Uniform2f, "glUniform2f") &&
+            load(gl.VertexAttribPointer, "glVertexAttribPointer") &&
+            load(gl.EnableVertexAttribArray, "glEnableVertexAttribArray") &&
+            load(gl.DisableVertexAttribArray, "glDisableVertexAttribArray");
+        return gl.loaded;
+    }
+
+    enum Attribute : GLuint { ATTRIBUTE_POSITION = 0, ATTRIBUTE_UV = 1, ATTRIBUTE_COLOR = 2 };
+
+    // Irrlicht has already loaded its view and world matrices into the
+    // fixed-function state, so the compatibility built-ins pick them up
+    const char* VERTEX_SHADER = R"(#version 130
+uniform float uPositionScale;
+uniform vec2 uHalfResolution;
+in vec3 aPosition;
+in vec2 aUV;
+in vec4 aColor;
+noperspective out vec2 vUV;
+out vec4 vColor;
+
+void main() {
+    vec4 clip = gl_ModelViewProjectionMatrix * vec4(aPosition * uPositionScale, 1.0);
+
+    // The GTE output integer screen coordinates: snap to whole pixels
+    if (clip.w > 0.0) {
+        vec2 screen = floor(clip.xy / clip.w * uHalfResolution + 0.5) / uHalfResolution;
+        clip.xy = screen * clip.w;
+    }
+
+    gl_Position = clip;
+    vUV = aUV;
+    vColor = aColor;
+}
+)";
+
+    const char* FRAGMENT_SHADER = R"(#version 130
+uniform sampler2D uTexture;
+uniform float uTextured;
+noperspective in vec2 vUV;
+in vec4 vColor;
+
+void main() {
+    vec4 texel = mix(vec4(1.0), texture(uTexture, vUV), uTextured);
+    vec4 color = texel * vColor;
+    gl_FragColor = vec4(floor(color.rgb * 31.0 + 0.5) / 31.0, color.a);
+}
+)";
+
+    GLuint compile(GLenum type, const char* source) {
+        GLuint shader = gl.CreateShader(type);
+        gl.ShaderSource(shader, 1, &source, nullptr);
+        gl.CompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        gl.GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char log[1024] = {};
+            gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cout << "PSX preview shader failed to compile: " << log << std::endl;
+            gl.DeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+PsxMeshSceneNode::PsxMeshSceneNode(ISceneNode* parent, ISceneManager* smgr, s32 id)
+    : ISceneNode(parent, smgr, id),
+      _fractionBits(PsxQuantize::MAX_FRACTION_BITS),
+      _texture(nullptr),
+      _textureName(0),
+      _program(0),
+      _uniformPositionScale(-1),
+      _uniformHalfResolution(-1),
+      _uniformTextured(-1),
+      _uniformTexture(-1),
+      _failed(false)
+{
+    _material.Lighting = false;
+}
+
+PsxMeshSceneNode::~PsxMeshSceneNode()
+{
+    for (Buffer& buffer : _buffers)
+        _release(buffer);
+    if (_textureName)
+        glDeleteTextures(1, &_textureName);
+    if (_program)
+        gl.DeleteProgram(_program);
+}
+
+void PsxMeshSceneNode::Sync(IMeshSceneNode* source)
+{
+    if (!_initialise())
+        return;
+
+    _transform = source->getAbsoluteTransformation();
+    _material.Wireframe = source->getMaterial(0).Wireframe;
+    _syncTexture(source->getMaterial(0).getTexture(0));
+
+    IMesh* mesh = source->getMesh();
+    std::vector<const IMeshBuffer*> sources;
+    for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+        const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+        if (mb->getVertexType() == EVT_STANDARD && mb->getIndexType() == EIT_16BIT && mb->getVertexCount() > 0)
+            sources.push_back(mb);
+    }
+
+    // One scale for the whole mesh, so buffers line up where they meet
+    aabbox3df bounds;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (i == 0) bounds = sources[i]->getBoundingBox();
+        else bounds.addInternalBox(sources[i]->getBoundingBox());
+    }
+    s32 fractionBits = sources.empty() ? PsxQuantize::MAX_FRACTION_BITS : PsxQuantize::ChooseFractionBits(bounds);
+    bool rescaled = fractionBits != _fractionBits;
+    _fractionBits = fractionBits;
+    _bounds = bounds;
+
+    for (size_t i = sources.size(); i < _buffers.size(); ++i)
+        _release(_buffers[i]);
+    _buffers.resize(sources.size());
+
+    u32 uploaded = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const IMeshBuffer* mb = sources[i];
+        Buffer& buffer = _buffers[i];
+        if (!rescaled &&
+            buffer.source == mb &&
+            buffer.vertexChangedId == mb->getChangedID_Vertex() &&
+            buffer.indexChangedId == mb->getChangedID_Index() &&
+            buffer.vertexCount == mb->getVertexCount())
+            continue;
+
+        _upload(buffer, mb);
+        uploaded++;
+    }
+
+    // Nothing is drawn from the CPU copy, so don't keep one around
+    if (uploaded > 0) {
+        _scratch = PsxQuantize::Buffer();
+    }
+}
+
+u32 PsxMeshSceneNode::GetVertexCount() const
+{
+    u32 count = 0;
+    for (const Buffer& buffer : _buffers)
+        count += buffer.vertexCount;
+    return count;
+}
+
+u64 PsxMeshSceneNode::GetCompactBytes() const
+{
+    u64 bytes = 0;
+    for (const Buffer& buffer : _buffers)
+        bytes += (u64)buffer.vertexCount * sizeof(PsxQuantize::Vertex) + (u64)buffer.indexCount * sizeof(u16);
+    return bytes;
+}
+
+u64 PsxMeshSceneNode::GetFloatBytes() const
+{
+    u64 bytes = 0;
+    for (const Buffer& buffer : _buffers)
+        bytes += (u64)buffer.vertexCount * sizeof(S3DVertex) + (u64)buffer.indexCount * sizeof(u16);
+    return bytes;
+}
+
+void PsxMeshSceneNode::OnRegisterSceneNode()
+{
+    if (IsVisible)
+        SceneManager->registerNodeForRendering(this, ESNRP_SOLID);
+    ISceneNode::OnRegisterSceneNode();
+}
+
+void PsxMeshSceneNode::render()
+{
+    if (!_program || _buffers.empty())
+        return;
+
+    IVideoDriver* driver = SceneManager->getVideoDriver();
+    driver->setTransform(ETS_WORLD, _transform);
+    const dimension2d<u32>& target = driver->getCurrentRenderTargetSize();
+
+    // Leave Irrlicht's cached GL state exactly as it was
+    GLint previousProgram = 0;
+    GLint previousUnit = GL_TEXTURE0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+    gl.ActiveTexture(GL_TEXTURE0);
+    glPushAttrib(GL_ENABLE_BIT | GL_POLYGON_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_LIGHTING);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glPolygonMode(GL_FRONT_AND_BACK, _material.Wireframe ? GL_LINE : GL_FILL);
+    glBindTexture(GL_TEXTURE_2D, _textureName);
+
+    gl.UseProgram(_program);
+    gl.Uniform1f(_uniformPositionScale, 1.0f / PsxQuantize::Scale(_fractionBits));
+    gl.Uniform2f(_uniformHalfResolution, target.Width * 0.5f, target.Height * 0.5f);
+    gl.Uniform1f(_uniformTextured, _textureName ? 1.0f : 0.0f);
+    gl.Uniform1i(_uniformTexture, 0);
+
+    gl.EnableVertexAttribArray(ATTRIBUTE_POSITION);
+    gl.EnableVertexAttribArray(ATTRIBUTE_UV);
+    gl.EnableVertexAttribArray(ATTRIBUTE_COLOR);
+
+    const GLsizei stride = sizeof(PsxQuantize::Vertex);
+    for (const Buffer& buffer : _buffers) {
+        if (buffer.indexCount == 0) continue;
+
+        gl.BindBuffer(GL_ARRAY_BUFFER, buffer.vertexBuffer);
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indexBuffer);
+        gl.VertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_SHORT, GL_FALSE, stride, (const void*)offsetof(PsxQuantize::Vertex, x));
+        gl.VertexAttribPointer(ATTRIBUTE_UV, 2, GL_UNSIGNED_BYTE, GL_TRUE, stride, (const void*)offsetof(PsxQuantize::Vertex, u));
+        gl.VertexAttribPointer(ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (const void*)offsetof(PsxQuantize::Vertex, r));
+        glDrawElements(GL_TRIANGLES, buffer.indexCount, GL_UNSIGNED_SHORT, nullptr);
+    }
+
+    gl.DisableVertexAttribArray(ATTRIBUTE_POSITION);
+    gl.DisableVertexAttribArray(ATTRIBUTE_UV);
+    gl.DisableVertexAttribArray(ATTRIBUTE_COLOR);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    gl.UseProgram((GLuint)previousProgram);
+
+    glPopClientAttrib();
+    glPopAttrib();
+    gl.ActiveTexture((GLenum)previousUnit);
+}
+
+bool PsxMeshSceneNode::_initialise()
+{
+    if (_program)
+        return true;
+    if (_failed)
+        return false;
+    _failed = true;
+
+    if (SceneManager->getVideoDriver()->getDriverType() != EDT_OPENGL || !loadFunctions()) {
+        std::cout << "PSX preview needs the OpenGL 2.0 driver" << std::endl;
+        return false;
+    }
+
+    GLuint vertexShader = compile(GL_VERTEX_SHADER, VERTEX_SHADER);
+    GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (!vertexShader || !fragmentShader) {
+        if (vertexShader) gl.DeleteShader(vertexShader);
+        if (fragmentShader) gl.DeleteShader(fragmentShader);
+        return false;
+    }
+
+    GLuint program = gl.CreateProgram();
+    gl.AttachShader(program, vertexShader);
+    gl.AttachShader(program, fragmentShader);
+    gl.BindAttribLocation(program, ATTRIBUTE_POSITION, "aPosition");
+    gl.BindAttribLocation(program, ATTRIBUTE_UV, "aUV");
+    gl.BindAttribLocation(program, ATTRIBUTE_COLOR, "aColor");
+    gl.LinkProgram(program);
+    gl.DeleteShader(vertexShader);
+    gl.DeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    gl.GetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024] = {};
+        gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cout << "PSX preview shader failed to link: " << log << std::endl;
+        gl.DeleteProgram(program);
+        return false;
+    }
+
+    _program = program;
+    _uniformPositionScale = gl.GetUniformLocation(program, "uPositionScale");
+    _uniformHalfResolution = gl.GetUniformLocation(program, "uHalfResolution");
+    _uniformTextured = gl.GetUniformLocation(program, "uTextured");
+    _uniformTexture = gl.GetUniformLocation(program, "uTexture");
+    _failed = false;
+    return true;
+}
+
+void PsxMeshSceneNode::_upload(Buffer& buffer, const IMeshBuffer* mb)
+{
+    PsxQuantize::QuantizeBuffer(mb, _fractionBits, _scratch);
+
+    if (!buffer.vertexBuffer) {
+        gl.GenBuffers(1, &buffer.vertexBuffer);
+        gl.GenBuffers(1, &buffer.indexBuffer);
+    }
+
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffer.vertexBuffer);
+    gl.BufferData(GL_ARRAY_BUFFER, _scratch.vertices.size() * sizeof(PsxQuantize::Vertex), _scratch.vertices.data(), GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indexBuffer);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, _scratch.indices.size() * sizeof(u16), _scratch.indices.data(), GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    buffer.source = mb;
+    buffer.vertexChangedId = mb->getChangedID_Vertex();
+    buffer.indexChangedId = mb->getChangedID_Index();
+    buffer.vertexCount = (u32)_scratch.vertices.size();
+    buffer.indexCount = (u32)_scratch.indices.size();
+}
+
+void PsxMeshSceneNode::_release(Buffer& buffer)
+{
+    if (buffer.vertexBuffer) {
+        gl.DeleteBuffers(1, &buffer.vertexBuffer);
+        gl.DeleteBuffers(1, &buffer.indexBuffer);
+    }
+    buffer = Buffer();
+}
+
+void PsxMeshSceneNode::_syncTexture(ITexture* texture)
+{
+    if (texture == _texture)
+        return;
+    _texture = texture;
+
+    if (_textureName) {
+        glDeleteTextures(1, &_textureName);
+        _textureName = 0;
+    }
+    if (!texture)
+        return;
+
+    // Irrlicht keeps its GL texture name private, so take a nearest-filtered
+    // copy instead of changing the filtering of the one the editor draws with
+    const dimension2d<u32>& size = texture->getSize();
+    void* pixels = texture->lock(ETLM_READ_ONLY);
+    if (!pixels)
+        return;
+
+    std::vector<u32> argb;
+    if (texture->getColorFormat() != ECF_A8R8G8B8 || texture->getPitch() != size.Width * 4) {
+        IImage* image = SceneManager->getVideoDriver()->createImageFromData(texture->getColorFormat(), size, pixels, true, false);
+        argb.resize(size.Width * size.Height);
+        if (image) {
+            image->copyToScaling(argb.data(), size.Width, size.Height, ECF_A8R8G8B8, size.Width * 4);
+            image->drop();
+        }
+        pixels = argb.data();
+    }
+
+    GLint previousUnit = GL_TEXTURE0;
+    GLint previous = 0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+    gl.ActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    glGenTextures(1, &_textureName);
+    glBindTexture(GL_TEXTURE_2D, _textureName);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.Width, size.Height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+    gl.ActiveTexture((GLenum)previousUnit);
+
+    texture->unlock();
+}
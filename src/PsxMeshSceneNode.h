@@ -0,0 +1,75 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <vector>
+
+#include "helpers/PsxQuantize.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+// Draws a mesh from PsxQuantize's 12-byte vertices, the way a PS1 would:
+// fixed-point positions, vertices snapped to the pixel grid, affine
+// (non perspective-correct) texturing, nearest texels and 15-bit colour.
+//
+// Irrlicht's fixed-function vertex types are all float, so the compact
+// buffers go straight to OpenGL: one VBO/IBO pair per mesh buffer and a
+// small GLSL 1.30 program that widens the fixed-point data on the GPU.
+// Requires the OpenGL driver; on anything else render() does nothing.
+class PsxMeshSceneNode : public ISceneNode {
+public:
+    PsxMeshSceneNode(ISceneNode* parent, ISceneManager* smgr, s32 id = -1);
+    ~PsxMeshSceneNode() override;
+
+    // Re-quantizes the buffers of `source`'s mesh that changed since the last
+    // call (all of them if the mesh grew past the fixed-point range) and
+    // follows its transform and texture. Cheap when nothing changed.
+    void Sync(IMeshSceneNode* source);
+
+    s32 GetFractionBits() const { return _fractionBits; }
+    u32 GetVertexCount() const;
+    u64 GetCompactBytes() const; // Vertex and index data uploaded for drawing
+    u64 GetFloatBytes() const;   // The same data as S3DVertex
+
+    void OnRegisterSceneNode() override;
+    void render() override;
+    const aabbox3df& getBoundingBox() const override { return _bounds; }
+    u32 getMaterialCount() const override { return 1; }
+    SMaterial& getMaterial(u32 /*num*/) override { return _material; }
+
+private:
+    struct Buffer {
+        const IMeshBuffer* source = nullptr;
+        u32 vertexChangedId = 0;
+        u32 indexChangedId = 0;
+        u32 vertexCount = 0;
+        u32 indexCount = 0;
+        u32 vertexBuffer = 0; // GL names
+        u32 indexBuffer = 0;
+    };
+
+    std::vector<Buffer> _buffers;
+    PsxQuantize::Buffer _scratch; // Reused between uploads, only held while syncing
+    s32 _fractionBits;
+    aabbox3df _bounds;
+    matrix4 _transform; // The source node's; this node stays at the origin
+    SMaterial _material;
+
+    // Texture as the preview samples it: nearest filtered, own GL name
+    ITexture* _texture;
+    u32 _textureName;
+
+    u32 _program;
+    s32 _uniformPositionScale;
+    s32 _uniformHalfResolution;
+    s32 _uniformTextured;
+    s32 _uniformTexture;
+    bool _failed; // No GL 2.0 or the shader did not build; stop trying
+
+    bool _initialise();
+    void _upload(Buffer& buffer, const IMeshBuffer* mb);
+    void _release(Buffer& buffer);
+    void _syncTexture(ITexture* texture);
+};
@@ -0,0 +1,87 @@
+#include "ReferenceMeshSceneNode.h"
+#include <algorithm>
+
+#include "helpers/Parallel.h"
+#include "helpers/Profiler.h"
+
+ReferenceMeshSceneNode::ReferenceMeshSceneNode(ISceneNode* parent, ISceneManager* smgr, s32 id)
+    : ISceneNode(parent, smgr, id)
+{
+    _material.Lighting = false;
+}
+
+void ReferenceMeshSceneNode::SetMesh(const IMesh* mesh)
+{
+    std::vector<const IMeshBuffer*> sources;
+    for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+        const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+        if (mb->getVertexType() == EVT_STANDARD && mb->getIndexType() == EIT_16BIT && mb->getVertexCount() > 0)
+            sources.push_back(mb);
+    }
+
+    // Buffers are independent, one task each
+    _buffers.assign(sources.size(), VertexCompression::Buffer());
+    Parallel::For((u32)sources.size(), 1, [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i)
+            VertexCompression::Compress(sources[i], _buffers[i]);
+    });
+
+    size_t largest = 0;
+    for (size_t i = 0; i < _buffers.size(); ++i) {
+        if (i == 0) _bounds = _buffers[i].bounds;
+        else _bounds.addInternalBox(_buffers[i].bounds);
+        largest = std::max(largest, _buffers[i].vertices.size());
+    }
+    _scratch.resize(largest);
+    _scratch.shrink_to_fit();
+}
+
+u32 ReferenceMeshSceneNode::GetVertexCount() const
+{
+    u32 count = 0;
+    for (const VertexCompression::Buffer& buffer : _buffers)
+        count += (u32)buffer.vertices.size();
+    return count;
+}
+
+u64 ReferenceMeshSceneNode::GetBytes() const
+{
+    u64 bytes = _scratch.size() * sizeof(S3DVertex);
+    for (const VertexCompression::Buffer& buffer : _buffers)
+        bytes += buffer.Bytes();
+    return bytes;
+}
+
+u64 ReferenceMeshSceneNode::GetUncompressedBytes() const
+{
+    u64 bytes = 0;
+    for (const VertexCompression::Buffer& buffer : _buffers)
+        bytes += buffer.UncompressedBytes();
+    return bytes;
+}
+
+void ReferenceMeshSceneNode::OnRegisterSceneNode()
+{
+    if (IsVisible && !_buffers.empty())
+        SceneManager->registerNodeForRendering(this, ESNRP_SOLID);
+    ISceneNode::OnRegisterSceneNode();
+}
+
+void ReferenceMeshSceneNode::render()
+{
+    Profiler::Scope scope("Reference decode and draw");
+    IVideoDriver* driver = SceneManager->getVideoDriver();
+    driver->setTransform(ETS_WORLD, AbsoluteTransformation);
+    driver->setMaterial(_material);
+
+    // Irrlicht draws from client memory here (no hardware buffer), so the
+    // scratch array can be refilled as soon as the call returns
+    for (const VertexCompression::Buffer& buffer : _buffers) {
+        if (buffer.indices.empty()) continue;
+
+        const u32 count = (u32)buffer.vertices.size();
+        VertexCompression::Decompress(buffer, _scratch.data());
+        driver->drawVertexPrimitiveList(_scratch.data(), count, buffer.indices.data(),
+                                        (u32)buffer.indices.size() / 3, EVT_STANDARD, EPT_TRIANGLES, EIT_16BIT);
+    }
+}
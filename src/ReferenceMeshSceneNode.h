@@ -0,0 +1,41 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <vector>
+
+#include "helpers/VertexCompression.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+// A mesh that is only looked at, never edited, held in VertexCompression's
+// 12-byte vertices. Nothing full size is kept: each buffer is expanded into
+// one shared scratch array right before it is drawn, so resident memory is
+// about a third of an IMeshSceneNode's while drawing stays on Irrlicht's
+// regular path (any driver, wireframe, the usual materials).
+class ReferenceMeshSceneNode : public ISceneNode {
+public:
+    ReferenceMeshSceneNode(ISceneNode* parent, ISceneManager* smgr, s32 id = -1);
+
+    // Compresses the standard 16-bit buffers of `mesh`; the caller can drop
+    // the mesh afterwards
+    void SetMesh(const IMesh* mesh);
+
+    u32 GetVertexCount() const;
+    u64 GetBytes() const;             // Resident, compressed
+    u64 GetUncompressedBytes() const; // The same buffers as S3DVertex
+
+    void OnRegisterSceneNode() override;
+    void render() override;
+    const aabbox3df& getBoundingBox() const override { return _bounds; }
+    u32 getMaterialCount() const override { return 1; }
+    SMaterial& getMaterial(u32 /*num*/) override { return _material; }
+
+private:
+    std::vector<VertexCompression::Buffer> _buffers;
+    std::vector<S3DVertex> _scratch; // Sized for the largest buffer
+    aabbox3df _bounds;
+    SMaterial _material;
+};
@@ -0,0 +1,228 @@
+#include "ThumbnailBatch.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+
+#include "Camera.h"
+#include "Viewport.h"
+#include "helpers/Profiler.h"
+#include "io/ObjImporter.h"
+#include "io/ProjectFile.h"
+
+namespace {
+    // A three-quarter view like the editor's model camera, unless a project saved one
+    constexpr f32 DEFAULT_THETA = 45.0f;
+    constexpr f32 DEFAULT_PHI = 30.0f;
+    constexpr f32 FRAMING_MARGIN = 1.1f;
+
+    f64 elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string lowerExtension(const std::string& path) {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension;
+    }
+
+    // OpenGL render targets come back bottom row first
+    void flipRows(IImage* image) {
+        u8* pixels = (u8*)image->lock();
+        const u32 pitch = image->getPitch();
+        const u32 height = image->getDimension().Height;
+        std::vector<u8> row(pitch);
+        for (u32 y = 0; y < height / 2; ++y) {
+            u8* top = pixels + y * pitch;
+            u8* bottom = pixels + (height - 1 - y) * pitch;
+            memcpy(row.data(), top, pitch);
+            memcpy(top, bottom, pitch);
+            memcpy(bottom, row.data(), pitch);
+        }
+        image->unlock();
+    }
+}
+
+ThumbnailBatch::ThumbnailBatch(Application& application, const Settings& settings)
+    : _application(application),
+      _settings(settings)
+{
+    _settings.size = core::clamp(_settings.size, MIN_SIZE, MAX_SIZE);
+    _settings.threads = core::clamp(_settings.threads, 1u, MAX_THREADS);
+}
+
+std::vector<ThumbnailBatch::Report> ThumbnailBatch::Run(const std::vector<std::string>& files)
+{
+    std::vector<Report> reports(files.size());
+    if (files.empty())
+        return reports;
+
+    std::error_code error;
+    std::filesystem::create_directories(_settings.directory, error);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Created once for the whole batch: the camera node and render texture are reused
+    Camera camera(_application, vector3df(0, 0, -1), vector3df(0, 0, 0), false);
+    Viewport viewport(_application, camera, ViewportType::MODEL);
+    viewport.UpdateViewport(0, 0, _settings.size, _settings.size);
+    camera.GetCameraSceneNode()->setAspectRatio(1.0f);
+
+    std::deque<std::future<Loaded>> loading;
+    std::deque<std::pair<size_t, std::future<Encoded>>> encoding;
+    size_t nextLoad = 0;
+
+    auto finishEncode = [&]() {
+        Report& report = reports[encoding.front().first];
+        Encoded encoded = encoding.front().second.get();
+        encoding.pop_front();
+        report.written = encoded.written;
+        report.bytes = encoded.bytes;
+        report.encodeMilliseconds = encoded.milliseconds;
+        report.Print();
+    };
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        // Keep the loaders `threads` files ahead of the renderer
+        while (nextLoad < files.size() && loading.size() < _settings.threads) {
+            std::string path = files[nextLoad++];
+            loading.push_back(std::async(std::launch::async, [this, path]() { return _load(path); }));
+        }
+
+        Loaded loaded = loading.front().get();
+        loading.pop_front();
+
+        Report& report = reports[i];
+        report.path = files[i];
+        report.loadMilliseconds = loaded.milliseconds;
+        if (!loaded.mesh) {
+            report.Print();
+            continue;
+        }
+
+        for (u32 b = 0; b < loaded.mesh->getMeshBufferCount(); ++b)
+            report.vertices += loaded.mesh->getMeshBuffer(b)->getVertexCount();
+
+        auto renderStart = std::chrono::steady_clock::now();
+        IImage* image = _render(loaded, camera, viewport);
+        report.renderMilliseconds = elapsedMilliseconds(renderStart);
+        Profiler::Record("Thumbnail render", report.renderMilliseconds);
+
+        loaded.mesh->drop();
+        if (loaded.texture) loaded.texture->drop();
+        loaded.file.reset();
+
+        if (!image) {
+            report.Print();
+            continue;
+        }
+
+        if (encoding.size() >= _settings.threads)
+            finishEncode();
+        std::string output = _outputPath(files[i]);
+        encoding.emplace_back(i, std::async(std::launch::async, [this, image, output]() { return _encode(image, output); }));
+    }
+
+    while (!encoding.empty())
+        finishEncode();
+
+    f64 total = elapsedMilliseconds(start);
+    u32 written = (u32)std::count_if(reports.begin(), reports.end(), [](const Report& r) { return r.written; });
+    std::cout << "Thumbnails: " << written << " of " << files.size() << " written to " << _settings.directory
+              << " in " << total << " ms, " << (total > 0.0 ? files.size() * 1000.0 / total : 0.0)
+              << " files/s (" << _settings.threads << " threads, " << _settings.size << " px)" << std::endl;
+    return reports;
+}
+
+ThumbnailBatch::Loaded ThumbnailBatch::_load(const std::string& path)
+{
+    auto start = std::chrono::steady_clock::now();
+    Loaded loaded;
+    std::string extension = lowerExtension(path);
+
+    if (extension == ".obj") {
+        ObjImporter::Report report;
+        loaded.mesh = ObjImporter::Load(path, report);
+    } else if (extension == ".jbx") {
+        // Creating the texture image only wraps the mapped texels, safe off the main thread
+        ProjectFile::LoadedProject project;
+        if (ProjectFile::Load(path, _application.driver, project)) {
+            loaded.mesh = project.mesh;
+            loaded.texture = project.texture;
+            loaded.file = project.file;
+            loaded.hasCamera = project.hasCamera;
+            loaded.cameraTheta = project.camera.theta;
+            loaded.cameraPhi = project.camera.phi;
+        }
+    } else {
+        std::cout << "Unsupported file: " << path << std::endl;
+    }
+
+    if (loaded.mesh)
+        loaded.mesh->recalculateBoundingBox();
+    loaded.milliseconds = elapsedMilliseconds(start);
+    Profiler::Record("Thumbnail load", loaded.milliseconds);
+    return loaded;
+}
+
+IImage* ThumbnailBatch::_render(Loaded& loaded, Camera& camera, Viewport& viewport)
+{
+    IVideoDriver* driver = _application.driver;
+    IMeshSceneNode* node = _application.smgr->addMeshSceneNode(loaded.mesh);
+    if (!node)
+        return nullptr;
+
+    ITexture* texture = loaded.texture ? driver->addTexture("#thumbnail", loaded.texture) : nullptr;
+    node->setMaterialTexture(0, texture);
+
+    // Centre the model and back the camera off until its bounding sphere fits
+    const aabbox3df& bounds = loaded.mesh->getBoundingBox();
+    node->setPosition(-bounds.getCenter());
+    f32 radius = std::max(bounds.getExtent().getLength() * 0.5f, 0.001f);
+    ICameraSceneNode* cameraNode = camera.GetCameraSceneNode();
+    f32 distance = radius * FRAMING_MARGIN / std::sin(cameraNode->getFOV() * 0.5f);
+    cameraNode->setNearValue(distance * 0.01f);
+    cameraNode->setFarValue(distance + radius * 2.0f);
+    camera.SetOrbit(distance,
+                    loaded.hasCamera ? loaded.cameraTheta : DEFAULT_THETA,
+                    loaded.hasCamera ? loaded.cameraPhi : DEFAULT_PHI);
+
+    // Rendering to a texture needs an open scene but never presents, so the
+    // console device doesn't print every thumbnail to the terminal
+    driver->beginScene(false, false);
+    ITexture* target = viewport.RenderOffscreen(node);
+    IImage* image = target ? driver->createImage(target, position2d<s32>(0, 0), target->getSize()) : nullptr;
+    if (image && driver->getDriverType() == EDT_OPENGL)
+        flipRows(image);
+
+    node->remove();
+    if (texture)
+        driver->removeTexture(texture);
+    return image;
+}
+
+ThumbnailBatch::Encoded ThumbnailBatch::_encode(IImage* image, const std::string& path)
+{
+    // Image writers keep no state between calls, like the loaders TextureCache decodes with
+    auto start = std::chrono::steady_clock::now();
+    Encoded encoded;
+    encoded.written = _application.driver->writeImageToFile(image, path.c_str());
+    image->drop();
+
+    std::error_code error;
+    if (encoded.written)
+        encoded.bytes = std::filesystem::file_size(path, error);
+    encoded.milliseconds = elapsedMilliseconds(start);
+    Profiler::Record("Thumbnail encode", encoded.milliseconds);
+    return encoded;
+}
+
+std::string ThumbnailBatch::_outputPath(const std::string& path) const
+{
+    // Keep the source extension so model.obj and model.jbx don't collide
+    std::string name = std::filesystem::path(path).filename().string() + ".png";
+    return (std::filesystem::path(_settings.directory) / name).string();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Application.h"
+#include "Camera.h"
+#include "Viewport.h"
+#include "io/MappedFile.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+// Renders PNG thumbnails of .obj and .jbx files without the editor, through
+// the MODEL viewport's render-to-texture path. Rendering stays on the main
+// thread; loading the next files and encoding finished images run on up to
+// `threads` workers each, so a batch is bound by whichever stage is slowest.
+class ThumbnailBatch {
+public:
+    struct Settings {
+        u32 size = 128;
+        u32 threads = 2;
+        std::string directory = "thumbnails";
+    };
+
+    struct Report {
+        std::string path;
+        bool written = false;
+        u32 vertices = 0;
+        f64 loadMilliseconds = 0.0;   // On a worker, overlapped with other files
+        f64 renderMilliseconds = 0.0;
+        f64 encodeMilliseconds = 0.0; // On a worker
+        u64 bytes = 0;
+
+        void Print() const {
+            std::cout << "Thumbnail " << path << ": " << (written ? "" : "FAILED, ") << vertices << " vertices, load "
+                      << loadMilliseconds << " ms, render " << renderMilliseconds << " ms, encode "
+                      << encodeMilliseconds << " ms, " << bytes << " bytes" << std::endl;
+        }
+    };
+
+    static constexpr u32 MIN_SIZE = 16;
+    static constexpr u32 MAX_SIZE = 640; // Viewport caps its render texture there
+    static constexpr u32 MAX_THREADS = 16;
+
+    ThumbnailBatch(Application& application, const Settings& settings);
+
+    // One report per file, in order. Needs Application::BeginHeadless (or BeginCore).
+    std::vector<Report> Run(const std::vector<std::string>& files);
+
+private:
+    // Everything a worker prepares so the main thread only has to draw
+    struct Loaded {
+        SMesh* mesh = nullptr;
+        IImage* texture = nullptr;
+        std::shared_ptr<MappedFile> file; // Backs a project's mesh and texture
+        bool hasCamera = false;
+        f32 cameraTheta = 0.0f;
+        f32 cameraPhi = 0.0f;
+        f64 milliseconds = 0.0;
+    };
+
+    struct Encoded {
+        bool written = false;
+        u64 bytes = 0;
+        f64 milliseconds = 0.0;
+    };
+
+    Application& _application;
+    Settings _settings;
+
+    Loaded _load(const std::string& path);
+    IImage* _render(Loaded& loaded, Camera& camera, Viewport& viewport);
+    Encoded _encode(IImage* image, const std::string& path);
+    std::string _outputPath(const std::string& path) const;
+};
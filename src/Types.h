@@ -3,12 +3,33 @@
 #include <irrlicht.h>
 #include <vector>
 
+using namespace irr;
+using namespace core;
+
 enum EditorMode : int {
     VERTEX = 0,
     EDGE = 1,
     FACE = 2
 };
 
+enum FalloffCurve : int {
+    SMOOTH = 0,
+    SPHERE = 1,
+    LINEAR = 2,
+    SHARP = 3,
+    FALLOFF_COUNT = 4
+};
+
+enum PrimitiveType : int {
+    PRIMITIVE_CUBE = 0,
+    PRIMITIVE_SPHERE = 1,
+    PRIMITIVE_CYLINDER = 2,
+    PRIMITIVE_TORUS = 3,
+    PRIMITIVE_PLANE = 4,
+    PRIMITIVE_CONE = 5,
+    PRIMITIVE_COUNT = 6
+};
+
 enum ViewportType : int {
     TOP = 0,
     BOTTOM = 1,
@@ -57,4 +78,8 @@ struct FaceSelection {
     vector3df worldPos3;
     vector3df worldPos4;
     bool isQuad = false;
+
+    // Offsets into the index buffer of the face's triangles (second only if quad)
+    u32 triangleIndex1 = 0;
+    u32 triangleIndex2 = 0;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Viewport.h"
+#include <algorithm>
 
 Viewport::Viewport(Application& application, Camera& camera, ViewportType viewportType)
     :_application(application),
@@ -21,7 +22,7 @@ void Viewport::UpdateViewport(s32 top_left_x, s32 top_left_y, s32 bottom_right_x
     _createRenderTexture();
 }
 
-void Viewport::_createRenderTexture()
+dimension2d<u32> Viewport::GetRenderSize() const
 {
     // Calculate viewport dimensions
     s32 viewportWidth = _viewportSegment.getWidth();
@@ -36,7 +37,12 @@ void Viewport::_createRenderTexture()
         renderWidth = MAX_RENDER_WIDTH;
         renderHeight = (s32)(viewportHeight * scale);
     }
-    
+
+    return dimension2d<u32>(std::max(renderWidth, 0), std::max(renderHeight, 0));
+}
+
+void Viewport::_createRenderTexture()
+{
     // Remove old texture if it exists
     if (_renderTexture) {
         _application.driver->removeTexture(_renderTexture);
@@ -44,7 +50,7 @@ void Viewport::_createRenderTexture()
     
     // Create new render target texture
     _renderTexture = _application.driver->addRenderTargetTexture(
-        dimension2d<u32>(renderWidth, renderHeight),
+        GetRenderSize(),
         "rt",
         ECF_A8R8G8B8
     );
@@ -150,6 +156,12 @@ void Viewport::RenderWireframe(IMeshSceneNode *mesh)
     _drawTextureToViewport();
 }
 
+ITexture* Viewport::RenderOffscreen(IMeshSceneNode* mesh)
+{
+    _renderToTexture(mesh, false);
+    return _renderTexture;
+}
+
 bool Viewport::IsActive(position2di mousePosition)
 {
     return _viewportSegment.isPointInside(mousePosition);
@@ -12,9 +12,11 @@ class Viewport {
         void UpdateViewport(s32 top_left_x, s32 top_left_y, s32 bottom_right_x, s32 bottom_right_y);
         void Render(IMeshSceneNode* mesh);
         void RenderWireframe(IMeshSceneNode* mesh);
+        ITexture* RenderOffscreen(IMeshSceneNode* mesh); // Render texture only, nothing drawn to the screen
         bool IsActive(position2di mousePosition);
         Camera& GetCamera() { return _camera; }
         rect<s32> GetViewportSegment() { return _viewportSegment; }
+        dimension2d<u32> GetRenderSize() const; // Offscreen resolution of the segment
         ViewportType GetViewportType() { return _viewPortType; }
 
     private:
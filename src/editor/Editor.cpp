@@ -1,5 +1,12 @@
 #include "Editor.h"
 #include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+#include "io/MeshExporter.h"
+#include "io/ObjImporter.h"
+#include "helpers/Profiler.h"
 
 const vector3df Editor::CAMERA_LOOKAT = vector3df(0, 0, 0);
 const vector3df Editor::CAMERA_TOP_POS = vector3df(0, 50, 0);
@@ -8,6 +15,18 @@ const vector3df Editor::CAMERA_MODEL_POS = vector3df(10, 10, -10);
 const vector3df Editor::CAMERA_FRONT_POS = vector3df(0, 0, -50);
 const vector3df Editor::CAMERA_RIGHT_POS = vector3df(50, 0, 0);
 
+namespace {
+    const SColor BRUSH_COLORS[] = {
+        SColor(255, 255, 255, 255),
+        SColor(255, 0, 0, 0),
+        SColor(255, 220, 40, 40),
+        SColor(255, 40, 180, 60),
+        SColor(255, 50, 90, 220),
+        SColor(255, 240, 200, 40),
+    };
+    constexpr u32 BRUSH_COLOR_COUNT = sizeof(BRUSH_COLORS) / sizeof(BRUSH_COLORS[0]);
+}
+
 Editor::Editor(Application& application)
     : _application(application),
       _cameraTop(application, CAMERA_TOP_POS, CAMERA_LOOKAT, true),
@@ -20,24 +39,61 @@ Editor::Editor(Application& application)
       _vRight(_application, _cameraRight, ViewportType::RIGHT),
       _activeViewport(nullptr),
       _model(std::make_unique<Model>(_application)),
-      _editorMode(EditorMode::VERTEX)
+      _editorMode(EditorMode::VERTEX),
+      _proportionalEditing(false),
+      _proportionalRadius(PROPORTIONAL_DEFAULT_RADIUS),
+      _falloff(FalloffCurve::SMOOTH),
+      _primitiveDetail(PRIMITIVE_DEFAULT_DETAIL),
+      _psxPreview(nullptr),
+      _psxPreviewEnabled(false),
+      _painter(application),
+      _paintMode(false),
+      _brushColorIndex(0),
+      _strokeHasLast(false)
 {
     // Set the custom up vector for the top camera
     _cameraTop.SetUpVector(CAMERA_TOP_UP);
 
     _setViewports();
     _setupDefaultMesh();
+
+    // Owned by the scene graph; only shown while the model viewport draws
+    _psxPreview = new PsxMeshSceneNode(_application.smgr->getRootSceneNode(), _application.smgr);
+    _psxPreview->setVisible(false);
+    _psxPreview->drop();
+
+    std::vector<u32> palette;
+    for (const SColor& color : BRUSH_COLORS)
+        palette.push_back(color.color);
+    _painter.SetPalette(palette);
 }
 
 Editor::~Editor()
 {
+    _autosave.Wait();
+    _painter.Detach();
+    _psxPreview->remove(); // Frees its GL buffers while the context is still alive
+    for (ReferenceMeshSceneNode* reference : _references)
+        reference->remove();
+    Profiler::Print();
     std::cout << "Shutdown Editor" << std::endl;
 }
 
 void Editor::Draw()
 {
+    _setReferenceWireframe(true);
     _vTop.RenderWireframe(_defaultMesh);
-    _vModel.Render(_defaultMesh);
+    _setReferenceWireframe(false);
+    if (_psxPreviewEnabled) {
+        _defaultMesh->setVisible(false);
+        _psxPreview->setVisible(true);
+        _vModel.Render(nullptr);
+        _psxPreview->setVisible(false);
+        _defaultMesh->setVisible(true);
+    } else {
+        _vModel.Render(_defaultMesh);
+    }
+    _setReferenceWireframe(true);
     _vFront.RenderWireframe(_defaultMesh);
     _vRight.RenderWireframe(_defaultMesh);
     _application.driver->setViewPort(rect<s32>(0, 0, _screenSize.Width, _screenSize.Height));
@@ -45,14 +101,30 @@ void Editor::Draw()
 
 void Editor::Update()
 {
+    _application.textures->Update();
+    _pollExport();
+    _updateAutosave();
     _setViewports();
     _setActiveViewport();
 
-    // Model rotation (unchanged)
-    if (_activeViewport && _activeViewport == &_vModel) {
+    // Model rotation, or painting while paint mode is on. A stroke keeps
+    // going if it wanders out of the model viewport.
+    if (_paintMode) {
+        _attachPaintTexture();
+        if (_application.receiver.MouseState.LeftButtonDown &&
+            (_activeViewport == &_vModel || _painter.IsStroking()))
+            _paint();
+    } else if (_activeViewport && _activeViewport == &_vModel) {
         _activeViewport->GetCamera().Rotate();
     }
 
+    // A drag ends when the button is released
+    if (!_application.receiver.MouseState.LeftButtonDown) {
+        _model->EndSoftSelection();
+        _painter.EndStroke();
+        _strokeHasLast = false;
+    }
+
     // Only process in orthographic viewports
     if (_activeViewport && _activeViewport != &_vModel) {
         
@@ -115,19 +187,37 @@ void Editor::Update()
                 vector3df moveDelta = currentWorldPos - lastWorldPos;
 
                 if (moveDelta.getLengthSQ() > 0.000001f) {
-                    for (ISceneNode* selectedNode : _model->GetSelectedVertices()) {
-                        if (selectedNode) {
-                            vector3df oldPos = selectedNode->getPosition();
-                            vector3df newPos = oldPos + moveDelta;
+                    if (_proportionalEditing) {
+                        // Weights are gathered once per drag, then reused every frame
+                        if (!_model->IsSoftSelectionActive()) {
+                            _model->BeginSoftSelection(_proportionalRadius, _falloff);
+                        }
+                        _model->MoveSoftSelection(moveDelta);
+                    } else {
+                        for (ISceneNode* selectedNode : _model->GetSelectedVertices()) {
+                            if (selectedNode) {
+                                vector3df oldPos = selectedNode->getPosition();
+                                vector3df newPos = oldPos + moveDelta;
 
-                            _model->UpdateMesh(oldPos, newPos);
-                            selectedNode->setPosition(newPos);
+                                _model->UpdateMesh(oldPos, newPos);
+                                selectedNode->setPosition(newPos);
+                            }
                         }
                     }
+
+                    _model->RefreshNormals();
                 }
             }
         }
     }
+
+    // Only buffers edited this frame are re-quantized
+    if (_psxPreviewEnabled) {
+        _psxPreview->Sync(_defaultMesh);
+    }
+
+    // Only the texels painted this frame are uploaded
+    _painter.Flush();
 }
 
 void Editor::ClearVertices()
@@ -135,6 +225,377 @@ void Editor::ClearVertices()
     _model->ClearAll();
 }
 
+void Editor::CleanupMesh()
+{
+    _model->Cleanup(CLEANUP_MERGE_DISTANCE);
+}
+
+void Editor::PackUVs()
+{
+    _model->PackUVs(_uvPackSettings());
+}
+
+void Editor::UnwrapUVs()
+{
+    _model->UnwrapUVs(_uvPackSettings());
+}
+
+void Editor::BuildTextureAtlas()
+{
+    _painter.WriteBack(); // The atlas reads textures back through lock()
+    _model->BuildTextureAtlas(TextureAtlas::Settings());
+}
+
+UVPack::Settings Editor::_uvPackSettings()
+{
+    UVPack::Settings settings;
+    settings.paddingTexels = UV_PACK_PADDING_TEXELS;
+    if (_painter.GetTexture())
+        settings.textureSize = std::min(_painter.GetWidth(), _painter.GetHeight());
+    return settings;
+}
+
+bool Editor::SaveProject(const std::string& path)
+{
+    ProjectFile::CameraState camera = {};
+    _cameraModel.GetOrbit(camera.radius, camera.theta, camera.phi);
+    _painter.WriteBack(); // The project reads the texture back through lock()
+    return _model->SaveProject(path, camera);
+}
+
+bool Editor::LoadProject(const std::string& path)
+{
+    ProjectFile::CameraState camera = {};
+    bool hasCamera = false;
+    if (!_model->LoadProject(path, camera, hasCamera))
+        return false;
+
+    if (hasCamera)
+        _cameraModel.SetOrbit(camera.radius, camera.theta, camera.phi);
+    return true;
+}
+
+bool Editor::OpenFile(const std::string& path)
+{
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if (extension == ".jbx")
+        return LoadProject(path);
+    if (extension == ".obj")
+        return _model->ImportObj(path);
+
+    std::cout << "Unsupported file: " << path << std::endl;
+    return false;
+}
+
+bool Editor::AddReference(const std::string& path)
+{
+    ObjImporter::Report report;
+    SMesh* mesh = ObjImporter::Load(path, report);
+    if (!mesh)
+        return false;
+
+    // Only the normals are needed, so the topology is thrown away with the mesh
+    if (!report.hasNormals) {
+        Normals::Topology topology;
+        for (u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+            Normals::RecalculateAll(mesh->getMeshBuffer(i), topology);
+    }
+
+    ReferenceMeshSceneNode* reference = new ReferenceMeshSceneNode(_application.smgr->getRootSceneNode(), _application.smgr);
+    reference->SetMesh(mesh);
+    reference->drop();
+    mesh->drop();
+    _references.push_back(reference);
+
+    report.Print(("Reference " + path).c_str());
+    std::cout << "Reference memory: " << reference->GetBytes() / 1024 << " KB instead of "
+              << reference->GetUncompressedBytes() / 1024 << " KB" << std::endl;
+    return true;
+}
+
+void Editor::ExportMesh(const std::string& path)
+{
+    if (_exportJob.valid()) {
+        std::cout << "Export already running" << std::endl;
+        return;
+    }
+
+    // Copied on this thread so editing can carry on while the worker writes
+    std::shared_ptr<const MeshSnapshot> snapshot = _model->CaptureSnapshot();
+    if (!snapshot)
+        return;
+
+    _exportJob = std::async(std::launch::async, [snapshot, path]() {
+        MeshExporter::Report report;
+        bool exported = MeshExporter::Export(path, *snapshot, report);
+        if (exported)
+            report.Print(("Exported " + path).c_str());
+        return exported;
+    });
+}
+
+void Editor::TogglePsxPreview()
+{
+    _psxPreviewEnabled = !_psxPreviewEnabled;
+    if (!_psxPreviewEnabled) {
+        std::cout << "PSX PREVIEW OFF" << std::endl;
+        return;
+    }
+
+    _psxPreview->Sync(_defaultMesh);
+    std::cout << "PSX PREVIEW ON (" << _psxPreview->GetVertexCount() << " vertices, "
+              << _psxPreview->GetFractionBits() << " fraction bits, "
+              << _psxPreview->GetCompactBytes() / 1024 << " KB instead of "
+              << _psxPreview->GetFloatBytes() / 1024 << " KB)" << std::endl;
+}
+
+void Editor::TogglePaintMode()
+{
+    _paintMode = !_paintMode;
+    if (!_paintMode) {
+        _painter.EndStroke();
+        _painter.Flush();
+        std::cout << "PAINT MODE OFF" << std::endl;
+        return;
+    }
+
+    _attachPaintTexture();
+    const TiledCanvas& canvas = _painter.GetCanvas();
+    std::cout << "PAINT MODE ON (brush " << _painter.GetBrush().radius << " texels, " << canvas.GetWidth() << "x"
+              << canvas.GetHeight() << " canvas, " << canvas.GetResidentCount() << " of " << canvas.GetTileCount()
+              << " tiles resident, " << _painter.GetCanvasBytes() / 1024 << " KB)" << std::endl;
+}
+
+void Editor::ScaleBrush(f32 factor)
+{
+    Painter::Brush& brush = _painter.GetBrush();
+    brush.radius = core::clamp(brush.radius * factor, Painter::MIN_BRUSH_RADIUS, Painter::MAX_BRUSH_RADIUS);
+    std::cout << "BRUSH RADIUS " << brush.radius << " texels" << std::endl;
+}
+
+void Editor::CycleBrushColor()
+{
+    _brushColorIndex = (_brushColorIndex + 1) % BRUSH_COLOR_COUNT;
+    _painter.GetBrush().color = BRUSH_COLORS[_brushColorIndex];
+    std::cout << "BRUSH COLOUR " << _brushColorIndex << std::endl;
+}
+
+void Editor::CycleBrushMode()
+{
+    static const char* const MODE_NAMES[] = { "BLEND", "REPLACE", "SNAP" };
+    Painter::Brush& brush = _painter.GetBrush();
+    brush.mode = (Painter::BrushMode)(((u32)brush.mode + 1) % (u32)Painter::BrushMode::COUNT);
+    std::cout << "BRUSH MODE " << MODE_NAMES[(u32)brush.mode] << std::endl;
+}
+
+void Editor::UndoPaint()
+{
+    if (_painter.Undo())
+        std::cout << "PAINT UNDO (history " << _painter.GetHistory().GetBytes() / 1024 << " KB)" << std::endl;
+}
+
+void Editor::RedoPaint()
+{
+    if (_painter.Redo())
+        std::cout << "PAINT REDO (history " << _painter.GetHistory().GetBytes() / 1024 << " KB)" << std::endl;
+}
+
+void Editor::CycleTextureMode()
+{
+    _attachPaintTexture();
+    if (!_painter.GetTexture())
+        return;
+
+    const u32 colors = _painter.IsIndexed() ? (u32)_painter.GetClut().size() : 0;
+    if (colors == Painter::CLUT_8BIT) {
+        _painter.ConvertToDirect();
+        std::cout << "TEXTURE DIRECT (" << _painter.GetCanvasBytes() / 1024 << " KB)" << std::endl;
+        return;
+    }
+
+    const u32 next = colors == 0 ? Painter::CLUT_4BIT : Painter::CLUT_8BIT;
+    if (_painter.ConvertToIndexed(next)) {
+        std::cout << "TEXTURE INDEXED, " << next << " COLOURS (" << _painter.GetCanvasBytes() / 1024 << " KB instead of "
+                  << (u64)_painter.GetWidth() * _painter.GetHeight() * 4 / 1024 << " KB)" << std::endl;
+    }
+}
+
+void Editor::RecolorClutEntry()
+{
+    if (!_painter.IsIndexed())
+        return;
+
+    vector2df uv;
+    _paintBuffer.Update(_defaultMesh, _vModel.GetCamera().GetCameraSceneNode(), _vModel.GetRenderSize());
+    if (!_pickPaintUV(_application.receiver.MouseState.Position, uv))
+        return;
+
+    u32 index = _painter.SampleIndex(uv);
+    _painter.SetClutColor(index, _painter.GetBrush().color);
+    std::cout << "CLUT ENTRY " << index << " RECOLOURED" << std::endl;
+}
+
+void Editor::AddPrimitive(PrimitiveType type)
+{
+    Primitives::Params params;
+    params.segments = _primitiveDetail;
+    params.rings = std::max(_primitiveDetail / 2, 2u);
+
+    // Flat shapes take the detail on both axes, cube faces are subdivided more gently
+    if (type == PrimitiveType::PRIMITIVE_PLANE) {
+        params.rings = _primitiveDetail;
+    } else if (type == PrimitiveType::PRIMITIVE_CUBE) {
+        params.segments = std::max(_primitiveDetail / 8, 1u);
+    }
+
+    _model->CreatePrimitive(type, params);
+}
+
+void Editor::ScalePrimitiveDetail(f32 factor)
+{
+    _primitiveDetail = core::clamp((u32)(_primitiveDetail * factor + 0.5f), PRIMITIVE_MIN_DETAIL, PRIMITIVE_MAX_DETAIL);
+    std::cout << "Primitive detail: " << _primitiveDetail << std::endl;
+}
+
+void Editor::ToggleProportionalEditing()
+{
+    _proportionalEditing = !_proportionalEditing;
+    std::cout << "PROPORTIONAL EDITING " << (_proportionalEditing ? "ON" : "OFF")
+              << " (radius " << _proportionalRadius << ", " << SoftSelection::FalloffName(_falloff) << ")" << std::endl;
+}
+
+void Editor::ScaleProportionalRadius(f32 factor)
+{
+    _proportionalRadius = core::clamp(_proportionalRadius * factor, PROPORTIONAL_MIN_RADIUS, PROPORTIONAL_MAX_RADIUS);
+    std::cout << "Proportional radius: " << _proportionalRadius << std::endl;
+
+    // Re-gather mid-drag so the new radius applies immediately
+    if (_model->IsSoftSelectionActive()) {
+        _model->BeginSoftSelection(_proportionalRadius, _falloff);
+    }
+}
+
+void Editor::CycleFalloff()
+{
+    _falloff = (FalloffCurve)((_falloff + 1) % FalloffCurve::FALLOFF_COUNT);
+    std::cout << "Proportional falloff: " << SoftSelection::FalloffName(_falloff) << std::endl;
+}
+
+void Editor::ExtrudeFaces()
+{
+    if (_editorMode != EditorMode::FACE) return;
+    _model->ExtrudeSelectedFaces(EXTRUDE_DISTANCE);
+}
+
+void Editor::InsetFaces()
+{
+    if (_editorMode != EditorMode::FACE) return;
+    _model->InsetSelectedFaces(INSET_AMOUNT);
+}
+
+void Editor::_pollExport()
+{
+    if (_exportJob.valid() && _exportJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        _exportJob.get();
+}
+
+void Editor::_updateAutosave()
+{
+    _autosave.Poll();
+
+    // Mid-drag the mesh is in flux, save once the gesture is finished
+    if (!_autosave.IsDue() || _application.receiver.MouseState.LeftButtonDown)
+        return;
+
+    std::shared_ptr<const MeshSnapshot> snapshot;
+    {
+        Profiler::Scope scope("Autosave snapshot");
+        snapshot = _model->CaptureSnapshot();
+    }
+
+    ProjectFile::CameraState camera = {};
+    _cameraModel.GetOrbit(camera.radius, camera.theta, camera.phi);
+    _autosave.Start(snapshot, camera);
+}
+
+void Editor::_setReferenceWireframe(bool wireframe)
+{
+    for (ReferenceMeshSceneNode* reference : _references)
+        reference->getMaterial(0).Wireframe = wireframe;
+}
+
+bool Editor::_pickPaintUV(const position2di& position, vector2df& uv)
+{
+    UVBuffer::Hit hit;
+    if (!_vModel.IsActive(position) || !_paintBuffer.Lookup(position, _vModel.GetViewportSegment(), hit))
+        return false;
+
+    uv = hit.uv;
+    return true;
+}
+
+void Editor::_paint()
+{
+    Profiler::Scope scope("Paint stroke");
+    Painter::Brush& brush = _painter.GetBrush();
+    const vector2df texels((f32)_painter.GetWidth(), (f32)_painter.GetHeight());
+
+    // Only re-rasterised when the camera or the mesh moved since last frame
+    _paintBuffer.Update(_defaultMesh, _vModel.GetCamera().GetCameraSceneNode(), _vModel.GetRenderSize());
+
+    // Every sample since the last frame, not just the newest position
+    for (const JuiceBoxEventListener::SMouseSample& sample : _application.receiver.MouseSamples) {
+        vector2df uv;
+        if (!_pickPaintUV(sample.Position, uv)) {
+            _strokeHasLast = false;
+            continue;
+        }
+
+        if (!_painter.IsStroking()) {
+            // Replacing recolours whatever the stroke started on
+            if (brush.mode == Painter::BrushMode::REPLACE)
+                brush.target = _painter.Sample(uv);
+            _painter.BeginStroke(brush);
+        }
+
+        // The screen segment only maps to a texel segment when its middle
+        // lands near the middle in UV too; otherwise it crosses a seam, a
+        // silhouette or another part of the mesh and the stroke restarts
+        bool connect = _strokeHasLast;
+        if (connect && sample.Position.getDistanceFromSQ(_strokeLastPosition) > STROKE_CHECK_PIXELS * STROKE_CHECK_PIXELS) {
+            vector2df middleUV;
+            position2di middle = (sample.Position + _strokeLastPosition) / 2;
+            if (_pickPaintUV(middle, middleUV)) {
+                vector2df offset = (middleUV - (uv + _strokeLastUV) * 0.5f) * texels;
+                f32 tolerance = std::max(brush.radius, STROKE_MIN_SEAM_TEXELS);
+                connect = offset.getLengthSQ() <= tolerance * tolerance;
+            } else {
+                connect = false;
+            }
+        }
+
+        _painter.StrokeTo(uv, connect);
+        _strokeHasLast = true;
+        _strokeLastPosition = sample.Position;
+        _strokeLastUV = uv;
+    }
+}
+
+void Editor::_attachPaintTexture()
+{
+    // Follows texture swaps (project loads, the cache replacing its placeholder)
+    ITexture* texture = _defaultMesh->getMaterial(0).getTexture(0);
+    if (texture == _painter.GetTexture() || _application.textures->IsPlaceholder(texture))
+        return;
+
+    if (texture)
+        _painter.Attach(texture);
+    else
+        _painter.Detach();
+}
+
 void Editor::_setupDefaultMesh()
 {
     _model->GenerateDefault();
@@ -213,6 +674,8 @@ void Editor::_setFaceSelection()
     );
 
     if (selection.isSelected) {
+        _model->AddSelectedFace(selection);
+
         if (selection.isQuad) {
             _model->AddSelectedVertex(selection.worldPos1);
             _model->AddSelectedVertex(selection.worldPos2);
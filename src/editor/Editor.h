@@ -2,14 +2,21 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <future>
 
 #include "Application.h"
 #include "Camera.h"
 #include "Viewport.h"
 #include "Model.h"
+#include "PsxMeshSceneNode.h"
+#include "ReferenceMeshSceneNode.h"
 #include "Types.h"
+#include "painter/Painter.h"
+#include "painter/UVBuffer.h"
 #include "utility/UVertex.h"
 #include "helpers/Mesh.h"
+#include "io/Autosave.h"
 
 using namespace irr;
 using namespace core;
@@ -28,6 +35,64 @@ public:
 
     void ClearVertices();
     void ChangeMode(EditorMode mode) { _editorMode = mode; }
+
+    // Proportional editing
+    void ToggleProportionalEditing();
+    void ScaleProportionalRadius(f32 factor);
+    void CycleFalloff();
+
+    // Face operators (act on the current face selection)
+    void ExtrudeFaces();
+    void InsetFaces();
+
+    // Merge by distance, drop degenerate triangles and unused vertices
+    void CleanupMesh();
+
+    // Repacks the UV islands into the unit square, sized for the painted texture
+    void PackUVs();
+    // New UVs from the surface (LSCM per island), then packed like PackUVs
+    void UnwrapUVs();
+    // One atlas for the model's textures, then buffers that now match are merged
+    void BuildTextureAtlas();
+
+    // Project files (F5/F9 use PROJECT_PATH)
+    static constexpr const char* PROJECT_PATH = "project.jbx";
+    bool SaveProject(const std::string& path);
+    bool LoadProject(const std::string& path);
+    bool OpenFile(const std::string& path); // .jbx projects or .obj meshes
+
+    // View-only .obj meshes next to the edited one, held compressed
+    bool AddReference(const std::string& path);
+
+    // Export (.obj, .ply or .psx) runs on a worker thread from a snapshot
+    static constexpr const char* EXPORT_OBJ_PATH = "export.obj";
+    static constexpr const char* EXPORT_PLY_PATH = "export.ply";
+    static constexpr const char* EXPORT_PSX_PATH = "export.psx";
+    void ExportMesh(const std::string& path);
+
+    // Model viewport draws the compact PSX format instead of the float mesh
+    void TogglePsxPreview();
+
+    // Paint mode: the left button paints the model's texture in the model
+    // viewport instead of orbiting the camera
+    void TogglePaintMode();
+    void ScaleBrush(f32 factor);
+    void CycleBrushColor();
+    void CycleBrushMode(); // Blend, replace the colour under the stroke start, snap to palette
+    void UndoPaint();
+    void RedoPaint();
+
+    // Texture storage: direct ARGB -> 16 colour CLUT -> 256 colour CLUT
+    void CycleTextureMode();
+    // Sets the CLUT entry under the mouse to the brush colour
+    void RecolorClutEntry();
+
+    // Autosave runs from Update; interval 0 turns it off
+    void ConfigureAutosave(const Autosave::Settings& settings) { _autosave.Configure(settings); }
+
+    // Primitives replace the current mesh; detail sets the tessellation
+    void AddPrimitive(PrimitiveType type);
+    void ScalePrimitiveDetail(f32 factor);
     
 private:
     Application& _application;
@@ -52,6 +117,27 @@ private:
     static const vector3df CAMERA_FRONT_POS;
     static const vector3df CAMERA_RIGHT_POS;
 
+    // Face operator constants
+    static constexpr f32 EXTRUDE_DISTANCE = 2.0f;
+    static constexpr f32 INSET_AMOUNT = 0.3f;
+    static constexpr f32 CLEANUP_MERGE_DISTANCE = 0.001f;
+    static constexpr f32 UV_PACK_PADDING_TEXELS = 2.0f;
+
+    // Primitive constants
+    static constexpr u32 PRIMITIVE_DEFAULT_DETAIL = 32;
+    static constexpr u32 PRIMITIVE_MIN_DETAIL = 4;
+    static constexpr u32 PRIMITIVE_MAX_DETAIL = 512;
+
+    // Proportional editing constants
+    static constexpr f32 PROPORTIONAL_DEFAULT_RADIUS = 4.0f;
+    static constexpr f32 PROPORTIONAL_MIN_RADIUS = 0.1f;
+    static constexpr f32 PROPORTIONAL_MAX_RADIUS = 100.0f;
+
+    // Stroke constants: samples further apart than this are checked for UV
+    // seams before stamps are laid between them
+    static constexpr s32 STROKE_CHECK_PIXELS = 3;
+    static constexpr f32 STROKE_MIN_SEAM_TEXELS = 2.0f;
+
     // Camera and Viewports
     Camera _cameraTop;
     Camera _cameraModel;
@@ -67,4 +153,41 @@ private:
     std::unique_ptr<Model> _model;
 
     EditorMode _editorMode;
+
+    // Proportional editing
+    bool _proportionalEditing;
+    f32 _proportionalRadius;
+    FalloffCurve _falloff;
+
+    // Primitives
+    u32 _primitiveDetail;
+
+    // Background export, polled from Update
+    std::future<bool> _exportJob;
+    void _pollExport();
+
+    // Autosave: snapshot here, written on a worker
+    Autosave _autosave;
+    void _updateAutosave();
+
+    // Reference meshes, owned by the scene graph
+    std::vector<ReferenceMeshSceneNode*> _references;
+    void _setReferenceWireframe(bool wireframe);
+
+    // PSX preview, kept in sync with the mesh while it is on
+    PsxMeshSceneNode* _psxPreview;
+    bool _psxPreviewEnabled;
+
+    // Texture painting, uploads flushed once per frame from Update
+    Painter _painter;
+    UVBuffer _paintBuffer; // Model viewport's face IDs, for brush samples
+    bool _paintMode;
+    u32 _brushColorIndex;
+    bool _strokeHasLast; // The previous sample hit the mesh
+    position2di _strokeLastPosition;
+    vector2df _strokeLastUV;
+    void _paint();
+    bool _pickPaintUV(const position2di& position, vector2df& uv);
+    void _attachPaintTexture();
+    UVPack::Settings _uvPackSettings();
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "helpers/Profiler.h"
+
+using namespace irr;
+
+// Startup timeline. Start() is the first thing main does, each Phase() ends
+// the phase running since the previous mark, and FirstFrame() closes the
+// timeline once a frame is on screen and prints it. Main thread only.
+namespace BootProfiler {
+    struct Mark {
+        std::string name;
+        f64 milliseconds; // Length of the phase
+    };
+
+    namespace detail {
+        struct State {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point last = start;
+            std::vector<Mark> marks;
+            bool finished = false;
+        };
+
+        inline State& Get() {
+            static State state;
+            return state;
+        }
+
+        inline f64 Since(std::chrono::steady_clock::time_point point) {
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - point).count();
+        }
+    }
+
+    inline void Start() {
+        detail::State& state = detail::Get();
+        state = detail::State();
+    }
+
+    inline void Phase(const char* name) {
+        detail::State& state = detail::Get();
+        if (state.finished)
+            return;
+
+        state.marks.push_back({ name, detail::Since(state.last) });
+        state.last = std::chrono::steady_clock::now();
+        Profiler::Record((std::string("Boot: ") + name).c_str(), state.marks.back().milliseconds);
+    }
+
+    // Call after every presented frame; only the first one counts
+    inline void FirstFrame() {
+        detail::State& state = detail::Get();
+        if (state.finished)
+            return;
+
+        Phase("First frame");
+        state.finished = true;
+        f64 total = detail::Since(state.start);
+        Profiler::Record("Boot: time to first frame", total);
+
+        std::cout << "Boot timeline:" << std::endl;
+        for (const Mark& mark : state.marks) {
+            std::cout << "  " << std::left << std::setw(24) << mark.name << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(9) << mark.milliseconds << " ms"
+                      << std::defaultfloat << std::endl;
+        }
+        std::cout << "  " << std::left << std::setw(24) << "Time to first frame" << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(9) << total << " ms" << std::defaultfloat << std::endl;
+    }
+}
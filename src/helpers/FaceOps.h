@@ -0,0 +1,413 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <algorithm>
+
+#include "Types.h"
+#include "helpers/ScratchArena.h"
+#include "helpers/KeyTable.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Face operators (extrude, inset) that work on a whole face selection at once.
+// Every operator follows the same shape:
+//   1. build its lookup tables in the scratch arena
+//   2. count exactly how many vertices and indices it will add
+//   3. reserve the mesh buffer once and append everything
+namespace FaceOps {
+    inline constexpr f32 POSITION_EPSILON = 0.001f;
+    inline constexpr u32 NONE = 0xFFFFFFFF;
+    inline constexpr u32 MAX_VERTICES = 65535; // SMeshBuffer uses 16-bit indices
+
+    struct Result {
+        bool success = false;
+        u32 facesProcessed = 0;
+        u32 verticesAdded = 0;
+        u32 indicesAdded = 0;
+    };
+
+    // Signature shared by the operators so callers can apply any of them per buffer
+    typedef Result (*Operator)(SMeshBuffer*, const FaceSelection*, u32, f32, ScratchArena&);
+
+    inline s32 Quantize(f32 value) {
+        return (s32)std::floor(value / POSITION_EPSILON + 0.5f);
+    }
+
+    inline u32 FindOrInsertPosition(KeyTable& table, const vector3df& pos, bool& inserted) {
+        return table.FindOrInsert(Quantize(pos.X), Quantize(pos.Y), Quantize(pos.Z), inserted);
+    }
+
+    // Flattens the faces into a sorted, de-duplicated list of triangle offsets
+    inline u32 CollectTriangles(
+        const SMeshBuffer* buffer,
+        const FaceSelection* faces,
+        u32 faceCount,
+        ScratchArena& arena,
+        u32*& outTriangles
+    ) {
+        u32 indexCount = buffer->Indices.size();
+        outTriangles = arena.Alloc<u32>(faceCount * 2);
+        u32 count = 0;
+
+        for (u32 f = 0; f < faceCount; ++f) {
+            u32 offsets[2] = { faces[f].triangleIndex1, faces[f].triangleIndex2 };
+            u32 triangles = faces[f].isQuad ? 2 : 1;
+            for (u32 t = 0; t < triangles; ++t) {
+                if (offsets[t] % 3 == 0 && offsets[t] + 2 < indexCount) {
+                    outTriangles[count++] = offsets[t];
+                }
+            }
+        }
+
+        std::sort(outTriangles, outTriangles + count);
+        return (u32)(std::unique(outTriangles, outTriangles + count) - outTriangles);
+    }
+
+    // Extrudes the selection as one region along the averaged face normals.
+    // Faces keep their triangle offsets, so the selection stays valid afterwards.
+    inline Result Extrude(
+        SMeshBuffer* buffer,
+        const FaceSelection* faces,
+        u32 faceCount,
+        f32 distance,
+        ScratchArena& arena
+    ) {
+        Result result;
+        if (!buffer || faceCount == 0) return result;
+
+        u32* triangles = nullptr;
+        u32 triangleCount = CollectTriangles(buffer, faces, faceCount, arena, triangles);
+        if (triangleCount == 0) return result;
+
+        const u32 vertexCount = buffer->Vertices.size();
+        const u32 indexCount = buffer->Indices.size();
+        const u16* indices = buffer->Indices.const_pointer();
+        const S3DVertex* vertices = buffer->Vertices.const_pointer();
+
+        // 1. Mark selected triangles and the vertices they use
+        u8* triangleSelected = arena.AllocFilled<u8>(indexCount / 3, 0);
+        u8* vertexSelected = arena.AllocFilled<u8>(vertexCount, 0);
+        for (u32 t = 0; t < triangleCount; ++t) {
+            triangleSelected[triangles[t] / 3] = 1;
+            for (u32 k = 0; k < 3; ++k) vertexSelected[indices[triangles[t] + k]] = 1;
+        }
+
+        // Selected vertices also used by unselected triangles must be duplicated
+        u8* vertexShared = arena.AllocFilled<u8>(vertexCount, 0);
+        for (u32 i = 0; i < indexCount; i += 3) {
+            if (triangleSelected[i / 3]) continue;
+            for (u32 k = 0; k < 3; ++k) {
+                if (vertexSelected[indices[i + k]]) vertexShared[indices[i + k]] = 1;
+            }
+        }
+
+        // 2. Weld selected vertices by position and average the face normals
+        u32* positionId = arena.AllocFilled<u32>(vertexCount, NONE);
+        vector3df* direction = arena.Alloc<vector3df>(triangleCount * 3);
+        KeyTable positions;
+        positions.Init(arena, triangleCount * 3);
+
+        for (u32 t = 0; t < triangleCount; ++t) {
+            const u16* tri = indices + triangles[t];
+            for (u32 k = 0; k < 3; ++k) {
+                if (positionId[tri[k]] != NONE) continue;
+                bool inserted = false;
+                u32 id = FindOrInsertPosition(positions, vertices[tri[k]].Pos, inserted);
+                if (inserted) direction[id] = vector3df(0, 0, 0);
+                positionId[tri[k]] = id;
+            }
+
+            // Weighted by corner angle so a quad counts the same however it is triangulated
+            vector3df normal = (vertices[tri[1]].Pos - vertices[tri[0]].Pos).crossProduct(
+                vertices[tri[2]].Pos - vertices[tri[0]].Pos);
+            if (normal.getLengthSQ() <= 0.0f) continue;
+            normal.normalize();
+
+            for (u32 k = 0; k < 3; ++k) {
+                vector3df toNext = vertices[tri[(k + 1) % 3]].Pos - vertices[tri[k]].Pos;
+                vector3df toPrev = vertices[tri[(k + 2) % 3]].Pos - vertices[tri[k]].Pos;
+                f32 angle = acosf(core::clamp(toNext.normalize().dotProduct(toPrev.normalize()), -1.0f, 1.0f));
+                direction[positionId[tri[k]]] += normal * angle;
+            }
+        }
+        for (u32 p = 0; p < positions.count; ++p) direction[p].normalize();
+
+        // 3. Boundary edges are welded edges used by exactly one selected triangle
+        KeyTable edges;
+        edges.Init(arena, triangleCount * 3);
+        u32* edgeUses = arena.Alloc<u32>(triangleCount * 3);
+        u32* edgeFrom = arena.Alloc<u32>(triangleCount * 3);
+        u32* edgeTo = arena.Alloc<u32>(triangleCount * 3);
+
+        for (u32 t = 0; t < triangleCount; ++t) {
+            const u16* tri = indices + triangles[t];
+            for (u32 e = 0; e < 3; ++e) {
+                u32 a = tri[e];
+                u32 b = tri[(e + 1) % 3];
+                u32 pa = positionId[a], pb = positionId[b];
+                if (pa == pb) continue;
+
+                bool inserted = false;
+                u32 id = edges.FindOrInsert((s32)core::min_(pa, pb), (s32)core::max_(pa, pb), 0, inserted);
+                if (inserted) {
+                    edgeUses[id] = 1;
+                    edgeFrom[id] = a;
+                    edgeTo[id] = b;
+                } else {
+                    edgeUses[id]++;
+                }
+            }
+        }
+
+        u32 boundaryCount = 0;
+        for (u32 e = 0; e < edges.count; ++e) {
+            if (edgeUses[e] == 1) boundaryCount++;
+        }
+
+        u32 duplicateCount = 0;
+        for (u32 v = 0; v < vertexCount; ++v) {
+            if (vertexSelected[v] && vertexShared[v]) duplicateCount++;
+        }
+
+        // 4. Exact growth, checked against the 16-bit index limit before touching the buffer
+        u32 newVertices = duplicateCount + boundaryCount * 4;
+        u32 newIndices = boundaryCount * 6;
+        if (vertexCount + newVertices > MAX_VERTICES) return result;
+
+        buffer->Vertices.reallocate(vertexCount + newVertices);
+        buffer->Indices.reallocate(indexCount + newIndices);
+
+        // 5. Side walls, built from the original positions
+        for (u32 e = 0; e < edges.count; ++e) {
+            if (edgeUses[e] != 1) continue;
+
+            S3DVertex a = buffer->Vertices[edgeFrom[e]];
+            S3DVertex b = buffer->Vertices[edgeTo[e]];
+            vector3df aTop = a.Pos + direction[positionId[edgeFrom[e]]] * distance;
+            vector3df bTop = b.Pos + direction[positionId[edgeTo[e]]] * distance;
+
+            vector3df normal = (b.Pos - a.Pos).crossProduct(aTop - a.Pos);
+            if (normal.getLengthSQ() < ROUNDING_ERROR_f32) normal = a.Normal;
+            normal.normalize();
+
+            u16 base = (u16)buffer->Vertices.size();
+            buffer->Vertices.push_back(S3DVertex(a.Pos, normal, a.Color, vector2df(0, 1)));
+            buffer->Vertices.push_back(S3DVertex(b.Pos, normal, b.Color, vector2df(1, 1)));
+            buffer->Vertices.push_back(S3DVertex(bTop, normal, b.Color, vector2df(1, 0)));
+            buffer->Vertices.push_back(S3DVertex(aTop, normal, a.Color, vector2df(0, 0)));
+
+            // Same winding as the source face so the wall faces outward
+            buffer->Indices.push_back(base);
+            buffer->Indices.push_back(base + 1);
+            buffer->Indices.push_back(base + 2);
+            buffer->Indices.push_back(base);
+            buffer->Indices.push_back(base + 2);
+            buffer->Indices.push_back(base + 3);
+        }
+
+        // 6. Cap: move unshared vertices in place, duplicate the shared ones
+        u32* capIndex = arena.AllocFilled<u32>(vertexCount, NONE);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            if (!vertexSelected[v]) continue;
+
+            vector3df offset = direction[positionId[v]] * distance;
+            if (vertexShared[v]) {
+                S3DVertex copy = buffer->Vertices[v];
+                copy.Pos += offset;
+                capIndex[v] = buffer->Vertices.size();
+                buffer->Vertices.push_back(copy);
+            } else {
+                buffer->Vertices[v].Pos += offset;
+                capIndex[v] = v;
+            }
+        }
+
+        u16* writeIndices = buffer->Indices.pointer();
+        for (u32 t = 0; t < triangleCount; ++t) {
+            for (u32 k = 0; k < 3; ++k) {
+                u16& index = writeIndices[triangles[t] + k];
+                index = (u16)capIndex[index];
+            }
+        }
+
+        buffer->recalculateBoundingBox();
+        buffer->setDirty(EBT_VERTEX_AND_INDEX);
+
+        result.success = true;
+        result.facesProcessed = triangleCount;
+        result.verticesAdded = newVertices;
+        result.indicesAdded = newIndices;
+        return result;
+    }
+
+    // Per-face layout gathered before inset writes anything
+    struct InsetFace {
+        u32 triangles[2];
+        u32 triangleCount;
+        u32 vertices[6];
+        u32 vertexCount;
+        u32 edgeFrom[6];
+        u32 edgeTo[6];
+        u32 edgeCount;
+    };
+
+    // Insets every selected face individually toward its centre.
+    // `amount` is the fraction of the way to the centre (0 = none, 1 = collapse).
+    inline Result Inset(
+        SMeshBuffer* buffer,
+        const FaceSelection* faces,
+        u32 faceCount,
+        f32 amount,
+        ScratchArena& arena
+    ) {
+        Result result;
+        if (!buffer || faceCount == 0) return result;
+
+        const u32 vertexCount = buffer->Vertices.size();
+        const u32 indexCount = buffer->Indices.size();
+        const u16* indices = buffer->Indices.const_pointer();
+        const S3DVertex* vertices = buffer->Vertices.const_pointer();
+
+        // Skip faces selected more than once
+        u8* triangleUsed = arena.AllocFilled<u8>(indexCount / 3, 0);
+
+        // 1. Gather every face's vertices and boundary edges
+        InsetFace* layouts = arena.Alloc<InsetFace>(faceCount);
+        u32 layoutCount = 0;
+        u32 newVertices = 0;
+        u32 newIndices = 0;
+
+        for (u32 f = 0; f < faceCount; ++f) {
+            InsetFace& face = layouts[layoutCount];
+            face.triangleCount = 0;
+            face.vertexCount = 0;
+            face.edgeCount = 0;
+
+            u32 offsets[2] = { faces[f].triangleIndex1, faces[f].triangleIndex2 };
+            u32 triangles = faces[f].isQuad ? 2 : 1;
+            for (u32 t = 0; t < triangles; ++t) {
+                u32 offset = offsets[t];
+                if (offset % 3 != 0 || offset + 2 >= indexCount || triangleUsed[offset / 3]) continue;
+                triangleUsed[offset / 3] = 1;
+                face.triangles[face.triangleCount++] = offset;
+            }
+            if (face.triangleCount == 0) continue;
+
+            // Directed edges of the face; an edge whose reverse is also present is internal
+            u32 from[6], to[6], edgeTotal = 0;
+            for (u32 t = 0; t < face.triangleCount; ++t) {
+                const u16* tri = indices + face.triangles[t];
+                for (u32 k = 0; k < 3; ++k) {
+                    u32 v = tri[k];
+                    bool known = false;
+                    for (u32 i = 0; i < face.vertexCount; ++i) known |= face.vertices[i] == v;
+                    if (!known) face.vertices[face.vertexCount++] = v;
+
+                    from[edgeTotal] = v;
+                    to[edgeTotal] = tri[(k + 1) % 3];
+                    edgeTotal++;
+                }
+            }
+
+            for (u32 e = 0; e < edgeTotal; ++e) {
+                bool internal = false;
+                for (u32 o = 0; o < edgeTotal; ++o) {
+                    if (o == e) continue;
+                    internal |= vertices[from[e]].Pos.equals(vertices[to[o]].Pos, POSITION_EPSILON) &&
+                                vertices[to[e]].Pos.equals(vertices[from[o]].Pos, POSITION_EPSILON);
+                }
+                if (!internal) {
+                    face.edgeFrom[face.edgeCount] = from[e];
+                    face.edgeTo[face.edgeCount] = to[e];
+                    face.edgeCount++;
+                }
+            }
+
+            newVertices += face.vertexCount;
+            newIndices += face.edgeCount * 6;
+            layoutCount++;
+        }
+
+        if (layoutCount == 0 || vertexCount + newVertices > MAX_VERTICES) return result;
+
+        // 2. One reserve per buffer, then append
+        buffer->Vertices.reallocate(vertexCount + newVertices);
+        buffer->Indices.reallocate(indexCount + newIndices);
+
+        for (u32 f = 0; f < layoutCount; ++f) {
+            const InsetFace& face = layouts[f];
+
+            // Centre of the face, counting positions shared by both triangles once
+            vector3df centre(0, 0, 0);
+            vector2df centreUV(0, 0);
+            u32 unique = 0;
+            for (u32 i = 0; i < face.vertexCount; ++i) {
+                const S3DVertex& v = buffer->Vertices[face.vertices[i]];
+                bool seen = false;
+                for (u32 j = 0; j < i; ++j) {
+                    seen |= buffer->Vertices[face.vertices[j]].Pos.equals(v.Pos, POSITION_EPSILON);
+                }
+                if (seen) continue;
+                centre += v.Pos;
+                centreUV += v.TCoords;
+                unique++;
+            }
+            centre /= (f32)unique;
+            centreUV = centreUV / (f32)unique;
+
+            // Inner copies of the face vertices
+            u32 inner[6];
+            for (u32 i = 0; i < face.vertexCount; ++i) {
+                S3DVertex v = buffer->Vertices[face.vertices[i]];
+                v.Pos = v.Pos + (centre - v.Pos) * amount;
+                v.TCoords = v.TCoords + (centreUV - v.TCoords) * amount;
+                inner[i] = buffer->Vertices.size();
+                buffer->Vertices.push_back(v);
+            }
+
+            auto innerOf = [&](u32 vertex) -> u16 {
+                for (u32 i = 0; i < face.vertexCount; ++i) {
+                    if (face.vertices[i] == vertex) return (u16)inner[i];
+                }
+                return (u16)vertex;
+            };
+
+            // Ring of quads between the outer edge and the inner face
+            for (u32 e = 0; e < face.edgeCount; ++e) {
+                u16 a = (u16)face.edgeFrom[e];
+                u16 b = (u16)face.edgeTo[e];
+                u16 aInner = innerOf(a);
+                u16 bInner = innerOf(b);
+
+                buffer->Indices.push_back(a);
+                buffer->Indices.push_back(b);
+                buffer->Indices.push_back(bInner);
+                buffer->Indices.push_back(a);
+                buffer->Indices.push_back(bInner);
+                buffer->Indices.push_back(aInner);
+            }
+
+            // The face itself now uses the inner vertices
+            u16* writeIndices = buffer->Indices.pointer();
+            for (u32 t = 0; t < face.triangleCount; ++t) {
+                for (u32 k = 0; k < 3; ++k) {
+                    u16& index = writeIndices[face.triangles[t] + k];
+                    index = innerOf(index);
+                }
+            }
+        }
+
+        buffer->recalculateBoundingBox();
+        buffer->setDirty(EBT_VERTEX_AND_INDEX);
+
+        result.success = true;
+        result.facesProcessed = layoutCount;
+        result.verticesAdded = newVertices;
+        result.indicesAdded = newIndices;
+        return result;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cstring>
+
+using namespace irr;
+
+// Fast non-cryptographic 64-bit content hash (MurmurHash64A), for telling
+// identical blobs apart from different ones. Not for anything adversarial.
+namespace Hash {
+    inline u64 Bytes(const void* data, size_t size, u64 seed = 0) {
+        const u64 m = 0xc6a4a7935bd1e995ULL;
+        const s32 r = 47;
+
+        u64 h = seed ^ (size * m);
+        const u8* bytes = (const u8*)data;
+        const u8* end = bytes + (size & ~(size_t)7);
+
+        for (; bytes != end; bytes += 8) {
+            u64 k;
+            memcpy(&k, bytes, 8); // Unaligned and little-endian safe on the targets we build for
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+            h ^= k;
+            h *= m;
+        }
+
+        switch (size & 7) {
+            case 7: h ^= (u64)bytes[6] << 48; [[fallthrough]];
+            case 6: h ^= (u64)bytes[5] << 40; [[fallthrough]];
+            case 5: h ^= (u64)bytes[4] << 32; [[fallthrough]];
+            case 4: h ^= (u64)bytes[3] << 24; [[fallthrough]];
+            case 3: h ^= (u64)bytes[2] << 16; [[fallthrough]];
+            case 2: h ^= (u64)bytes[1] << 8; [[fallthrough]];
+            case 1: h ^= (u64)bytes[0];
+                    h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+        return h;
+    }
+}
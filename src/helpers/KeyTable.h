@@ -0,0 +1,59 @@
+#pragma once
+
+#include <irrlicht.h>
+
+#include "helpers/ScratchArena.h"
+
+using namespace irr;
+
+// Open addressing table mapping a 3-int key (quantised position, cell, edge)
+// to a dense id. Storage comes from a ScratchArena, so it is only valid until
+// the arena is reset.
+struct KeyTable {
+    static constexpr u32 EMPTY = 0xFFFFFFFF;
+
+    s32* keys;
+    u32* values;
+    u32 mask;
+    u32 count;
+
+    void Init(ScratchArena& arena, u32 expected) {
+        u32 capacity = 16;
+        while (capacity < expected * 2) capacity <<= 1;
+        keys = arena.Alloc<s32>(capacity * 3);
+        values = arena.AllocFilled<u32>(capacity, EMPTY);
+        mask = capacity - 1;
+        count = 0;
+    }
+
+    // Returns the id for the key, assigning the next free id if it is new
+    u32 FindOrInsert(s32 a, s32 b, s32 c, bool& inserted) {
+        for (u32 slot = _hash(a, b, c) & mask;; slot = (slot + 1) & mask) {
+            if (values[slot] == EMPTY) {
+                keys[slot * 3] = a;
+                keys[slot * 3 + 1] = b;
+                keys[slot * 3 + 2] = c;
+                values[slot] = count++;
+                inserted = true;
+                return values[slot];
+            }
+            if (keys[slot * 3] == a && keys[slot * 3 + 1] == b && keys[slot * 3 + 2] == c) {
+                inserted = false;
+                return values[slot];
+            }
+        }
+    }
+
+    // Returns the id for the key, or EMPTY if it was never inserted
+    u32 Find(s32 a, s32 b, s32 c) const {
+        for (u32 slot = _hash(a, b, c) & mask;; slot = (slot + 1) & mask) {
+            if (values[slot] == EMPTY) return EMPTY;
+            if (keys[slot * 3] == a && keys[slot * 3 + 1] == b && keys[slot * 3 + 2] == c) return values[slot];
+        }
+    }
+
+private:
+    static u32 _hash(s32 a, s32 b, s32 c) {
+        return (u32)a * 73856093u ^ (u32)b * 19349663u ^ (u32)c * 83492791u;
+    }
+};
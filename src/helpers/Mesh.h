@@ -15,6 +15,8 @@ namespace Mesh {
 
         f32 s = size / 2.0f;
         SColor white(255, 255, 255, 255);
+        buffer->Vertices.reallocate(24);
+        buffer->Indices.reallocate(36);
 
         // 24 Vertices (4 per face) - each face needs unique vertices for proper UV mapping
         
@@ -77,6 +79,8 @@ namespace Mesh {
         SMeshBuffer* buffer = new SMeshBuffer();
         
         SColor white(255, 255, 255, 255);
+        buffer->Vertices.reallocate((polyCountX + 1) * (polyCountY + 1));
+        buffer->Indices.reallocate(polyCountX * polyCountY * 6);
 
         // 1. Generate Vertices
         for (u32 y = 0; y <= polyCountY; ++y) {
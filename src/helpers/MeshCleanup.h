@@ -0,0 +1,191 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "helpers/ScratchArena.h"
+#include "helpers/KeyTable.h"
+#include "helpers/Parallel.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Merge by distance plus removal of degenerate triangles and unreferenced
+// vertices. Positions are hashed into cells the size of the merge distance,
+// so each vertex is only compared against the 27 cells around it.
+namespace MeshCleanup {
+    inline constexpr f32 UV_EPSILON = 0.0001f;
+    inline constexpr f32 NORMAL_COS_EPSILON = 0.999f;
+    inline constexpr f32 DEGENERATE_AREA_SQ = 1e-12f;
+
+    struct Report {
+        u32 verticesBefore = 0;
+        u32 verticesAfter = 0;
+        u32 trianglesBefore = 0;
+        u32 trianglesAfter = 0;
+        u32 merged = 0;
+        u32 degenerate = 0;
+        u32 unused = 0;
+        f64 milliseconds = 0.0;
+
+        void Add(const Report& other) {
+            verticesBefore += other.verticesBefore;
+            verticesAfter += other.verticesAfter;
+            trianglesBefore += other.trianglesBefore;
+            trianglesAfter += other.trianglesAfter;
+            merged += other.merged;
+            degenerate += other.degenerate;
+            unused += other.unused;
+        }
+
+        void Print(const char* label) const {
+            std::cout << label << ": vertices " << verticesBefore << " -> " << verticesAfter
+                      << ", triangles " << trianglesBefore << " -> " << trianglesAfter
+                      << " (merged " << merged << ", degenerate " << degenerate
+                      << ", unused " << unused << ") in " << milliseconds << " ms" << std::endl;
+        }
+    };
+
+    // Split vertices (UV seams, hard edges) stay split unless mergeAcrossSeams is set
+    inline bool CanMerge(const S3DVertex& a, const S3DVertex& b, f32 distanceSq, bool mergeAcrossSeams) {
+        if (a.Pos.getDistanceFromSQ(b.Pos) > distanceSq) return false;
+        if (mergeAcrossSeams) return true;
+        return a.TCoords.equals(b.TCoords, UV_EPSILON) &&
+               a.Normal.dotProduct(b.Normal) >= NORMAL_COS_EPSILON * a.Normal.getLength() * b.Normal.getLength();
+    }
+
+    inline Report CleanBuffer(SMeshBuffer* buffer, f32 distance, bool mergeAcrossSeams, ScratchArena& arena) {
+        Report report;
+        const u32 vertexCount = buffer->Vertices.size();
+        const u32 indexCount = buffer->Indices.size() - buffer->Indices.size() % 3;
+        report.verticesBefore = vertexCount;
+        report.trianglesBefore = indexCount / 3;
+        if (vertexCount == 0) return report;
+
+        S3DVertex* vertices = buffer->Vertices.pointer();
+        u16* indices = buffer->Indices.pointer();
+        const f32 cellSize = distance > ROUNDING_ERROR_f32 ? distance : ROUNDING_ERROR_f32;
+        const f32 invCell = 1.0f / cellSize;
+        const f32 distanceSq = distance * distance;
+
+        // 1. Bucket vertices by cell (counting sort into CSR order)
+        s32* cells = arena.Alloc<s32>(vertexCount * 3);
+        u32* cellOf = arena.Alloc<u32>(vertexCount);
+        KeyTable table;
+        table.Init(arena, vertexCount);
+
+        for (u32 v = 0; v < vertexCount; ++v) {
+            s32* c = cells + v * 3;
+            c[0] = (s32)std::floor(vertices[v].Pos.X * invCell);
+            c[1] = (s32)std::floor(vertices[v].Pos.Y * invCell);
+            c[2] = (s32)std::floor(vertices[v].Pos.Z * invCell);
+            bool inserted = false;
+            cellOf[v] = table.FindOrInsert(c[0], c[1], c[2], inserted);
+        }
+
+        u32* cellStart = arena.AllocFilled<u32>(table.count + 1, 0);
+        for (u32 v = 0; v < vertexCount; ++v) cellStart[cellOf[v] + 1]++;
+        for (u32 c = 0; c < table.count; ++c) cellStart[c + 1] += cellStart[c];
+
+        u32* cursor = arena.Alloc<u32>(table.count);
+        for (u32 c = 0; c < table.count; ++c) cursor[c] = cellStart[c];
+        u32* cellVertices = arena.Alloc<u32>(vertexCount);
+        for (u32 v = 0; v < vertexCount; ++v) cellVertices[cursor[cellOf[v]]++] = v; // ascending within a cell
+
+        // 2. Each vertex merges into the lowest indexed survivor within reach
+        u32* target = arena.Alloc<u32>(vertexCount);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            target[v] = v;
+            const s32* c = cells + v * 3;
+
+            for (s32 dx = -1; dx <= 1 && target[v] == v; ++dx) {
+                for (s32 dy = -1; dy <= 1 && target[v] == v; ++dy) {
+                    for (s32 dz = -1; dz <= 1 && target[v] == v; ++dz) {
+                        u32 cell = table.Find(c[0] + dx, c[1] + dy, c[2] + dz);
+                        if (cell == KeyTable::EMPTY) continue;
+
+                        for (u32 i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                            u32 other = cellVertices[i];
+                            if (other >= v) break;
+                            if (target[other] == other && CanMerge(vertices[v], vertices[other], distanceSq, mergeAcrossSeams)) {
+                                target[v] = other;
+                                report.merged++;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // 3. Remap triangles, dropping the ones that collapsed
+        u32 writeIndex = 0;
+        for (u32 i = 0; i < indexCount; i += 3) {
+            u32 a = target[indices[i]], b = target[indices[i + 1]], c = target[indices[i + 2]];
+            vector3df cross = (vertices[b].Pos - vertices[a].Pos).crossProduct(vertices[c].Pos - vertices[a].Pos);
+
+            if (a == b || b == c || a == c || cross.getLengthSQ() <= DEGENERATE_AREA_SQ) {
+                report.degenerate++;
+                continue;
+            }
+            indices[writeIndex++] = (u16)a;
+            indices[writeIndex++] = (u16)b;
+            indices[writeIndex++] = (u16)c;
+        }
+
+        // 4. Compact away vertices nothing references (order is preserved, so in place)
+        u32* newIndex = arena.AllocFilled<u32>(vertexCount, KeyTable::EMPTY);
+        for (u32 i = 0; i < writeIndex; ++i) newIndex[indices[i]] = 0;
+
+        u32 kept = 0;
+        for (u32 v = 0; v < vertexCount; ++v) {
+            if (newIndex[v] == KeyTable::EMPTY) continue;
+            newIndex[v] = kept;
+            vertices[kept++] = vertices[v];
+        }
+        for (u32 i = 0; i < writeIndex; ++i) indices[i] = (u16)newIndex[indices[i]];
+
+        report.unused = vertexCount - kept - report.merged;
+        buffer->Vertices.set_used(kept);
+        buffer->Indices.set_used(writeIndex);
+        buffer->recalculateBoundingBox();
+        buffer->setDirty(EBT_VERTEX_AND_INDEX);
+
+        report.verticesAfter = kept;
+        report.trianglesAfter = writeIndex / 3;
+        return report;
+    }
+
+    // Cleans every standard buffer of the mesh, one buffer per worker
+    inline Report Run(IMesh* mesh, f32 distance, bool mergeAcrossSeams = false) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<SMeshBuffer*> buffers;
+        for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+            IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getVertexType() == EVT_STANDARD && mb->getIndexType() == EIT_16BIT)
+                buffers.push_back(static_cast<SMeshBuffer*>(mb));
+        }
+
+        std::vector<Report> reports(buffers.size());
+        Parallel::For((u32)buffers.size(), 1, [&](u32 begin, u32 end) {
+            ScratchArena arena;
+            for (u32 b = begin; b < end; ++b) {
+                arena.Reset();
+                reports[b] = CleanBuffer(buffers[b], distance, mergeAcrossSeams, arena);
+            }
+        });
+
+        Report total;
+        for (const Report& report : reports) total.Add(report);
+        static_cast<SMesh*>(mesh)->recalculateBoundingBox();
+
+        total.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return total;
+    }
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "helpers/Parallel.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Incremental vertex normal updates for edited mesh buffers.
+//
+// Vertices that share a position but were split (UV seams, hard edges) are
+// grouped. A vertex normal is the area weighted sum of its own faces plus the
+// faces of its co-located vertices that are within the hard edge angle, so
+// seams stay smooth while genuinely hard edges (cube corners) stay sharp.
+namespace Normals {
+    inline constexpr f32 POSITION_EPSILON = 0.001f;
+    inline constexpr f32 DEFAULT_HARD_ANGLE = 60.0f;  // Degrees
+    inline constexpr u32 PARALLEL_THRESHOLD = 4096;   // Vertices before splitting across threads
+    inline constexpr u32 PARALLEL_GRAIN = 1024;
+
+    // Adjacency for one mesh buffer, rebuilt only when its indices change
+    struct Topology {
+        u32 indexChangedId = 0;
+        u32 vertexCount = 0;
+        u32 indexCount = 0;
+        bool valid = false;
+
+        // Triangles using each vertex (CSR)
+        std::vector<u32> vertexTriangleStart;
+        std::vector<u32> vertexTriangles;
+
+        // Vertices sharing each position (CSR), and each vertex's group
+        std::vector<u32> groupOf;
+        std::vector<u32> groupStart;
+        std::vector<u32> groupVertices;
+
+        // Unnormalised (area weighted) face normals, kept between updates
+        std::vector<vector3df> faceNormals;
+
+        // Per-update scratch, kept to avoid reallocating every drag frame
+        std::vector<u8> triangleMark;
+        std::vector<u8> vertexMark;
+        std::vector<u32> affectedTriangles;
+        std::vector<u32> affectedVertices;
+    };
+
+    inline vector3df FaceNormal(const S3DVertex* vertices, const u16* tri) {
+        return (vertices[tri[1]].Pos - vertices[tri[0]].Pos).crossProduct(
+            vertices[tri[2]].Pos - vertices[tri[0]].Pos);
+    }
+
+    inline bool IsCurrent(const Topology& topology, const IMeshBuffer* mb) {
+        return topology.valid &&
+               topology.indexChangedId == mb->getChangedID_Index() &&
+               topology.vertexCount == mb->getVertexCount() &&
+               topology.indexCount == mb->getIndexCount();
+    }
+
+    inline void BuildTopology(const IMeshBuffer* mb, Topology& topology) {
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+        u32 vertexCount = mb->getVertexCount();
+        u32 indexCount = mb->getIndexCount();
+        u32 triangleCount = indexCount / 3;
+
+        // 1. Vertex -> triangles
+        topology.vertexTriangleStart.assign(vertexCount + 1, 0);
+        for (u32 i = 0; i < triangleCount * 3; ++i) topology.vertexTriangleStart[indices[i] + 1]++;
+        for (u32 v = 0; v < vertexCount; ++v) topology.vertexTriangleStart[v + 1] += topology.vertexTriangleStart[v];
+
+        topology.vertexTriangles.resize(triangleCount * 3);
+        std::vector<u32> cursor(topology.vertexTriangleStart.begin(), topology.vertexTriangleStart.end() - 1);
+        for (u32 i = 0; i < triangleCount * 3; ++i) topology.vertexTriangles[cursor[indices[i]]++] = i / 3;
+
+        // 2. Group vertices by position (sort on the quantised position)
+        struct Key { s32 x, y, z; u32 vertex; };
+        std::vector<Key> keys(vertexCount);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            const vector3df& p = vertices[v].Pos;
+            keys[v] = {
+                (s32)std::floor(p.X / POSITION_EPSILON + 0.5f),
+                (s32)std::floor(p.Y / POSITION_EPSILON + 0.5f),
+                (s32)std::floor(p.Z / POSITION_EPSILON + 0.5f),
+                v
+            };
+        }
+        std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+            if (a.x != b.x) return a.x < b.x;
+            if (a.y != b.y) return a.y < b.y;
+            if (a.z != b.z) return a.z < b.z;
+            return a.vertex < b.vertex;
+        });
+
+        topology.groupOf.resize(vertexCount);
+        topology.groupStart.clear();
+        topology.groupVertices.resize(vertexCount);
+        for (u32 k = 0; k < vertexCount; ++k) {
+            bool newGroup = k == 0 || keys[k].x != keys[k - 1].x || keys[k].y != keys[k - 1].y || keys[k].z != keys[k - 1].z;
+            if (newGroup) topology.groupStart.push_back(k);
+            topology.groupOf[keys[k].vertex] = (u32)topology.groupStart.size() - 1;
+            topology.groupVertices[k] = keys[k].vertex;
+        }
+        topology.groupStart.push_back(vertexCount);
+
+        // 3. Face normals for the whole buffer, once
+        topology.faceNormals.resize(triangleCount);
+        for (u32 t = 0; t < triangleCount; ++t) topology.faceNormals[t] = FaceNormal(vertices, indices + t * 3);
+
+        topology.triangleMark.assign(triangleCount, 0);
+        topology.vertexMark.assign(vertexCount, 0);
+        topology.indexChangedId = mb->getChangedID_Index();
+        topology.vertexCount = vertexCount;
+        topology.indexCount = indexCount;
+        topology.valid = true;
+    }
+
+    // Recomputes the faces touching `moved` and the normals of every vertex
+    // those faces (or their co-located twins) contribute to.
+    inline u32 UpdateIncremental(
+        IMeshBuffer* mb,
+        Topology& topology,
+        const u32* moved,
+        u32 movedCount,
+        f32 hardAngle = DEFAULT_HARD_ANGLE
+    ) {
+        if (!IsCurrent(topology, mb)) BuildTopology(mb, topology);
+
+        S3DVertex* vertices = (S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+        const f32 hardCos = cosf(hardAngle * DEGTORAD);
+
+        // 1. Faces touching a moved vertex
+        topology.affectedTriangles.clear();
+        for (u32 m = 0; m < movedCount; ++m) {
+            u32 v = moved[m];
+            if (v >= topology.vertexCount) continue;
+            for (u32 i = topology.vertexTriangleStart[v]; i < topology.vertexTriangleStart[v + 1]; ++i) {
+                u32 t = topology.vertexTriangles[i];
+                if (!topology.triangleMark[t]) {
+                    topology.triangleMark[t] = 1;
+                    topology.affectedTriangles.push_back(t);
+                }
+            }
+        }
+
+        // 2. Vertices of those faces, plus their co-located twins
+        topology.affectedVertices.clear();
+        for (u32 t : topology.affectedTriangles) {
+            topology.triangleMark[t] = 0;
+            for (u32 k = 0; k < 3; ++k) {
+                u32 group = topology.groupOf[indices[t * 3 + k]];
+                for (u32 g = topology.groupStart[group]; g < topology.groupStart[group + 1]; ++g) {
+                    u32 v = topology.groupVertices[g];
+                    if (!topology.vertexMark[v]) {
+                        topology.vertexMark[v] = 1;
+                        topology.affectedVertices.push_back(v);
+                    }
+                }
+            }
+        }
+        for (u32 v : topology.affectedVertices) topology.vertexMark[v] = 0;
+
+        const u32 triangleCount = (u32)topology.affectedTriangles.size();
+        const u32 vertexCount = (u32)topology.affectedVertices.size();
+        const u32 grain = vertexCount >= PARALLEL_THRESHOLD ? PARALLEL_GRAIN : vertexCount + triangleCount + 1;
+
+        // 3. Refresh face normals
+        Parallel::For(triangleCount, grain, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                u32 t = topology.affectedTriangles[i];
+                topology.faceNormals[t] = FaceNormal(vertices, indices + t * 3);
+            }
+        });
+
+        // 4. Re-accumulate only the affected vertex normals
+        Parallel::For(vertexCount, grain, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                u32 v = topology.affectedVertices[i];
+
+                vector3df own(0, 0, 0);
+                for (u32 a = topology.vertexTriangleStart[v]; a < topology.vertexTriangleStart[v + 1]; ++a) {
+                    own += topology.faceNormals[topology.vertexTriangles[a]];
+                }
+
+                vector3df ownDir = own;
+                ownDir.normalize();
+                vector3df normal = own;
+
+                // Blend across seams, but not across hard edges
+                u32 group = topology.groupOf[v];
+                for (u32 g = topology.groupStart[group]; g < topology.groupStart[group + 1]; ++g) {
+                    u32 twin = topology.groupVertices[g];
+                    if (twin == v) continue;
+                    for (u32 a = topology.vertexTriangleStart[twin]; a < topology.vertexTriangleStart[twin + 1]; ++a) {
+                        const vector3df& face = topology.faceNormals[topology.vertexTriangles[a]];
+                        f32 length = face.getLength();
+                        if (length > 0.0f && face.dotProduct(ownDir) >= hardCos * length) normal += face;
+                    }
+                }
+
+                if (normal.getLengthSQ() > 0.0f) vertices[v].Normal = normal.normalize();
+            }
+        });
+
+        return vertexCount;
+    }
+
+    // Full recalculation through the same path (every vertex counts as moved)
+    inline void RecalculateAll(IMeshBuffer* mb, Topology& topology, f32 hardAngle = DEFAULT_HARD_ANGLE) {
+        BuildTopology(mb, topology);
+        std::vector<u32> all(mb->getVertexCount());
+        for (u32 v = 0; v < all.size(); ++v) all[v] = v;
+        UpdateIncremental(mb, topology, all.data(), (u32)all.size(), hardAngle);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+using namespace irr;
+
+namespace Parallel {
+    inline u32 WorkerCount() {
+        u32 hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? hardware : 1;
+    }
+
+    // Splits [0, count) into contiguous ranges and runs fn(begin, end) on each.
+    // Small jobs (fewer than two grains) run inline on the calling thread.
+    template<class Fn>
+    void For(u32 count, u32 grain, Fn&& fn) {
+        if (count == 0) return;
+
+        u32 workers = std::min(WorkerCount(), (count + grain - 1) / std::max(grain, 1u));
+        if (workers <= 1) {
+            fn(0u, count);
+            return;
+        }
+
+        u32 chunk = (count + workers - 1) / workers;
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+
+        for (u32 w = 1; w < workers; ++w) {
+            u32 begin = w * chunk;
+            u32 end = std::min(count, begin + chunk);
+            if (begin >= end) break;
+            threads.emplace_back([&fn, begin, end]() { fn(begin, end); });
+        }
+
+        // The calling thread takes the first range
+        fn(0u, std::min(count, chunk));
+
+        for (std::thread& thread : threads) thread.join();
+    }
+}
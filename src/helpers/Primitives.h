@@ -0,0 +1,336 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "Types.h"
+#include "helpers/Parallel.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Parametric primitives. Every shape is described as a set of quad grids
+// (surfaces); the exact vertex and index counts are known up front, so each
+// mesh buffer is allocated once and then filled row by row in parallel.
+// Grids too large for 16-bit indices are split into bands of rows, and bands
+// are packed into as few buffers as the index range allows.
+namespace Primitives {
+    inline constexpr u32 MAX_VERTICES = 65535;
+    inline constexpr u32 MAX_COLUMNS = MAX_VERTICES / 2 - 1; // A band needs at least two vertex rows
+    inline constexpr u32 PARALLEL_GRAIN = 16;                 // Vertex rows per task
+
+    struct Params {
+        f32 size = 8.0f;        // Cube and plane edge, diameter of round shapes
+        f32 height = 8.0f;      // Cylinder and cone
+        f32 tubeRatio = 0.25f;  // Torus tube radius relative to its outer radius
+        u32 segments = 32;      // Around the axis (columns of a plane, cube face subdivisions)
+        u32 rings = 16;         // Along the axis (rows of a plane)
+        u32 capRings = 1;       // Concentric rings in cylinder and cone caps
+    };
+
+    // One quad grid: (columns + 1) x (rows + 1) vertices evaluated at u, v in [0, 1]
+    struct Surface {
+        u32 columns = 1;
+        u32 rows = 1;
+        bool collapseFirstRow = false; // Row v = 0 is a single point (pole, apex, cap centre)
+        bool collapseLastRow = false;  // Row v = 1 is a single point
+        bool flipWinding = false;      // Set when du x dv points inwards
+        std::function<void(f32 u, f32 v, S3DVertex& vertex)> evaluate;
+    };
+
+    // A run of rows from one surface placed in one buffer
+    struct Band {
+        u32 surface;
+        u32 firstRow;
+        u32 rowCount;
+        u32 buffer;
+        u32 baseVertex;
+        u32 baseIndex;
+    };
+
+    inline const char* Name(PrimitiveType type) {
+        switch (type) {
+            case PrimitiveType::PRIMITIVE_CUBE:     return "Cube";
+            case PrimitiveType::PRIMITIVE_SPHERE:   return "Sphere";
+            case PrimitiveType::PRIMITIVE_CYLINDER: return "Cylinder";
+            case PrimitiveType::PRIMITIVE_TORUS:    return "Torus";
+            case PrimitiveType::PRIMITIVE_PLANE:    return "Plane";
+            case PrimitiveType::PRIMITIVE_CONE:     return "Cone";
+            default: return "Unknown";
+        }
+    }
+
+    // Indices written by quad row `row` of a band (collapsed rows emit one triangle per quad)
+    inline u32 RowIndexCount(const Surface& surface, u32 row) {
+        bool collapsed = (row == 0 && surface.collapseFirstRow) || (row == surface.rows - 1 && surface.collapseLastRow);
+        u32 triangles = collapsed ? 1 : 2;
+        if (surface.rows == 1 && surface.collapseFirstRow && surface.collapseLastRow) triangles = 0;
+        return surface.columns * triangles * 3;
+    }
+
+    inline u32 BandIndexCount(const Surface& surface, u32 firstRow, u32 rowCount) {
+        u32 count = 0;
+        for (u32 r = firstRow; r < firstRow + rowCount; ++r) count += RowIndexCount(surface, r);
+        return count;
+    }
+
+    inline void WriteQuadRow(const Surface& surface, const Band& band, u32 localRow, u16* indices) {
+        const u32 stride = surface.columns + 1;
+        const u32 row = band.firstRow + localRow;
+        const bool dropFirst = row == 0 && surface.collapseFirstRow;
+        const bool dropSecond = row == surface.rows - 1 && surface.collapseLastRow;
+
+        for (u32 i = 0; i < surface.columns; ++i) {
+            u16 a = (u16)(band.baseVertex + localRow * stride + i);
+            u16 b = (u16)(a + 1);
+            u16 d = (u16)(a + stride);
+            u16 c = (u16)(d + 1);
+
+            // Triangle (a, b, c) degenerates when a and b share a pole, (a, c, d) when c and d do
+            if (!dropFirst) {
+                *indices++ = a;
+                *indices++ = surface.flipWinding ? c : b;
+                *indices++ = surface.flipWinding ? b : c;
+            }
+            if (!dropSecond) {
+                *indices++ = a;
+                *indices++ = surface.flipWinding ? d : c;
+                *indices++ = surface.flipWinding ? c : d;
+            }
+        }
+    }
+
+    inline SMesh* Build(const std::vector<Surface>& surfaces) {
+        // 1. Lay out bands and size every buffer exactly
+        std::vector<Band> bands;
+        std::vector<u32> bufferVertices;
+        std::vector<u32> bufferIndices;
+
+        for (u32 s = 0; s < surfaces.size(); ++s) {
+            const Surface& surface = surfaces[s];
+            const u32 stride = surface.columns + 1;
+            const u32 rowsPerBand = MAX_VERTICES / stride - 1;
+
+            for (u32 firstRow = 0; firstRow < surface.rows; firstRow += rowsPerBand) {
+                u32 rowCount = std::min(rowsPerBand, surface.rows - firstRow);
+                u32 vertexCount = (rowCount + 1) * stride;
+
+                if (bufferVertices.empty() || bufferVertices.back() + vertexCount > MAX_VERTICES) {
+                    bufferVertices.push_back(0);
+                    bufferIndices.push_back(0);
+                }
+
+                u32 buffer = (u32)bufferVertices.size() - 1;
+                bands.push_back({ s, firstRow, rowCount, buffer, bufferVertices[buffer], bufferIndices[buffer] });
+                bufferVertices[buffer] += vertexCount;
+                bufferIndices[buffer] += BandIndexCount(surface, firstRow, rowCount);
+            }
+        }
+
+        SMesh* mesh = new SMesh();
+        std::vector<SMeshBuffer*> buffers(bufferVertices.size());
+        for (u32 b = 0; b < buffers.size(); ++b) {
+            buffers[b] = new SMeshBuffer();
+            buffers[b]->Vertices.set_used(bufferVertices[b]);
+            buffers[b]->Indices.set_used(bufferIndices[b]);
+        }
+
+        // 2. One task item per vertex row of each band; the row also writes the quads below it
+        struct RowJob { u32 band; u32 localRow; u32 indexOffset; };
+        std::vector<RowJob> jobs;
+        for (u32 b = 0; b < bands.size(); ++b) {
+            const Surface& surface = surfaces[bands[b].surface];
+            u32 indexOffset = bands[b].baseIndex;
+            for (u32 r = 0; r <= bands[b].rowCount; ++r) {
+                jobs.push_back({ b, r, indexOffset });
+                if (r < bands[b].rowCount) indexOffset += RowIndexCount(surface, bands[b].firstRow + r);
+            }
+        }
+
+        Parallel::For((u32)jobs.size(), PARALLEL_GRAIN, [&](u32 begin, u32 end) {
+            for (u32 j = begin; j < end; ++j) {
+                const RowJob& job = jobs[j];
+                const Band& band = bands[job.band];
+                const Surface& surface = surfaces[band.surface];
+                SMeshBuffer* buffer = buffers[band.buffer];
+
+                const u32 stride = surface.columns + 1;
+                const f32 v = (f32)(band.firstRow + job.localRow) / (f32)surface.rows;
+                S3DVertex* row = buffer->Vertices.pointer() + band.baseVertex + job.localRow * stride;
+
+                for (u32 i = 0; i < stride; ++i) {
+                    row[i].Color = SColor(255, 255, 255, 255);
+                    surface.evaluate((f32)i / (f32)surface.columns, v, row[i]);
+                }
+
+                if (job.localRow < band.rowCount)
+                    WriteQuadRow(surface, band, job.localRow, buffer->Indices.pointer() + job.indexOffset);
+            }
+        });
+
+        for (SMeshBuffer* buffer : buffers) {
+            buffer->recalculateBoundingBox();
+            mesh->addMeshBuffer(buffer);
+            buffer->drop();
+        }
+        mesh->recalculateBoundingBox();
+        return mesh;
+    }
+
+    // Disc in the XZ plane at height y, facing up or down; v runs from the centre outwards
+    inline Surface Cap(f32 radius, f32 y, bool up, u32 segments, u32 rings) {
+        Surface cap;
+        cap.columns = segments;
+        cap.rows = rings;
+        cap.collapseFirstRow = true;
+        cap.flipWinding = !up;
+        cap.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+            f32 theta = 2.0f * PI * u;
+            f32 c = cosf(theta), s = sinf(theta);
+            vertex.Pos.set(radius * v * c, y, radius * v * s);
+            vertex.Normal.set(0, up ? 1.0f : -1.0f, 0);
+            vertex.TCoords.set(0.5f + 0.5f * v * c, 0.5f - 0.5f * v * s);
+        };
+        return cap;
+    }
+
+    inline std::vector<Surface> Describe(PrimitiveType type, const Params& params) {
+        std::vector<Surface> surfaces;
+        const u32 segments = core::clamp(params.segments, 3u, MAX_COLUMNS);
+        const u32 rings = core::clamp(params.rings, 1u, MAX_VERTICES);
+        const u32 capRings = core::clamp(params.capRings, 1u, MAX_VERTICES);
+        const f32 radius = params.size * 0.5f;
+        const f32 halfHeight = params.height * 0.5f;
+
+        switch (type) {
+            case PrimitiveType::PRIMITIVE_CUBE: {
+                // Face normal, texture right, texture down (down x right is the normal)
+                static const vector3df faces[6][3] = {
+                    { vector3df(0, 0, 1),  vector3df(1, 0, 0),  vector3df(0, -1, 0) }, // Front
+                    { vector3df(0, 0, -1), vector3df(-1, 0, 0), vector3df(0, -1, 0) }, // Back
+                    { vector3df(0, 1, 0),  vector3df(1, 0, 0),  vector3df(0, 0, 1) },  // Top
+                    { vector3df(0, -1, 0), vector3df(1, 0, 0),  vector3df(0, 0, -1) }, // Bottom
+                    { vector3df(1, 0, 0),  vector3df(0, 0, -1), vector3df(0, -1, 0) }, // Right
+                    { vector3df(-1, 0, 0), vector3df(0, 0, 1),  vector3df(0, -1, 0) }  // Left
+                };
+                const u32 divisions = core::clamp(params.segments, 1u, MAX_COLUMNS);
+
+                for (u32 f = 0; f < 6; ++f) {
+                    vector3df normal = faces[f][0], right = faces[f][1], down = faces[f][2];
+                    Surface face;
+                    face.columns = divisions;
+                    face.rows = divisions;
+                    face.flipWinding = true;
+                    face.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                        vertex.Pos = (normal + right * (2.0f * u - 1.0f) + down * (2.0f * v - 1.0f)) * radius;
+                        vertex.Normal = normal;
+                        vertex.TCoords.set(u, v);
+                    };
+                    surfaces.push_back(face);
+                }
+                break;
+            }
+
+            case PrimitiveType::PRIMITIVE_SPHERE: {
+                Surface sphere;
+                sphere.columns = segments;
+                sphere.rows = std::max(rings, 2u);
+                sphere.collapseFirstRow = true;
+                sphere.collapseLastRow = true;
+                sphere.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                    f32 theta = 2.0f * PI * u, phi = PI * v;
+                    vertex.Normal.set(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+                    vertex.Pos = vertex.Normal * radius;
+                    vertex.TCoords.set(u, v);
+                };
+                surfaces.push_back(sphere);
+                break;
+            }
+
+            case PrimitiveType::PRIMITIVE_CYLINDER: {
+                Surface side;
+                side.columns = segments;
+                side.rows = rings;
+                side.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                    f32 theta = 2.0f * PI * u;
+                    vertex.Normal.set(cosf(theta), 0, sinf(theta));
+                    vertex.Pos.set(radius * vertex.Normal.X, halfHeight - params.height * v, radius * vertex.Normal.Z);
+                    vertex.TCoords.set(u, v);
+                };
+                surfaces.push_back(side);
+                surfaces.push_back(Cap(radius, halfHeight, true, segments, capRings));
+                surfaces.push_back(Cap(radius, -halfHeight, false, segments, capRings));
+                break;
+            }
+
+            case PrimitiveType::PRIMITIVE_CONE: {
+                // Apex on top; the slant normal is (height, radius) rotated around Y
+                vector2df slant(params.height, radius);
+                slant.normalize();
+
+                Surface side;
+                side.columns = segments;
+                side.rows = rings;
+                side.collapseFirstRow = true;
+                side.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                    f32 theta = 2.0f * PI * u;
+                    f32 c = cosf(theta), s = sinf(theta);
+                    vertex.Pos.set(radius * v * c, halfHeight - params.height * v, radius * v * s);
+                    vertex.Normal.set(slant.X * c, slant.Y, slant.X * s);
+                    vertex.TCoords.set(u, v);
+                };
+                surfaces.push_back(side);
+                surfaces.push_back(Cap(radius, -halfHeight, false, segments, capRings));
+                break;
+            }
+
+            case PrimitiveType::PRIMITIVE_TORUS: {
+                const f32 tube = radius * core::clamp(params.tubeRatio, 0.01f, 0.5f);
+                const f32 ring = radius - tube;
+
+                Surface torus;
+                torus.columns = segments;
+                torus.rows = std::max(rings, 3u);
+                torus.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                    f32 theta = 2.0f * PI * u, phi = 2.0f * PI * v;
+                    f32 c = cosf(theta), s = sinf(theta);
+                    vertex.Normal.set(cosf(phi) * c, -sinf(phi), cosf(phi) * s);
+                    vertex.Pos.set(ring * c, 0, ring * s);
+                    vertex.Pos += vertex.Normal * tube;
+                    vertex.TCoords.set(u, v);
+                };
+                surfaces.push_back(torus);
+                break;
+            }
+
+            case PrimitiveType::PRIMITIVE_PLANE: {
+                Surface plane;
+                plane.columns = core::clamp(params.segments, 1u, MAX_COLUMNS);
+                plane.rows = rings;
+                plane.evaluate = [=](f32 u, f32 v, S3DVertex& vertex) {
+                    vertex.Pos.set(params.size * (u - 0.5f), 0, params.size * (0.5f - v));
+                    vertex.Normal.set(0, 1, 0);
+                    vertex.TCoords.set(u, v);
+                };
+                surfaces.push_back(plane);
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        return surfaces;
+    }
+
+    inline SMesh* Create(PrimitiveType type, const Params& params) {
+        std::vector<Surface> surfaces = Describe(type, params);
+        if (surfaces.empty()) return nullptr;
+        return Build(surfaces);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace irr;
+
+// Named timing totals, safe to record from any thread. Print() dumps them
+// (at shutdown, or on demand) so background work shows up next to the rest.
+namespace Profiler {
+    struct Entry {
+        std::string name;
+        u32 count = 0;
+        f64 totalMilliseconds = 0.0;
+        f64 maxMilliseconds = 0.0;
+        f64 lastMilliseconds = 0.0;
+
+        f64 AverageMilliseconds() const { return count ? totalMilliseconds / count : 0.0; }
+    };
+
+    namespace detail {
+        inline std::mutex& Mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        // Few names, so a linear search beats hashing
+        inline std::vector<Entry>& Entries() {
+            static std::vector<Entry> entries;
+            return entries;
+        }
+    }
+
+    inline void Record(const char* name, f64 milliseconds) {
+        std::lock_guard<std::mutex> lock(detail::Mutex());
+        std::vector<Entry>& entries = detail::Entries();
+        auto it = std::find_if(entries.begin(), entries.end(), [name](const Entry& e) { return e.name == name; });
+        if (it == entries.end()) {
+            entries.emplace_back();
+            it = entries.end() - 1;
+            it->name = name;
+        }
+        it->count++;
+        it->totalMilliseconds += milliseconds;
+        it->maxMilliseconds = std::max(it->maxMilliseconds, milliseconds);
+        it->lastMilliseconds = milliseconds;
+    }
+
+    inline std::vector<Entry> Collect() {
+        std::lock_guard<std::mutex> lock(detail::Mutex());
+        return detail::Entries();
+    }
+
+    inline void Print() {
+        std::vector<Entry> entries = Collect();
+        if (entries.empty())
+            return;
+
+        std::cout << "Profile (count, avg / max / last ms):" << std::endl;
+        for (const Entry& e : entries) {
+            std::cout << "  " << std::left << std::setw(28) << e.name << std::right
+                      << std::setw(6) << e.count << "  " << std::fixed << std::setprecision(2)
+                      << e.AverageMilliseconds() << " / " << e.maxMilliseconds << " / " << e.lastMilliseconds
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    // Records the lifetime of the scope under `name`
+    class Scope {
+    public:
+        explicit Scope(const char* name) : _name(name), _start(std::chrono::steady_clock::now()) {}
+        ~Scope() { Record(_name, ElapsedMilliseconds()); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        f64 ElapsedMilliseconds() const {
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        }
+
+    private:
+        const char* _name;
+        std::chrono::steady_clock::time_point _start;
+    };
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUICEBOX_PSX_SSE2 1
+#endif
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// PlayStation-style compact vertices: 16-bit fixed-point positions, 8-bit
+// UVs and packed RGBA, 12 bytes instead of S3DVertex's 36. Normals are
+// dropped; the target bakes lighting into vertex colours.
+//
+// Positions use one binary fixed-point scale per mesh (position * 2^bits),
+// the largest that keeps every coordinate inside s16, up to
+// MAX_FRACTION_BITS. UVs are clamped to [0, 1] and stored as 0..255, the
+// 8-bit texel range of a PS1 texture page.
+namespace PsxQuantize {
+    inline constexpr s32 MAX_FRACTION_BITS = 12;
+    inline constexpr f32 POSITION_LIMIT = 32767.0f;
+
+    struct Vertex {
+        s16 x, y, z;
+        u8 u, v;
+        u8 r, g, b, a;
+    };
+    static_assert(sizeof(Vertex) == 12, "Compact vertex layout is part of the export format and the GPU layout");
+
+    struct Buffer {
+        std::vector<Vertex> vertices;
+        std::vector<u16> indices;
+    };
+
+    // Largest scale that fits `bounds`; 0 when the mesh is too large for
+    // any fraction (coordinates then saturate at +-32767)
+    inline s32 ChooseFractionBits(const aabbox3df& bounds) {
+        f32 extent = std::max({
+            std::fabs(bounds.MinEdge.X), std::fabs(bounds.MinEdge.Y), std::fabs(bounds.MinEdge.Z),
+            std::fabs(bounds.MaxEdge.X), std::fabs(bounds.MaxEdge.Y), std::fabs(bounds.MaxEdge.Z)
+        });
+
+        s32 bits = MAX_FRACTION_BITS;
+        while (bits > 0 && extent * (f32)(1 << bits) > POSITION_LIMIT) --bits;
+        return bits;
+    }
+
+    inline f32 Scale(s32 fractionBits) { return (f32)(1 << fractionBits); }
+
+    // SColor is 0xAARRGGBB; the compact vertex stores bytes R, G, B, A
+    inline u32 SwizzleColor(u32 argb) {
+        return ((argb >> 16) & 0xFFu) | (argb & 0xFF00u) | ((argb & 0xFFu) << 16) | (argb & 0xFF000000u);
+    }
+
+    // Rounds like _mm_cvtps_epi32 (to nearest even), so both paths agree bit for bit
+    inline s16 QuantizePosition(f32 value, f32 scale) {
+        return (s16)std::nearbyint(std::clamp(value * scale, -POSITION_LIMIT, POSITION_LIMIT));
+    }
+
+    inline u8 QuantizeUV(f32 value) {
+        return (u8)std::nearbyint(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+
+    inline void QuantizeScalar(const S3DVertex* in, u32 count, f32 scale, Vertex* out) {
+        for (u32 i = 0; i < count; ++i) {
+            const S3DVertex& s = in[i];
+            Vertex& d = out[i];
+            d.x = QuantizePosition(s.Pos.X, scale);
+            d.y = QuantizePosition(s.Pos.Y, scale);
+            d.z = QuantizePosition(s.Pos.Z, scale);
+            d.u = QuantizeUV(s.TCoords.X);
+            d.v = QuantizeUV(s.TCoords.Y);
+            u32 rgba = SwizzleColor(s.Color.color);
+            memcpy(&d.r, &rgba, 4);
+        }
+    }
+
+    // Four vertices per step: the arithmetic, clamping, rounding, saturating
+    // packs and colour swizzle are SSE2; only the AoS gather and scatter are
+    // scalar. The remainder goes through the scalar path.
+    inline void Quantize(const S3DVertex* in, u32 count, s32 fractionBits, Vertex* out) {
+        const f32 scale = Scale(fractionBits);
+        u32 i = 0;
+
+#ifdef JUICEBOX_PSX_SSE2
+        const __m128 scale4 = _mm_set1_ps(scale);
+        const __m128 limit = _mm_set1_ps(POSITION_LIMIT);
+        const __m128 negativeLimit = _mm_set1_ps(-POSITION_LIMIT);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 uvScale = _mm_set1_ps(255.0f);
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128i keepMask = _mm_set1_epi32((s32)0xFF00FF00u);
+
+        for (; i + 4 <= count; i += 4) {
+            const S3DVertex* s = in + i;
+            __m128 x = _mm_setr_ps(s[0].Pos.X, s[1].Pos.X, s[2].Pos.X, s[3].Pos.X);
+            __m128 y = _mm_setr_ps(s[0].Pos.Y, s[1].Pos.Y, s[2].Pos.Y, s[3].Pos.Y);
+            __m128 z = _mm_setr_ps(s[0].Pos.Z, s[1].Pos.Z, s[2].Pos.Z, s[3].Pos.Z);
+            __m128 u = _mm_setr_ps(s[0].TCoords.X, s[1].TCoords.X, s[2].TCoords.X, s[3].TCoords.X);
+            __m128 v = _mm_setr_ps(s[0].TCoords.Y, s[1].TCoords.Y, s[2].TCoords.Y, s[3].TCoords.Y);
+            __m128i color = _mm_setr_epi32((s32)s[0].Color.color, (s32)s[1].Color.color,
+                                           (s32)s[2].Color.color, (s32)s[3].Color.color);
+
+            x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(x, scale4), negativeLimit), limit);
+            y = _mm_min_ps(_mm_max_ps(_mm_mul_ps(y, scale4), negativeLimit), limit);
+            z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(z, scale4), negativeLimit), limit);
+            u = _mm_mul_ps(_mm_min_ps(_mm_max_ps(u, zero), one), uvScale);
+            v = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), uvScale);
+
+            alignas(16) s16 xy[8];
+            alignas(16) s16 zz[8];
+            alignas(16) u8 uv[16];
+            alignas(16) u32 rgba[4];
+            _mm_store_si128((__m128i*)xy, _mm_packs_epi32(_mm_cvtps_epi32(x), _mm_cvtps_epi32(y)));
+            _mm_store_si128((__m128i*)zz, _mm_packs_epi32(_mm_cvtps_epi32(z), _mm_cvtps_epi32(z)));
+            __m128i uv16 = _mm_packs_epi32(_mm_cvtps_epi32(u), _mm_cvtps_epi32(v));
+            _mm_store_si128((__m128i*)uv, _mm_packus_epi16(uv16, uv16));
+
+            // ARGB -> RGBA bytes: swap the red and blue bytes, keep green and alpha
+            __m128i swapped = _mm_or_si128(
+                _mm_and_si128(_mm_srli_epi32(color, 16), byteMask),
+                _mm_slli_epi32(_mm_and_si128(color, byteMask), 16));
+            _mm_store_si128((__m128i*)rgba, _mm_or_si128(swapped, _mm_and_si128(color, keepMask)));
+
+            for (u32 k = 0; k < 4; ++k) {
+                Vertex& d = out[i + k];
+                d.x = xy[k];
+                d.y = xy[4 + k];
+                d.z = zz[k];
+                d.u = uv[k];
+                d.v = uv[4 + k];
+                memcpy(&d.r, &rgba[k], 4);
+            }
+        }
+#endif
+
+        QuantizeScalar(in + i, count - i, scale, out + i);
+    }
+
+    inline void QuantizeBuffer(const IMeshBuffer* mb, s32 fractionBits, Buffer& out) {
+        out.vertices.resize(mb->getVertexCount());
+        Quantize((const S3DVertex*)mb->getVertices(), mb->getVertexCount(), fractionBits, out.vertices.data());
+
+        const u16* indices = mb->getIndices();
+        out.indices.assign(indices, indices + mb->getIndexCount() - mb->getIndexCount() % 3);
+    }
+
+    // What the target hardware would see, back in editor units
+    inline vector3df DequantizePosition(const Vertex& vertex, s32 fractionBits) {
+        f32 inverse = 1.0f / Scale(fractionBits);
+        return vector3df(vertex.x * inverse, vertex.y * inverse, vertex.z * inverse);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+using namespace irr;
+
+// Bump allocator for the temporary tables mesh operators build while they run.
+// Memory is handed out linearly and reclaimed all at once with Reset(), so an
+// operator touching thousands of faces does one allocation per block instead
+// of one per table. Blocks are kept between operations and reused.
+class ScratchArena {
+public:
+    explicit ScratchArena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+        : _blockSize(blockSize), _current(0)
+    {
+    }
+
+    // Returns uninitialised storage for `count` elements of T
+    template<class T>
+    T* Alloc(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "ScratchArena only holds trivial types");
+        return static_cast<T*>(_allocBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // Returns storage for `count` elements of T, each set to `value`
+    template<class T>
+    T* AllocFilled(size_t count, const T& value) {
+        T* data = Alloc<T>(count);
+        for (size_t i = 0; i < count; ++i) data[i] = value;
+        return data;
+    }
+
+    // Releases everything handed out since the last reset (blocks are kept)
+    void Reset() {
+        for (Block& block : _blocks) block.used = 0;
+        _current = 0;
+    }
+
+    size_t GetCapacity() const {
+        size_t total = 0;
+        for (const Block& block : _blocks) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20; // 1 MB
+
+    std::vector<Block> _blocks;
+    size_t _blockSize;
+    size_t _current;
+
+    void* _allocBytes(size_t bytes, size_t alignment) {
+        if (bytes == 0) bytes = 1;
+
+        while (_current < _blocks.size()) {
+            Block& block = _blocks[_current];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            uintptr_t aligned = (base + block.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            size_t offset = aligned - base;
+
+            if (offset + bytes <= block.size) {
+                block.used = offset + bytes;
+                return block.data.get() + offset;
+            }
+            ++_current;
+        }
+
+        // No existing block fits, grow by at least one default-sized block
+        size_t size = bytes + alignment > _blockSize ? bytes + alignment : _blockSize;
+        Block block;
+        block.data.reset(new unsigned char[size]);
+        block.size = size;
+        block.used = 0;
+        _blocks.push_back(std::move(block));
+        _current = _blocks.size() - 1;
+
+        return _allocBytes(bytes, alignment);
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+
+#include "Types.h"
+#include "helpers/SpatialGrid.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Proportional editing: vertices near the selection follow it with a weight
+// that falls off with distance. Weights are gathered once when a drag starts,
+// so each drag frame only touches the vertices inside the radius.
+namespace SoftSelection {
+    struct VertexRef {
+        u32 bufferIndex;
+        u32 vertexIndex;
+    };
+
+    struct Entry {
+        u32 bufferIndex;
+        u32 vertexIndex;
+        f32 weight;
+    };
+
+    // t is the distance divided by the radius, in [0, 1]
+    inline f32 Falloff(FalloffCurve curve, f32 t) {
+        t = core::clamp(t, 0.0f, 1.0f);
+        switch (curve) {
+            case FalloffCurve::SMOOTH: return 1.0f - t * t * (3.0f - 2.0f * t);
+            case FalloffCurve::SPHERE: return sqrtf(1.0f - t * t);
+            case FalloffCurve::LINEAR: return 1.0f - t;
+            case FalloffCurve::SHARP:  return (1.0f - t) * (1.0f - t);
+            default: return 1.0f - t;
+        }
+    }
+
+    inline const char* FalloffName(FalloffCurve curve) {
+        switch (curve) {
+            case FalloffCurve::SMOOTH: return "Smooth";
+            case FalloffCurve::SPHERE: return "Sphere";
+            case FalloffCurve::LINEAR: return "Linear";
+            case FalloffCurve::SHARP:  return "Sharp";
+            default: return "Unknown";
+        }
+    }
+
+    // Indexes every standard vertex of the mesh; refs maps grid ids back to the mesh
+    inline void BuildIndex(IMesh* mesh, f32 cellSize, SpatialGrid& grid, std::vector<VertexRef>& refs) {
+        std::vector<vector3df> positions;
+        refs.clear();
+
+        for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+            IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getVertexType() != EVT_STANDARD) continue;
+
+            const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+            u32 count = mb->getVertexCount();
+            positions.reserve(positions.size() + count);
+            refs.reserve(refs.size() + count);
+
+            for (u32 v = 0; v < count; ++v) {
+                positions.push_back(vertices[v].Pos);
+                refs.push_back({ b, v });
+            }
+        }
+
+        grid.Build(positions.data(), (u32)positions.size(), cellSize);
+    }
+
+    // Weights every indexed vertex within radius of any centre (strongest centre wins)
+    inline void Gather(
+        const SpatialGrid& grid,
+        const std::vector<VertexRef>& refs,
+        const std::vector<vector3df>& centres,
+        f32 radius,
+        FalloffCurve curve,
+        std::vector<Entry>& out
+    ) {
+        out.clear();
+        if (radius <= 0.0f) return;
+
+        std::vector<f32> weights(grid.GetCount(), -1.0f);
+        std::vector<u32> touched;
+        const f32 invRadius = 1.0f / radius;
+
+        for (const vector3df& centre : centres) {
+            grid.QueryRadius(centre, radius, [&](u32 index, f32 distSq) {
+                f32 weight = Falloff(curve, sqrtf(distSq) * invRadius);
+                if (weights[index] < 0.0f) touched.push_back(index);
+                if (weight > weights[index]) weights[index] = weight;
+            });
+        }
+
+        out.reserve(touched.size());
+        for (u32 index : touched) {
+            if (weights[index] > 0.0f) out.push_back({ refs[index].bufferIndex, refs[index].vertexIndex, weights[index] });
+        }
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace irr;
+
+// Sparse symmetric positive definite systems whose unknowns come in pairs,
+// like the (u, v) of every vertex in a UV unwrap. The matrix is stored as
+// 2x2 blocks in CSR order and solved with conjugate gradients,
+// preconditioned by the inverse of each diagonal block. Doubles throughout;
+// CG in floats stalls long before the energies these systems come from do.
+namespace SparseSolver {
+    struct Block {
+        f64 m[4] = { 0.0, 0.0, 0.0, 0.0 }; // Row-major
+
+        Block& operator+=(const Block& o) {
+            for (u32 i = 0; i < 4; ++i) m[i] += o.m[i];
+            return *this;
+        }
+    };
+
+    struct Entry {
+        u32 row;
+        u32 column;
+        Block block;
+    };
+
+    struct Matrix {
+        u32 size = 0; // Block rows; vectors hold 2 * size values
+        std::vector<u32> rowStart;
+        std::vector<u32> columns;
+        std::vector<Block> blocks;
+
+        void Multiply(const std::vector<f64>& x, std::vector<f64>& y) const {
+            for (u32 r = 0; r < size; ++r) {
+                f64 y0 = 0.0, y1 = 0.0;
+                for (u32 k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                    const f64* m = blocks[k].m;
+                    const f64 x0 = x[columns[k] * 2], x1 = x[columns[k] * 2 + 1];
+                    y0 += m[0] * x0 + m[1] * x1;
+                    y1 += m[2] * x0 + m[3] * x1;
+                }
+                y[r * 2] = y0;
+                y[r * 2 + 1] = y1;
+            }
+        }
+    };
+
+    // Sums duplicate (row, column) entries into CSR order; `entries` is sorted in place
+    inline void Assemble(std::vector<Entry>& entries, u32 size, Matrix& matrix) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.row != b.row ? a.row < b.row : a.column < b.column;
+        });
+
+        matrix.size = size;
+        matrix.rowStart.assign(size + 1, 0);
+        matrix.columns.clear();
+        matrix.blocks.clear();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry& entry = entries[i];
+            if (i > 0 && entry.row == entries[i - 1].row && entry.column == entries[i - 1].column) {
+                matrix.blocks.back() += entry.block;
+                continue;
+            }
+            matrix.rowStart[entry.row + 1]++;
+            matrix.columns.push_back(entry.column);
+            matrix.blocks.push_back(entry.block);
+        }
+        for (u32 r = 0; r < size; ++r) matrix.rowStart[r + 1] += matrix.rowStart[r];
+    }
+
+    struct Result {
+        u32 iterations = 0;
+        f64 residual = 0.0; // Relative to the right hand side
+        bool converged = false;
+    };
+
+    // Solves matrix * x = b starting from the guess already in x
+    inline Result SolveCG(const Matrix& matrix, const std::vector<f64>& b, std::vector<f64>& x, u32 maxIterations, f64 tolerance) {
+        const u32 n = matrix.size * 2;
+        Result result;
+
+        // Block Jacobi: the inverse of each row's diagonal block
+        std::vector<Block> inverse(matrix.size);
+        for (u32 r = 0; r < matrix.size; ++r) {
+            for (u32 k = matrix.rowStart[r]; k < matrix.rowStart[r + 1]; ++k) {
+                if (matrix.columns[k] != r) continue;
+                const f64* m = matrix.blocks[k].m;
+                const f64 det = m[0] * m[3] - m[1] * m[2];
+                if (std::fabs(det) > 1e-300) {
+                    inverse[r].m[0] = m[3] / det;
+                    inverse[r].m[1] = -m[1] / det;
+                    inverse[r].m[2] = -m[2] / det;
+                    inverse[r].m[3] = m[0] / det;
+                }
+            }
+        }
+        auto precondition = [&](const std::vector<f64>& in, std::vector<f64>& out) {
+            for (u32 r = 0; r < matrix.size; ++r) {
+                const f64* m = inverse[r].m;
+                out[r * 2] = m[0] * in[r * 2] + m[1] * in[r * 2 + 1];
+                out[r * 2 + 1] = m[2] * in[r * 2] + m[3] * in[r * 2 + 1];
+            }
+        };
+        auto dot = [n](const std::vector<f64>& a, const std::vector<f64>& c) {
+            f64 sum = 0.0;
+            for (u32 i = 0; i < n; ++i) sum += a[i] * c[i];
+            return sum;
+        };
+
+        std::vector<f64> r(n), z(n), p(n), ap(n);
+        matrix.Multiply(x, ap);
+        for (u32 i = 0; i < n; ++i) r[i] = b[i] - ap[i];
+
+        const f64 bNorm = std::max(std::sqrt(dot(b, b)), 1e-300);
+        result.residual = std::sqrt(dot(r, r)) / bNorm;
+        if (result.residual <= tolerance) {
+            result.converged = true;
+            return result;
+        }
+
+        precondition(r, z);
+        p = z;
+        f64 rz = dot(r, z);
+
+        for (result.iterations = 1; result.iterations <= maxIterations; ++result.iterations) {
+            matrix.Multiply(p, ap);
+            const f64 pap = dot(p, ap);
+            if (pap <= 0.0) break; // Lost positive definiteness to rounding
+
+            const f64 alpha = rz / pap;
+            for (u32 i = 0; i < n; ++i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * ap[i];
+            }
+
+            result.residual = std::sqrt(dot(r, r)) / bNorm;
+            if (result.residual <= tolerance) {
+                result.converged = true;
+                break;
+            }
+
+            precondition(r, z);
+            const f64 rzNext = dot(r, z);
+            const f64 beta = rzNext / rz;
+            rz = rzNext;
+            for (u32 i = 0; i < n; ++i) p[i] = z[i] + beta * p[i];
+        }
+        result.iterations = std::min(result.iterations, maxIterations);
+        return result;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+
+using namespace irr;
+using namespace core;
+
+// Uniform hash grid over a fixed set of points. Built in two linear passes
+// (count, then scatter) into flat arrays, so a rebuild allocates nothing once
+// the grid has seen a mesh of the same size.
+class SpatialGrid {
+public:
+    SpatialGrid() : _cellSize(1.0f), _invCellSize(1.0f), _mask(0) {}
+
+    void Build(const vector3df* points, u32 count, f32 cellSize) {
+        _cellSize = cellSize > ROUNDING_ERROR_f32 ? cellSize : 1.0f;
+        _invCellSize = 1.0f / _cellSize;
+        _points.assign(points, points + count);
+
+        u32 bucketCount = 64;
+        while (bucketCount < count) bucketCount <<= 1;
+        _mask = bucketCount - 1;
+
+        // 1. Count points per bucket
+        _bucketOf.resize(count);
+        _bucketStart.assign(bucketCount + 1, 0);
+        for (u32 i = 0; i < count; ++i) {
+            const vector3df& p = _points[i];
+            _bucketOf[i] = _bucket(_cell(p.X), _cell(p.Y), _cell(p.Z));
+            _bucketStart[_bucketOf[i] + 1]++;
+        }
+        for (u32 b = 0; b < bucketCount; ++b) _bucketStart[b + 1] += _bucketStart[b];
+
+        // 2. Scatter point ids into their buckets
+        _entries.resize(count);
+        _cursor.assign(_bucketStart.begin(), _bucketStart.end() - 1);
+        for (u32 i = 0; i < count; ++i) _entries[_cursor[_bucketOf[i]]++] = i;
+    }
+
+    // Calls fn(index, distanceSq) for every point within radius of centre
+    template<class Fn>
+    void QueryRadius(const vector3df& centre, f32 radius, Fn&& fn) const {
+        if (_entries.empty()) return;
+
+        const f32 radiusSq = radius * radius;
+        s32 minX = _cell(centre.X - radius), maxX = _cell(centre.X + radius);
+        s32 minY = _cell(centre.Y - radius), maxY = _cell(centre.Y + radius);
+        s32 minZ = _cell(centre.Z - radius), maxZ = _cell(centre.Z + radius);
+
+        // A query wider than the table would visit buckets repeatedly, scan everything instead
+        u64 cells = (u64)(maxX - minX + 1) * (u64)(maxY - minY + 1) * (u64)(maxZ - minZ + 1);
+        if (cells > _mask + 1) {
+            for (u32 i = 0; i < _points.size(); ++i) {
+                f32 distSq = _points[i].getDistanceFromSQ(centre);
+                if (distSq <= radiusSq) fn(i, distSq);
+            }
+            return;
+        }
+
+        for (s32 x = minX; x <= maxX; ++x) {
+            for (s32 y = minY; y <= maxY; ++y) {
+                for (s32 z = minZ; z <= maxZ; ++z) {
+                    u32 bucket = _bucket(x, y, z);
+                    for (u32 e = _bucketStart[bucket]; e < _bucketStart[bucket + 1]; ++e) {
+                        u32 i = _entries[e];
+                        const vector3df& p = _points[i];
+
+                        // Buckets are shared by hash collisions, only report the cell we asked for
+                        if (_cell(p.X) != x || _cell(p.Y) != y || _cell(p.Z) != z) continue;
+
+                        f32 distSq = p.getDistanceFromSQ(centre);
+                        if (distSq <= radiusSq) fn(i, distSq);
+                    }
+                }
+            }
+        }
+    }
+
+    u32 GetCount() const { return (u32)_points.size(); }
+    f32 GetCellSize() const { return _cellSize; }
+
+private:
+    f32 _cellSize;
+    f32 _invCellSize;
+    u32 _mask;
+
+    std::vector<vector3df> _points;
+    std::vector<u32> _bucketOf;
+    std::vector<u32> _bucketStart;
+    std::vector<u32> _cursor;
+    std::vector<u32> _entries;
+
+    s32 _cell(f32 value) const {
+        return (s32)std::floor(value * _invCellSize);
+    }
+
+    u32 _bucket(s32 x, s32 y, s32 z) const {
+        return ((u32)x * 73856093u ^ (u32)y * 19349663u ^ (u32)z * 83492791u) & _mask;
+    }
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+
+#include "helpers/FaceOps.h"
+#include "helpers/Parallel.h"
+#include "helpers/UVPack.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Collapses a model's textures into one atlas so buffers that differed only
+// by texture can share a material, then merges those buffers. Every buffer is
+// a draw call in each viewport, so fewer buffers is fewer draw calls.
+// Buffers whose UVs tile (leave 0-1) keep their own texture: an atlas
+// cannot repeat one of its parts.
+namespace TextureAtlas {
+    inline constexpr f32 UV_EPSILON = 0.0001f;
+    inline constexpr u32 MIN_SIZE = 16;
+    inline constexpr u32 NO_TEXTURE = 0xFFFFFFFF;
+
+    struct Settings {
+        // Edge texels repeated around each texture, so filtering never reaches
+        // a neighbour. The atlas is built without mipmaps, whose smaller levels
+        // would blend neighbours whatever the padding.
+        u32 paddingTexels = 4;
+        u32 maxSize = 4096;
+        u32 viewports = 4;     // Draw calls are counted for each
+    };
+
+    struct Report {
+        bool built = false;
+        u32 textures = 0;      // Packed into the atlas
+        u32 tiledBuffers = 0;  // Kept their own texture
+        u32 width = 0;
+        u32 height = 0;
+        f32 coverage = 0.0f;   // Atlas area holding texels
+        u32 buffersBefore = 0;
+        u32 buffersAfter = 0;
+        u32 drawCallsBefore = 0;
+        u32 drawCallsAfter = 0;
+        f64 milliseconds = 0.0;
+
+        void Print(const char* label) const {
+            if (!built) {
+                std::cout << label << ": nothing built" << std::endl;
+                return;
+            }
+            std::cout << label << ": " << textures << " textures in " << width << "x" << height << " ("
+                      << (u32)(coverage * 100.0f) << "% used), " << tiledBuffers << " tiled buffers kept, buffers "
+                      << buffersBefore << " -> " << buffersAfter << ", draw calls per frame " << drawCallsBefore
+                      << " -> " << drawCallsAfter << " in " << milliseconds << " ms" << std::endl;
+        }
+    };
+
+    struct Result {
+        SMesh* mesh = nullptr;       // Owned by the caller
+        ITexture* texture = nullptr; // Owned by the driver
+        // One per buffer of `mesh`, for the caller's scene node. Buffers that
+        // could not be merged are shared with the old mesh and keep its
+        // material, so they are never written to here.
+        std::vector<SMaterial> materials;
+    };
+
+    inline u32 NextPowerOfTwo(u32 value) {
+        u32 power = 1;
+        while (power < value) power <<= 1;
+        return power;
+    }
+
+    // Smallest power of two atlas the skyline fits every rectangle into
+    inline bool Layout(const std::vector<vector2df>& sizes, u32 maxSize, std::vector<UVPack::Placement>& placements,
+                       dimension2d<u32>& atlasSize) {
+        f32 area = 0.0f, widest = 0.0f;
+        for (const vector2df& size : sizes) {
+            area += size.X * size.Y;
+            widest = std::max(widest, size.X);
+        }
+        std::vector<u32> order(sizes.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return sizes[a].Y > sizes[b].Y; });
+
+        std::vector<UVPack::Placement> candidate;
+        u64 bestArea = 0;
+        for (u32 width = std::max(NextPowerOfTwo((u32)widest), MIN_SIZE); width <= maxSize; width <<= 1) {
+            f32 used;
+            const f32 height = UVPack::PackSkyline(sizes, order, (f32)width, false, candidate, used);
+            if (height > (f32)maxSize) continue;
+
+            const u32 atlasHeight = std::max(NextPowerOfTwo((u32)std::ceil(height)), MIN_SIZE);
+            const u64 atlasArea = (u64)width * atlasHeight;
+            // Equal areas keep the squarer, narrower one found first
+            if (bestArea == 0 || atlasArea < bestArea) {
+                bestArea = atlasArea;
+                atlasSize = dimension2d<u32>(width, atlasHeight);
+                placements = candidate;
+            }
+            if ((f32)width * width >= area * 4.0f) break; // Only wider and flatter from here
+        }
+        return bestArea != 0;
+    }
+
+    // Copies `source` into the atlas at (x, y) and repeats its edge texels `padding` deep
+    inline void Blit(const u32* source, u32 width, u32 height, u32* atlas, u32 atlasWidth, u32 atlasHeight,
+                     u32 x, u32 y, u32 padding) {
+        for (u32 row = 0; row < height; ++row) {
+            u32* target = atlas + (size_t)(y + row) * atlasWidth + x;
+            std::memcpy(target, source + (size_t)row * width, width * sizeof(u32));
+            for (u32 p = 1; p <= padding; ++p) {
+                if (x >= p) target[-(s32)p] = target[0];
+                if (x + width - 1 + p < atlasWidth) target[width - 1 + p] = target[width - 1];
+            }
+        }
+
+        const size_t spanStart = x >= padding ? x - padding : 0;
+        const size_t spanEnd = std::min(x + width + padding, atlasWidth);
+        const size_t spanBytes = (spanEnd - spanStart) * sizeof(u32);
+        for (u32 p = 1; p <= padding; ++p) {
+            if (y >= p)
+                std::memcpy(atlas + (size_t)(y - p) * atlasWidth + spanStart, atlas + (size_t)y * atlasWidth + spanStart, spanBytes);
+            if (y + height - 1 + p < atlasHeight)
+                std::memcpy(atlas + (size_t)(y + height - 1 + p) * atlasWidth + spanStart,
+                            atlas + (size_t)(y + height - 1) * atlasWidth + spanStart, spanBytes);
+        }
+    }
+
+    // `materials` holds what each of the mesh's buffers is drawn with (a
+    // scene node's copies, usually). The new mesh's buffers carry their
+    // final materials; atlased ones point at a new texture called `name`.
+    inline Report Build(IMesh* mesh, const std::vector<SMaterial>& materials, IVideoDriver* driver, const io::path& name,
+                        const Settings& settings, Result& result) {
+        auto start = std::chrono::steady_clock::now();
+        Report report;
+        result = Result();
+
+        const u32 bufferCount = std::min(mesh->getMeshBufferCount(), (u32)materials.size());
+        for (u32 b = 0; b < bufferCount; ++b) {
+            if (mesh->getMeshBuffer(b)->getIndexCount() > 0)
+                report.buffersBefore++;
+        }
+
+        // Which textures can go in: those of standard buffers whose UVs stay in 0-1
+        std::vector<ITexture*> textures;
+        std::vector<u32> textureOf(bufferCount, NO_TEXTURE);
+        for (u32 b = 0; b < bufferCount; ++b) {
+            IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            ITexture* texture = materials[b].getTexture(0);
+            if (!texture || mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT)
+                continue;
+
+            const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+            bool inside = true;
+            for (u32 v = 0; v < mb->getVertexCount() && inside; ++v) {
+                const vector2df& uv = vertices[v].TCoords;
+                inside = uv.X >= -UV_EPSILON && uv.Y >= -UV_EPSILON && uv.X <= 1.0f + UV_EPSILON && uv.Y <= 1.0f + UV_EPSILON;
+            }
+            if (!inside) {
+                report.tiledBuffers++;
+                continue;
+            }
+
+            auto found = std::find(textures.begin(), textures.end(), texture);
+            textureOf[b] = (u32)(found - textures.begin());
+            if (found == textures.end())
+                textures.push_back(texture);
+        }
+        if (textures.empty()) {
+            std::cout << "Texture atlas: no texture can go in an atlas" << std::endl;
+            return report;
+        }
+
+        const u32 padding = settings.paddingTexels;
+        std::vector<vector2df> sizes;
+        for (ITexture* texture : textures)
+            sizes.push_back(vector2df((f32)(texture->getSize().Width + padding * 2), (f32)(texture->getSize().Height + padding * 2)));
+
+        std::vector<UVPack::Placement> placements;
+        dimension2d<u32> atlasSize;
+        if (!Layout(sizes, settings.maxSize, placements, atlasSize)) {
+            std::cout << "Texture atlas: " << textures.size() << " textures do not fit in " << settings.maxSize << "x"
+                      << settings.maxSize << std::endl;
+            return report;
+        }
+
+        // Reading a texture back needs the driver, so that part stays on
+        // this thread; conversion and copying do not
+        std::vector<IImage*> images;
+        for (ITexture* texture : textures)
+            images.push_back(driver->createImage(texture, position2di(0, 0), texture->getSize()));
+
+        std::vector<u32> texels((size_t)atlasSize.Width * atlasSize.Height, 0);
+        Parallel::For((u32)textures.size(), 1, [&](u32 begin, u32 end) {
+            std::vector<u32> converted;
+            for (u32 t = begin; t < end; ++t) {
+                if (!images[t]) continue;
+                const dimension2d<u32> size = images[t]->getDimension();
+                converted.resize((size_t)size.Width * size.Height);
+                images[t]->copyToScaling(converted.data(), size.Width, size.Height, ECF_A8R8G8B8);
+                Blit(converted.data(), size.Width, size.Height, texels.data(), atlasSize.Width, atlasSize.Height,
+                     (u32)placements[t].x + padding, (u32)placements[t].y + padding, padding);
+            }
+        });
+        for (IImage* image : images) {
+            if (image) image->drop();
+        }
+
+        IImage* atlas = driver->createImageFromData(ECF_A8R8G8B8, atlasSize, texels.data(), true, false);
+        // Mip levels would blend neighbours once they shrink past the padding
+        const bool mipMaps = driver->getTextureCreationFlag(ETCF_CREATE_MIP_MAPS);
+        driver->setTextureCreationFlag(ETCF_CREATE_MIP_MAPS, false);
+        result.texture = atlas ? driver->addTexture(name, atlas) : nullptr;
+        driver->setTextureCreationFlag(ETCF_CREATE_MIP_MAPS, mipMaps);
+        if (atlas) atlas->drop();
+        if (!result.texture) {
+            std::cout << "Texture atlas: could not create a " << atlasSize.Width << "x" << atlasSize.Height << " texture" << std::endl;
+            return report;
+        }
+
+        // Each texture's 0-1 becomes its rectangle in the atlas
+        std::vector<rectf> rects;
+        f32 covered = 0.0f;
+        for (u32 t = 0; t < textures.size(); ++t) {
+            const dimension2d<u32> size = textures[t]->getSize();
+            const f32 x = placements[t].x + padding, y = placements[t].y + padding;
+            rects.push_back(rectf(x / atlasSize.Width, y / atlasSize.Height,
+                                  (x + size.Width) / atlasSize.Width, (y + size.Height) / atlasSize.Height));
+            covered += (f32)size.Width * size.Height;
+        }
+
+        // Buffers drawn the same way once the atlas is in go into one, as
+        // far as 16-bit indices allow. Buffers keep their order.
+        struct Group {
+            SMaterial material;
+            SMeshBuffer* buffer; // The one still taking vertices
+        };
+        std::vector<Group> groups;
+        SMesh* merged = new SMesh();
+        for (u32 b = 0; b < bufferCount; ++b) {
+            IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getIndexCount() == 0) continue;
+
+            if (mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT) {
+                // Nothing to merge it with; it goes across as it is
+                merged->addMeshBuffer(mb);
+                result.materials.push_back(materials[b]);
+                continue;
+            }
+
+            SMaterial material = materials[b];
+            if (textureOf[b] != NO_TEXTURE)
+                material.setTexture(0, result.texture);
+
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const Group& g) {
+                return g.material == material && g.buffer->Vertices.size() + mb->getVertexCount() <= FaceOps::MAX_VERTICES;
+            });
+            if (group == groups.end()) {
+                SMeshBuffer* buffer = new SMeshBuffer();
+                buffer->Material = material;
+                buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+                buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Index(), EBT_INDEX);
+                merged->addMeshBuffer(buffer);
+                result.materials.push_back(material);
+                buffer->drop();
+                // A full group is left behind; later buffers start a new one
+                groups.erase(std::remove_if(groups.begin(), groups.end(), [&](const Group& g) { return g.material == material; }), groups.end());
+                groups.push_back(Group{ material, buffer });
+                group = groups.end() - 1;
+            }
+
+            SMeshBuffer* buffer = group->buffer;
+            const u32 base = buffer->Vertices.size();
+            const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+            const u16* indices = mb->getIndices();
+            buffer->Vertices.reallocate(base + mb->getVertexCount());
+            buffer->Indices.reallocate(buffer->Indices.size() + mb->getIndexCount());
+            for (u32 v = 0; v < mb->getVertexCount(); ++v) {
+                S3DVertex vertex = vertices[v];
+                if (textureOf[b] != NO_TEXTURE) {
+                    const rectf& rect = rects[textureOf[b]];
+                    vertex.TCoords.X = rect.UpperLeftCorner.X + vertex.TCoords.X * rect.getWidth();
+                    vertex.TCoords.Y = rect.UpperLeftCorner.Y + vertex.TCoords.Y * rect.getHeight();
+                }
+                buffer->Vertices.push_back(vertex);
+            }
+            for (u32 i = 0; i < mb->getIndexCount(); ++i)
+                buffer->Indices.push_back((u16)(base + indices[i]));
+        }
+
+        for (u32 b = 0; b < merged->getMeshBufferCount(); ++b)
+            merged->getMeshBuffer(b)->recalculateBoundingBox();
+        merged->recalculateBoundingBox();
+        merged->setDirty();
+        result.mesh = merged;
+
+        report.built = true;
+        report.textures = (u32)textures.size();
+        report.width = atlasSize.Width;
+        report.height = atlasSize.Height;
+        report.coverage = covered / ((f32)atlasSize.Width * atlasSize.Height);
+        report.buffersAfter = merged->getMeshBufferCount();
+        report.drawCallsBefore = report.buffersBefore * settings.viewports;
+        report.drawCallsAfter = report.buffersAfter * settings.viewports;
+        report.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+}
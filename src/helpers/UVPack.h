@@ -0,0 +1,391 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <chrono>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+
+#include "helpers/Parallel.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// UV island packing for the small (32-256 px) PS1 style textures.
+//
+// Islands come from the seam topology: triangles sharing a vertex are in
+// the same island, and so are triangles whose edges only differ by
+// vertices split for normals (same position, same UV), so only real UV
+// seams separate islands. Islands keep their relative UV size and are packed with a
+// skyline packer, optionally rotated by 90 degrees, into the unit square.
+//
+// Several candidate layouts (bin widths and island orders) are packed in
+// parallel and the one with the smallest square wins, ties going to the
+// lower candidate, so the result never depends on the thread count.
+namespace UVPack {
+    inline constexpr f32 POSITION_EPSILON = 0.0001f;
+    inline constexpr f32 UV_EPSILON = 0.0001f;
+    inline constexpr u32 NO_ISLAND = 0xFFFFFFFF;
+    inline constexpr f32 MIN_ISLAND_SIZE = 1e-5f;    // Islands collapsed to a point or line
+    inline constexpr u32 WIDTH_CANDIDATES = 8;
+    inline constexpr f32 WIDTH_STEP = 0.1f;          // Each candidate's bin is this much wider
+    inline constexpr u32 PADDING_PASSES = 6;         // Padding is in final UVs, the scale comes from packing
+    inline constexpr f32 PADDING_OVERSHOOT = 1.05f;  // Aim a little wide so the passes settle from above
+
+    struct Settings {
+        bool allowRotation = true;
+        f32 paddingTexels = 2.0f; // Gap around every island
+        u32 textureSize = 256;    // Converts the padding to UV
+    };
+
+    struct Report {
+        u32 islands = 0;
+        u32 rotated = 0;
+        u32 candidates = 0;
+        f32 coverage = 0.0f; // Island area over the unit square
+        f64 milliseconds = 0.0;
+
+        void Print(const char* label) const {
+            std::cout << label << ": " << islands << " islands (" << rotated << " rotated), "
+                      << candidates << " candidate layouts, " << (u32)(coverage * 100.0f + 0.5f)
+                      << "% coverage in " << milliseconds << " ms" << std::endl;
+        }
+    };
+
+    struct Island {
+        u32 buffer;
+        std::vector<u32> vertices;
+        vector2df min;
+        vector2df max;
+
+        vector2df Size() const {
+            return vector2df(std::max(max.X - min.X, MIN_ISLAND_SIZE), std::max(max.Y - min.Y, MIN_ISLAND_SIZE));
+        }
+    };
+
+    // Lower-left corner in packing units; a rotated island is Size() turned
+    // a quarter, so it is as wide as it was tall
+    struct Placement {
+        f32 x = 0.0f;
+        f32 y = 0.0f;
+        bool rotated = false;
+    };
+
+    inline u32 FindRoot(std::vector<u32>& parent, u32 v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+
+    inline void Join(std::vector<u32>& parent, u32 a, u32 b) {
+        a = FindRoot(parent, a);
+        b = FindRoot(parent, b);
+        // The lower index stays root so island order follows vertex order
+        if (a < b) parent[b] = a;
+        else if (b < a) parent[a] = b;
+    }
+
+    // A triangle edge between welded vertices
+    struct Edge {
+        u32 a, b; // Welded ends, a < b
+        u32 triangle;
+    };
+
+    // Same position and UV: split for a hard edge, not a seam. `weld` maps
+    // each vertex to the lowest such copy; `edges` holds every triangle
+    // edge in welded ends, sorted so that shared edges are adjacent.
+    inline void BuildSeams(const IMeshBuffer* mb, std::vector<u32>& weld, std::vector<Edge>& edges) {
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+        const u32 vertexCount = mb->getVertexCount();
+        const u32 indexCount = mb->getIndexCount() - mb->getIndexCount() % 3;
+
+        struct Key {
+            s32 q[5];
+            u32 vertex;
+        };
+        std::vector<Key> keys(vertexCount);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            const S3DVertex& vertex = vertices[v];
+            keys[v] = { { (s32)std::floor(vertex.Pos.X / POSITION_EPSILON), (s32)std::floor(vertex.Pos.Y / POSITION_EPSILON),
+                          (s32)std::floor(vertex.Pos.Z / POSITION_EPSILON), (s32)std::floor(vertex.TCoords.X / UV_EPSILON),
+                          (s32)std::floor(vertex.TCoords.Y / UV_EPSILON) }, v };
+        }
+        std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+            for (u32 k = 0; k < 5; ++k) {
+                if (a.q[k] != b.q[k]) return a.q[k] < b.q[k];
+            }
+            return a.vertex < b.vertex;
+        });
+        weld.resize(vertexCount);
+        for (size_t k = 0; k < keys.size(); ++k) {
+            const bool same = k > 0 && std::equal(keys[k].q, keys[k].q + 5, keys[k - 1].q);
+            weld[keys[k].vertex] = same ? weld[keys[k - 1].vertex] : keys[k].vertex;
+        }
+
+        edges.clear();
+        edges.reserve(indexCount);
+        for (u32 i = 0; i < indexCount; i += 3) {
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 a = weld[indices[i + k]], b = weld[indices[i + (k + 1) % 3]];
+                if (a != b)
+                    edges.push_back({ std::min(a, b), std::max(a, b), i / 3 });
+            }
+        }
+        std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) {
+            return x.a != y.a ? x.a < y.a : x.b != y.b ? x.b < y.b : x.triangle < y.triangle;
+        });
+    }
+
+    // Island of every vertex (NO_ISLAND when no triangle uses it), numbered
+    // in vertex order. Triangles sharing a vertex are one island, and so are
+    // triangles sharing a welded edge; copies that merely touch at a corner
+    // are a seam that happens to line up. Returns the island count.
+    inline u32 LabelIslands(const IMeshBuffer* mb, const std::vector<Edge>& edges, std::vector<u32>& islandOf) {
+        const u16* indices = mb->getIndices();
+        const u32 vertexCount = mb->getVertexCount();
+        const u32 indexCount = mb->getIndexCount() - mb->getIndexCount() % 3;
+
+        std::vector<u32> parent(vertexCount);
+        std::iota(parent.begin(), parent.end(), 0u);
+        std::vector<u8> used(vertexCount, 0);
+
+        for (u32 i = 0; i < indexCount; i += 3) {
+            Join(parent, indices[i], indices[i + 1]);
+            Join(parent, indices[i], indices[i + 2]);
+            used[indices[i]] = used[indices[i + 1]] = used[indices[i + 2]] = 1;
+        }
+        for (size_t e = 1; e < edges.size(); ++e) {
+            if (edges[e].a == edges[e - 1].a && edges[e].b == edges[e - 1].b)
+                Join(parent, indices[edges[e].triangle * 3], indices[edges[e - 1].triangle * 3]);
+        }
+
+        // Roots are the lowest vertex of their island
+        u32 count = 0;
+        islandOf.assign(vertexCount, NO_ISLAND);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            if (!used[v]) continue;
+            const u32 root = FindRoot(parent, v);
+            if (islandOf[root] == NO_ISLAND)
+                islandOf[root] = count++;
+            islandOf[v] = islandOf[root];
+        }
+        return count;
+    }
+
+    inline void ExtractIslands(const IMeshBuffer* mb, u32 bufferIndex, std::vector<Island>& islands) {
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        std::vector<u32> weld, islandOf;
+        std::vector<Edge> edges;
+        BuildSeams(mb, weld, edges);
+        const u32 first = (u32)islands.size();
+        islands.resize(first + LabelIslands(mb, edges, islandOf));
+
+        for (u32 v = 0; v < mb->getVertexCount(); ++v) {
+            if (islandOf[v] == NO_ISLAND) continue;
+            Island& island = islands[first + islandOf[v]];
+            const vector2df& uv = vertices[v].TCoords;
+            if (island.vertices.empty()) {
+                island.buffer = bufferIndex;
+                island.min = island.max = uv;
+            }
+            island.vertices.push_back(v);
+            island.min.X = std::min(island.min.X, uv.X);
+            island.min.Y = std::min(island.min.Y, uv.Y);
+            island.max.X = std::max(island.max.X, uv.X);
+            island.max.Y = std::max(island.max.Y, uv.Y);
+        }
+    }
+
+    // Bottom-left skyline: each rectangle goes where its top ends lowest.
+    // `sizes` already include padding. Returns the packed height; `width`
+    // receives the widest extent actually used.
+    inline f32 PackSkyline(const std::vector<vector2df>& sizes, const std::vector<u32>& order, f32 binWidth,
+                           bool allowRotation, std::vector<Placement>& placements, f32& width) {
+        struct Segment { f32 x, y, w; };
+        std::vector<Segment> skyline = { { 0.0f, 0.0f, binWidth } };
+        const f32 epsilon = binWidth * 1e-6f; // Segment widths only sum to binWidth approximately
+        placements.assign(sizes.size(), Placement());
+        f32 height = 0.0f;
+        width = 0.0f;
+
+        // Lowest y a rectangle of width w can rest at when it starts at segment i
+        auto restingY = [&](size_t i, f32 w, f32& y) {
+            if (skyline[i].x + w > binWidth + epsilon) return false;
+            y = 0.0f;
+            f32 remaining = w;
+            for (size_t j = i; remaining > epsilon; ++j) {
+                if (j == skyline.size()) return false;
+                y = std::max(y, skyline[j].y);
+                remaining -= skyline[j].w;
+            }
+            return true;
+        };
+
+        for (u32 index : order) {
+            const vector2df size = sizes[index];
+            size_t bestSegment = skyline.size();
+            f32 bestTop = FLT_MAX, bestY = 0.0f;
+            bool bestRotated = false;
+
+            for (size_t i = 0; i < skyline.size(); ++i) {
+                for (u32 turn = 0; turn < (allowRotation ? 2u : 1u); ++turn) {
+                    const f32 w = turn ? size.Y : size.X;
+                    const f32 h = turn ? size.X : size.Y;
+                    f32 y;
+                    // Resting here is never lower than the segment itself
+                    if (skyline[i].y + h >= bestTop || !restingY(i, w, y) || y + h >= bestTop) continue;
+                    bestTop = y + h;
+                    bestY = y;
+                    bestSegment = i;
+                    bestRotated = turn != 0;
+                }
+            }
+            if (bestSegment == skyline.size())
+                return FLT_MAX; // Wider than the bin
+
+            const f32 w = bestRotated ? size.Y : size.X;
+            const f32 x = skyline[bestSegment].x;
+            placements[index] = { x, bestY, bestRotated };
+            height = std::max(height, bestTop);
+            width = std::max(width, x + w);
+
+            // Raise the skyline under the rectangle, trimming what it covers
+            skyline.insert(skyline.begin() + bestSegment, Segment{ x, bestTop, w });
+            for (size_t j = bestSegment + 1; j < skyline.size();) {
+                const f32 overlap = x + w - skyline[j].x;
+                if (overlap <= epsilon) break;
+                if (overlap < skyline[j].w - epsilon) {
+                    skyline[j].x += overlap;
+                    skyline[j].w -= overlap;
+                    break;
+                }
+                skyline.erase(skyline.begin() + j);
+            }
+            for (size_t j = 1; j < skyline.size();) {
+                if (skyline[j].y == skyline[j - 1].y) {
+                    skyline[j - 1].w += skyline[j].w;
+                    skyline.erase(skyline.begin() + j);
+                } else {
+                    ++j;
+                }
+            }
+        }
+        return height;
+    }
+
+    struct Layout {
+        std::vector<Placement> placements;
+        f32 side = FLT_MAX; // Square holding every island, in packing units
+    };
+
+    // Packs every candidate on its own worker and keeps the smallest square
+    inline Layout PackCandidates(const std::vector<Island>& islands, f32 padding, bool allowRotation, u32& candidateCount) {
+        const u32 count = (u32)islands.size();
+        std::vector<vector2df> sizes(count);
+        f32 area = 0.0f, widest = 0.0f;
+        for (u32 i = 0; i < count; ++i) {
+            sizes[i] = islands[i].Size() + vector2df(padding, padding);
+            area += sizes[i].X * sizes[i].Y;
+            widest = std::max(widest, allowRotation ? std::min(sizes[i].X, sizes[i].Y) : sizes[i].X);
+        }
+
+        // Tallest first, or largest first; both settle big islands before the gaps fill
+        std::vector<u32> orders[2];
+        for (std::vector<u32>& order : orders) {
+            order.resize(count);
+            std::iota(order.begin(), order.end(), 0u);
+        }
+        auto tallest = [&](u32 i) { return allowRotation ? std::max(sizes[i].X, sizes[i].Y) : sizes[i].Y; };
+        std::stable_sort(orders[0].begin(), orders[0].end(), [&](u32 a, u32 b) { return tallest(a) > tallest(b); });
+        std::stable_sort(orders[1].begin(), orders[1].end(), [&](u32 a, u32 b) {
+            return sizes[a].X * sizes[a].Y > sizes[b].X * sizes[b].Y;
+        });
+
+        candidateCount = WIDTH_CANDIDATES * 2;
+        std::vector<Layout> layouts(candidateCount);
+        Parallel::For(candidateCount, 1, [&](u32 begin, u32 end) {
+            for (u32 c = begin; c < end; ++c) {
+                const f32 binWidth = std::max(std::sqrt(area) * (1.0f + WIDTH_STEP * (c % WIDTH_CANDIDATES)), widest);
+                f32 width;
+                const f32 height = PackSkyline(sizes, orders[c / WIDTH_CANDIDATES], binWidth, allowRotation, layouts[c].placements, width);
+                layouts[c].side = std::max(width, height);
+            }
+        });
+
+        u32 best = 0;
+        for (u32 c = 1; c < candidateCount; ++c) {
+            if (layouts[c].side < layouts[best].side)
+                best = c;
+        }
+        return std::move(layouts[best]);
+    }
+
+    // Repacks every standard buffer's islands into one unit square layout
+    inline Report Run(IMesh* mesh, const Settings& settings) {
+        auto start = std::chrono::steady_clock::now();
+        Report report;
+
+        std::vector<Island> islands;
+        for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+            const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getVertexType() == EVT_STANDARD)
+                ExtractIslands(mb, b, islands);
+        }
+        report.islands = (u32)islands.size();
+        if (islands.empty())
+            return report;
+
+        // The padding is fixed in texels, but the texel size in packing
+        // units depends on the packed square; a few passes settle it
+        const f32 margin = settings.paddingTexels / (f32)std::max(settings.textureSize, 1u);
+        f32 padding = 0.0f;
+        Layout layout;
+        for (u32 pass = 0; pass < PADDING_PASSES; ++pass) {
+            u32 candidates = 0;
+            layout = PackCandidates(islands, padding, settings.allowRotation, candidates);
+            report.candidates += candidates;
+            if (margin <= 0.0f || padding >= margin * layout.side)
+                break;
+            padding = margin * layout.side * PADDING_OVERSHOOT;
+        }
+
+        // Packing units to UV; half the padding sits on each side of an island
+        const f32 scale = 1.0f / layout.side;
+        f32 islandArea = 0.0f;
+        std::vector<u8> touched(mesh->getMeshBufferCount(), 0);
+        for (u32 i = 0; i < (u32)islands.size(); ++i) {
+            const Island& island = islands[i];
+            const Placement& placement = layout.placements[i];
+            const vector2df size = island.Size();
+            islandArea += size.X * size.Y * scale * scale;
+            report.rotated += placement.rotated ? 1 : 0;
+
+            S3DVertex* vertices = (S3DVertex*)mesh->getMeshBuffer(island.buffer)->getVertices();
+            const vector2df corner(placement.x + padding * 0.5f, placement.y + padding * 0.5f);
+            for (u32 v : island.vertices) {
+                vector2df local = vertices[v].TCoords - island.min;
+                if (placement.rotated)
+                    local = vector2df(local.Y, size.X - local.X); // A quarter turn, not a mirror
+                vertices[v].TCoords = (corner + local) * scale;
+            }
+            touched[island.buffer] = 1;
+        }
+
+        for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+            if (touched[b])
+                mesh->getMeshBuffer(b)->setDirty(EBT_VERTEX);
+        }
+
+        report.coverage = islandArea;
+        report.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+}
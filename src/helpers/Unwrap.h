@@ -0,0 +1,433 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "helpers/FaceOps.h"
+#include "helpers/Parallel.h"
+#include "helpers/SparseSolver.h"
+#include "helpers/UVPack.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Least squares conformal maps (LSCM) UV unwrapping.
+//
+// Charts are the mesh's UV islands, so existing seams stay where they are.
+// An island with no boundary, or too little of one to open flat (a closed
+// mesh imported without UVs, a sphere with a single seam), is split by the
+// dominant axis of its faces, and vertices shared across the cut are
+// duplicated.
+//
+// Each chart's conformal energy becomes a sparse system over the (u, v)
+// of its welded vertices, with the two vertices furthest apart pinned.
+// Charts are independent, so they are handed out to workers largest first
+// and solved with block Jacobi preconditioned CG, warm started from a
+// projection onto the chart's mean plane. The result is in world units;
+// UVPack scales and places the charts afterwards.
+namespace Unwrap {
+    inline constexpr u32 MAX_ITERATIONS = 5000;
+    inline constexpr f64 TOLERANCE = 1e-6;        // Relative residual
+    inline constexpr f64 REGULARISATION = 1e-8;   // Of the mean diagonal; holds vertices only degenerate faces touch
+    inline constexpr f64 DEGENERATE_AREA = 1e-12; // Twice the area
+    inline constexpr u32 REPORT_CHARTS = 5;       // Slowest charts printed
+    // Boundary length squared over pi times area: a flat disc has 4, a
+    // hemisphere 2, a sphere slit along a meridian 1. Islands below this
+    // are cut up before unwrapping.
+    inline constexpr f64 MIN_BOUNDARY_RATIO = 1.5;
+    inline constexpr u32 NONE = 0xFFFFFFFF;
+
+    struct ChartReport {
+        u32 buffer = 0;
+        u32 faces = 0;
+        u32 vertices = 0;
+        u32 iterations = 0;
+        bool converged = true;
+        f64 milliseconds = 0.0;
+    };
+
+    struct Report {
+        u32 charts = 0;
+        u32 faces = 0;
+        u32 splitVertices = 0;  // Copies made cutting closed islands
+        u32 skippedBuffers = 0; // Cutting would have passed 16-bit indices
+        f64 milliseconds = 0.0;
+        std::vector<ChartReport> chartReports;
+
+        void Print(const char* label) const {
+            u32 unconverged = 0;
+            for (const ChartReport& chart : chartReports) unconverged += chart.converged ? 0 : 1;
+            std::cout << label << ": " << charts << " charts, " << faces << " faces, " << splitVertices
+                      << " vertices split, " << unconverged << " unconverged in " << milliseconds << " ms" << std::endl;
+            if (skippedBuffers > 0)
+                std::cout << label << ": skipped " << skippedBuffers << " buffers (would exceed 65535 vertices)" << std::endl;
+
+            std::vector<ChartReport> slowest = chartReports;
+            std::stable_sort(slowest.begin(), slowest.end(), [](const ChartReport& a, const ChartReport& b) {
+                return a.milliseconds > b.milliseconds;
+            });
+            for (size_t i = 0; i < slowest.size() && i < REPORT_CHARTS; ++i) {
+                const ChartReport& chart = slowest[i];
+                std::cout << "  buffer " << chart.buffer << ": " << chart.faces << " faces, " << chart.vertices
+                          << " vertices, " << chart.iterations << " CG iterations"
+                          << (chart.converged ? "" : " (not converged)") << ", " << chart.milliseconds << " ms" << std::endl;
+            }
+        }
+    };
+
+    struct Chart {
+        u32 buffer;
+        std::vector<u32> triangles;
+    };
+
+    // 0-5 for +X, -X, +Y, -Y, +Z, -Z; NO_AXIS for a degenerate face
+    inline constexpr u32 NO_AXIS = 6;
+    inline u32 AxisOf(const vector3df& normal) {
+        if (normal.getLengthSQ() <= 0.0f) return NO_AXIS;
+        const f32 ax = std::fabs(normal.X), ay = std::fabs(normal.Y), az = std::fabs(normal.Z);
+        if (ax >= ay && ax >= az) return normal.X >= 0.0f ? 0 : 1;
+        if (ay >= az) return normal.Y >= 0.0f ? 2 : 3;
+        return normal.Z >= 0.0f ? 4 : 5;
+    }
+
+    // Appends the buffer's charts. `weld` receives UVPack's welded vertex of
+    // every vertex, copies included. Returns false, leaving the buffer as
+    // it was, when the copies would not fit in 16-bit indices.
+    inline bool BuildCharts(SMeshBuffer* buffer, u32 bufferIndex, std::vector<Chart>& charts, std::vector<u32>& weld, u32& split) {
+        std::vector<UVPack::Edge> edges;
+        std::vector<u32> islandOf;
+        UVPack::BuildSeams(buffer, weld, edges);
+        const u32 islandCount = UVPack::LabelIslands(buffer, edges, islandOf);
+
+        const S3DVertex* vertices = buffer->Vertices.const_pointer();
+        u16* indices = buffer->Indices.pointer();
+        const u32 vertexCount = buffer->Vertices.size();
+        const u32 triangleCount = buffer->Indices.size() / 3;
+
+        // An edge only one triangle uses is a boundary. An island whose
+        // boundary is short for its area is (nearly) closed and cannot be
+        // flattened in one piece.
+        std::vector<f64> boundary(islandCount, 0.0), area(islandCount, 0.0);
+        for (size_t e = 0; e < edges.size();) {
+            size_t end = e + 1;
+            while (end < edges.size() && edges[end].a == edges[e].a && edges[end].b == edges[e].b) ++end;
+            if (end - e == 1)
+                boundary[islandOf[indices[edges[e].triangle * 3]]] += vertices[edges[e].a].Pos.getDistanceFrom(vertices[edges[e].b].Pos);
+            e = end;
+        }
+        std::vector<u32> axis(triangleCount);
+        for (u32 t = 0; t < triangleCount; ++t) {
+            const u16* tri = indices + t * 3;
+            const vector3df normal = (vertices[tri[1]].Pos - vertices[tri[0]].Pos).crossProduct(vertices[tri[2]].Pos - vertices[tri[0]].Pos);
+            axis[t] = AxisOf(normal);
+            area[islandOf[tri[0]]] += normal.getLength() * 0.5;
+        }
+        std::vector<u8> open(islandCount);
+        for (u32 i = 0; i < islandCount; ++i)
+            open[i] = boundary[i] * boundary[i] >= MIN_BOUNDARY_RATIO * PI64 * area[i];
+
+        // Closed islands: faces facing the same axis across a shared edge
+        // stay together. A degenerate face (a pole's sliver) faces nowhere
+        // and joins its first neighbour, so it never bridges two pieces.
+        std::vector<u32> parent(triangleCount);
+        for (u32 t = 0; t < triangleCount; ++t) parent[t] = t;
+        for (size_t e = 1; e < edges.size(); ++e) {
+            u32 t0 = edges[e - 1].triangle, t1 = edges[e].triangle;
+            if (edges[e].a != edges[e - 1].a || edges[e].b != edges[e - 1].b || open[islandOf[indices[t1 * 3]]])
+                continue;
+            if (axis[t1] == NO_AXIS) std::swap(t0, t1);
+            if (axis[t0] == NO_AXIS && axis[t1] != NO_AXIS) {
+                UVPack::Join(parent, t0, t1);
+                axis[t0] = NO_AXIS + 1; // Attached; matches nothing from now on
+            } else if (axis[t0] == axis[t1] && axis[t0] < NO_AXIS) {
+                UVPack::Join(parent, t0, t1);
+            }
+        }
+
+        // Charts numbered in triangle order: one per open island, one per closed piece
+        const u32 firstChart = (u32)charts.size();
+        std::vector<u32> chartOf(triangleCount);
+        std::vector<u32> islandChart(islandCount, NONE), rootChart(triangleCount, NONE);
+        for (u32 t = 0; t < triangleCount; ++t) {
+            const u32 island = islandOf[indices[t * 3]];
+            u32& chart = open[island] ? islandChart[island] : rootChart[UVPack::FindRoot(parent, t)];
+            if (chart == NONE) {
+                chart = (u32)charts.size();
+                charts.push_back(Chart{ bufferIndex, {} });
+            }
+            charts[chart].triangles.push_back(t);
+            chartOf[t] = chart;
+        }
+
+        // A vertex stays with the first chart using it; the others get copies
+        struct Copy {
+            u32 chart;
+            u32 vertex;
+            u32 next;
+        };
+        std::vector<u32> owner(vertexCount, NONE), firstCopy(vertexCount, NONE);
+        std::vector<Copy> copies;
+        std::vector<u32> source; // Per copy
+        std::vector<u32> remapped(triangleCount * 3);
+        for (u32 i = 0; i < triangleCount * 3; ++i) {
+            const u32 v = indices[i], chart = chartOf[i / 3];
+            if (owner[v] == NONE) owner[v] = chart;
+            if (owner[v] == chart) {
+                remapped[i] = v;
+                continue;
+            }
+
+            u32 copy = firstCopy[v];
+            while (copy != NONE && copies[copy].chart != chart) copy = copies[copy].next;
+            if (copy == NONE) {
+                copies.push_back({ chart, vertexCount + (u32)copies.size(), firstCopy[v] });
+                source.push_back(v);
+                copy = firstCopy[v] = (u32)copies.size() - 1;
+            }
+            remapped[i] = copies[copy].vertex;
+        }
+
+        if (vertexCount + copies.size() > FaceOps::MAX_VERTICES) {
+            charts.resize(firstChart);
+            return false;
+        }
+        if (copies.empty())
+            return true;
+
+        buffer->Vertices.reallocate(vertexCount + (u32)copies.size());
+        for (u32 c = 0; c < (u32)copies.size(); ++c) {
+            buffer->Vertices.push_back(buffer->Vertices[source[c]]);
+            weld.push_back(weld[source[c]]);
+        }
+        indices = buffer->Indices.pointer();
+        for (u32 i = 0; i < triangleCount * 3; ++i) indices[i] = (u16)remapped[i];
+        split += (u32)copies.size();
+        return true;
+    }
+
+    // LSCM for one chart; writes the UVs of every vertex the chart uses.
+    // `localOf` is NONE for every welded vertex and is left that way.
+    inline ChartReport SolveChart(S3DVertex* vertices, const u16* indices, const std::vector<u32>& weld,
+                                  const Chart& chart, std::vector<u32>& localOf) {
+        auto start = std::chrono::steady_clock::now();
+        ChartReport report;
+        report.buffer = chart.buffer;
+        report.faces = (u32)chart.triangles.size();
+
+        // Unknowns are welded vertices, so copies split for normals move together
+        std::vector<u32> locals;
+        for (u32 t : chart.triangles) {
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 w = weld[indices[t * 3 + k]];
+                if (localOf[w] == NONE) {
+                    localOf[w] = (u32)locals.size();
+                    locals.push_back(w);
+                }
+            }
+        }
+        const u32 n = (u32)locals.size();
+        report.vertices = n;
+
+        std::vector<vector3df> positions(n);
+        for (u32 i = 0; i < n; ++i) positions[i] = vertices[locals[i]].Pos;
+
+        // Pins: two sweeps for a pair of vertices far apart
+        auto furthest = [&](u32 from) {
+            u32 best = from;
+            f32 bestSq = -1.0f;
+            for (u32 i = 0; i < n; ++i) {
+                const f32 distanceSq = positions[i].getDistanceFromSQ(positions[from]);
+                if (distanceSq > bestSq) { bestSq = distanceSq; best = i; }
+            }
+            return best;
+        };
+        const u32 pinA = furthest(0);
+        const u32 pinB = furthest(pinA);
+        const f64 span = positions[pinA].getDistanceFrom(positions[pinB]);
+
+        // Warm start: projection onto the mean plane, turned and scaled onto the pins
+        vector3df normal(0.0f, 0.0f, 0.0f);
+        for (u32 t : chart.triangles) {
+            const u16* tri = indices + t * 3;
+            normal += (vertices[tri[1]].Pos - vertices[tri[0]].Pos).crossProduct(vertices[tri[2]].Pos - vertices[tri[0]].Pos);
+        }
+        vector3df xAxis = positions[pinB] - positions[pinA];
+        if (normal.getLengthSQ() > 0.0f) {
+            normal.normalize();
+            xAxis -= normal * xAxis.dotProduct(normal);
+        }
+        if (xAxis.getLengthSQ() <= 0.0f || normal.getLengthSQ() <= 0.0f) {
+            // Nothing to unfold (collapsed chart): leave the UVs alone
+            for (u32 w : locals) localOf[w] = NONE;
+            return report;
+        }
+        const f64 xScale = span / xAxis.getLength();
+        xAxis.normalize();
+        const vector3df yAxis = normal.crossProduct(xAxis);
+
+        std::vector<f64> guess(n * 2);
+        for (u32 i = 0; i < n; ++i) {
+            const vector3df offset = positions[i] - positions[pinA];
+            guess[i * 2] = offset.dotProduct(xAxis) * xScale;
+            guess[i * 2 + 1] = offset.dotProduct(yAxis) * xScale;
+        }
+        guess[pinA * 2] = guess[pinA * 2 + 1] = 0.0;
+        guess[pinB * 2] = span;
+        guess[pinB * 2 + 1] = 0.0;
+
+        std::vector<u32> freeOf(n, NONE);
+        u32 freeCount = 0;
+        for (u32 i = 0; i < n; ++i) {
+            if (i != pinA && i != pinB) freeOf[i] = freeCount++;
+        }
+
+        // Per face, in its own plane: the gradient of each corner's hat
+        // function, g. Conformality asks du/dx = dv/dy and du/dy = -dv/dx;
+        // the two residuals, weighted by area, give each pair of corners a
+        // 2x2 block of the normal equations.
+        std::vector<SparseSolver::Entry> entries;
+        entries.reserve(chart.triangles.size() * 9);
+        std::vector<f64> rhs(freeCount * 2, 0.0);
+        f64 diagonal = 0.0;
+        for (u32 t : chart.triangles) {
+            u32 corner[3];
+            for (u32 k = 0; k < 3; ++k) corner[k] = localOf[weld[indices[t * 3 + k]]];
+
+            const vector3df e1 = positions[corner[1]] - positions[corner[0]];
+            const vector3df e2 = positions[corner[2]] - positions[corner[0]];
+            const vector3df faceNormal = e1.crossProduct(e2);
+            const f64 doubleArea = faceNormal.getLength();
+            if (doubleArea <= DEGENERATE_AREA || e1.getLengthSQ() <= 0.0f) continue;
+
+            const vector3df ex = e1 / e1.getLength();
+            const vector3df ey = (faceNormal / (f32)doubleArea).crossProduct(ex);
+            const f64 x[3] = { 0.0, e1.getLength(), e2.dotProduct(ex) };
+            const f64 y[3] = { 0.0, 0.0, e2.dotProduct(ey) };
+
+            f64 gx[3], gy[3];
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 k1 = (k + 1) % 3, k2 = (k + 2) % 3;
+                gx[k] = (y[k1] - y[k2]) / doubleArea;
+                gy[k] = (x[k2] - x[k1]) / doubleArea;
+            }
+
+            const f64 area = doubleArea * 0.5;
+            for (u32 a = 0; a < 3; ++a) {
+                const u32 row = freeOf[corner[a]];
+                if (row == NONE) continue;
+                for (u32 b = 0; b < 3; ++b) {
+                    SparseSolver::Block block;
+                    block.m[0] = area * (gx[a] * gx[b] + gy[a] * gy[b]);
+                    block.m[1] = area * (gy[a] * gx[b] - gx[a] * gy[b]);
+                    block.m[2] = area * (gx[a] * gy[b] - gy[a] * gx[b]);
+                    block.m[3] = block.m[0];
+                    if (a == b) diagonal += block.m[0];
+
+                    const u32 column = freeOf[corner[b]];
+                    if (column != NONE) {
+                        entries.push_back({ row, column, block });
+                    } else {
+                        const f64 u = guess[corner[b] * 2], v = guess[corner[b] * 2 + 1];
+                        rhs[row * 2] -= block.m[0] * u + block.m[1] * v;
+                        rhs[row * 2 + 1] -= block.m[2] * u + block.m[3] * v;
+                    }
+                }
+            }
+        }
+
+        std::vector<f64> solution(freeCount * 2);
+        const f64 lambda = REGULARISATION * diagonal / std::max(freeCount, 1u);
+        for (u32 i = 0; i < n; ++i) {
+            const u32 row = freeOf[i];
+            if (row == NONE) continue;
+            SparseSolver::Block block;
+            block.m[0] = block.m[3] = lambda;
+            entries.push_back({ row, row, block });
+            solution[row * 2] = guess[i * 2];
+            solution[row * 2 + 1] = guess[i * 2 + 1];
+            rhs[row * 2] += lambda * guess[i * 2];
+            rhs[row * 2 + 1] += lambda * guess[i * 2 + 1];
+        }
+
+        SparseSolver::Matrix matrix;
+        SparseSolver::Assemble(entries, freeCount, matrix);
+        const SparseSolver::Result result = SparseSolver::SolveCG(matrix, rhs, solution, MAX_ITERATIONS, TOLERANCE);
+        report.iterations = result.iterations;
+        report.converged = result.converged;
+
+        // V runs down the texture, so the surface's y is flipped
+        for (u32 t : chart.triangles) {
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 v = indices[t * 3 + k];
+                const u32 local = localOf[weld[v]];
+                const u32 row = freeOf[local];
+                const f64 u = row == NONE ? guess[local * 2] : solution[row * 2];
+                const f64 w = row == NONE ? guess[local * 2 + 1] : solution[row * 2 + 1];
+                vertices[v].TCoords = vector2df((f32)u, (f32)-w);
+            }
+        }
+
+        for (u32 w : locals) localOf[w] = NONE;
+        report.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    // Unwraps every standard buffer; UVs come out in world units
+    inline Report Run(IMesh* mesh) {
+        auto start = std::chrono::steady_clock::now();
+        Report report;
+
+        std::vector<SMeshBuffer*> buffers(mesh->getMeshBufferCount(), nullptr);
+        std::vector<std::vector<u32>> welds(buffers.size());
+        std::vector<Chart> charts;
+        u32 maxVertices = 0;
+        for (u32 b = 0; b < (u32)buffers.size(); ++b) {
+            IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT)
+                continue;
+            buffers[b] = static_cast<SMeshBuffer*>(mb);
+            if (!BuildCharts(buffers[b], b, charts, welds[b], report.splitVertices)) {
+                report.skippedBuffers++;
+                buffers[b] = nullptr;
+                continue;
+            }
+            maxVertices = std::max(maxVertices, buffers[b]->Vertices.size());
+        }
+
+        // Largest first, taken one at a time, so a big chart is not queued
+        // behind a worker's share of small ones
+        std::vector<u32> order(charts.size());
+        for (u32 c = 0; c < (u32)order.size(); ++c) order[c] = c;
+        std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+            return charts[a].triangles.size() > charts[b].triangles.size();
+        });
+
+        report.chartReports.resize(charts.size());
+        std::atomic<u32> next(0);
+        const u32 workers = std::min(Parallel::WorkerCount(), (u32)charts.size());
+        Parallel::For(workers, 1, [&](u32, u32) {
+            std::vector<u32> localOf(maxVertices, NONE);
+            for (u32 i = next++; i < (u32)order.size(); i = next++) {
+                const Chart& chart = charts[order[i]];
+                SMeshBuffer* buffer = buffers[chart.buffer];
+                report.chartReports[order[i]] = SolveChart(buffer->Vertices.pointer(), buffer->Indices.const_pointer(),
+                                                           welds[chart.buffer], chart, localOf);
+            }
+        });
+
+        for (SMeshBuffer* buffer : buffers) {
+            if (buffer) buffer->setDirty(EBT_VERTEX_AND_INDEX);
+        }
+        report.charts = (u32)charts.size();
+        for (const Chart& chart : charts) report.faces += (u32)chart.triangles.size();
+        report.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Read-only vertex compression for meshes that are only looked at. A vertex
+// shrinks from S3DVertex's 36 bytes to 12:
+//   - position: three u16 in the buffer's bounding box (extent / 65535 steps)
+//   - normal: octahedral, two snorm8 (under a degree of error)
+//   - texcoord: two IEEE half floats (exact on the texel corners of textures
+//     up to 2048 wide, and tiling UVs keep working)
+// Vertex colours are almost always uniform, so a buffer stores one colour
+// unless its vertices actually differ.
+namespace VertexCompression {
+    struct Vertex {
+        u16 x, y, z;
+        s8 normalX, normalY;
+        u16 u, v;
+    };
+    static_assert(sizeof(Vertex) == 12, "Compressed vertices are meant to be a third of S3DVertex");
+
+    struct Buffer {
+        std::vector<Vertex> vertices;
+        std::vector<u16> indices;
+        std::vector<u32> colors; // Empty when every vertex has `color`
+        u32 color = 0xFFFFFFFF;
+        aabbox3df bounds;
+
+        u64 Bytes() const {
+            return vertices.size() * sizeof(Vertex) + indices.size() * sizeof(u16) + colors.size() * sizeof(u32);
+        }
+        u64 UncompressedBytes() const {
+            return vertices.size() * sizeof(S3DVertex) + indices.size() * sizeof(u16);
+        }
+    };
+
+    // Round to nearest even, denormals flushed to zero, overflow to infinity
+    inline u16 FloatToHalf(f32 value) {
+        u32 bits;
+        memcpy(&bits, &value, 4);
+        u32 sign = (bits >> 16) & 0x8000u;
+        s32 exponent = (s32)((bits >> 23) & 0xFF) - 127 + 15;
+        u32 mantissa = bits & 0x7FFFFFu;
+
+        if (((bits >> 23) & 0xFF) == 0xFF)
+            return (u16)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+        if (exponent <= 0)
+            return (u16)sign;
+        if (exponent >= 31)
+            return (u16)(sign | 0x7C00u);
+
+        u32 half = ((u32)exponent << 10) | (mantissa >> 13);
+        u32 rest = mantissa & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+            half++; // May carry into the exponent, which is still correct
+        return (u16)(sign | half);
+    }
+
+    inline f32 HalfToFloat(u16 half) {
+        u32 sign = (u32)(half & 0x8000u) << 16;
+        u32 exponent = (half >> 10) & 0x1Fu;
+        u32 mantissa = half & 0x3FFu;
+
+        u32 bits;
+        if (exponent == 0)
+            bits = sign; // Never produced by FloatToHalf
+        else if (exponent == 31)
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        else
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+        f32 value;
+        memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    inline s8 ToSnorm8(f32 value) {
+        return (s8)std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    // Projects the unit sphere onto an octahedron, then unfolds the lower
+    // half over the corners of the upper one
+    inline void EncodeNormal(const vector3df& normal, s8& outX, s8& outY) {
+        f32 length = std::fabs(normal.X) + std::fabs(normal.Y) + std::fabs(normal.Z);
+        if (length <= 0.0f) {
+            outX = outY = 0;
+            return;
+        }
+
+        f32 x = normal.X / length;
+        f32 y = normal.Y / length;
+        if (normal.Z < 0.0f) {
+            f32 foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            f32 foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        outX = ToSnorm8(x);
+        outY = ToSnorm8(y);
+    }
+
+    inline vector3df DecodeNormal(s8 encodedX, s8 encodedY) {
+        f32 x = encodedX / 127.0f;
+        f32 y = encodedY / 127.0f;
+        f32 z = 1.0f - std::fabs(x) - std::fabs(y);
+        if (z < 0.0f) {
+            f32 unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            f32 unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = unfoldedX;
+            y = unfoldedY;
+        }
+
+        vector3df normal(x, y, z);
+        f32 length = normal.getLength();
+        return length > 0.0f ? normal / length : vector3df(0.0f, 1.0f, 0.0f);
+    }
+
+    inline void Compress(const IMeshBuffer* mb, Buffer& out) {
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u32 count = mb->getVertexCount();
+
+        out = Buffer();
+        out.bounds = mb->getBoundingBox();
+        if (count > 0) {
+            out.bounds.reset(vertices[0].Pos);
+            for (u32 i = 1; i < count; ++i)
+                out.bounds.addInternalPoint(vertices[i].Pos);
+        }
+
+        const vector3df origin = out.bounds.MinEdge;
+        const vector3df extent = out.bounds.getExtent();
+        const vector3df scale(
+            extent.X > 0.0f ? 65535.0f / extent.X : 0.0f,
+            extent.Y > 0.0f ? 65535.0f / extent.Y : 0.0f,
+            extent.Z > 0.0f ? 65535.0f / extent.Z : 0.0f);
+
+        out.vertices.resize(count);
+        bool uniformColor = true;
+        out.color = count > 0 ? vertices[0].Color.color : 0xFFFFFFFF;
+
+        for (u32 i = 0; i < count; ++i) {
+            const S3DVertex& s = vertices[i];
+            Vertex& d = out.vertices[i];
+            d.x = (u16)std::clamp(std::lround((s.Pos.X - origin.X) * scale.X), 0L, 65535L);
+            d.y = (u16)std::clamp(std::lround((s.Pos.Y - origin.Y) * scale.Y), 0L, 65535L);
+            d.z = (u16)std::clamp(std::lround((s.Pos.Z - origin.Z) * scale.Z), 0L, 65535L);
+            EncodeNormal(s.Normal, d.normalX, d.normalY);
+            d.u = FloatToHalf(s.TCoords.X);
+            d.v = FloatToHalf(s.TCoords.Y);
+            uniformColor = uniformColor && s.Color.color == out.color;
+        }
+
+        if (!uniformColor) {
+            out.colors.resize(count);
+            for (u32 i = 0; i < count; ++i)
+                out.colors[i] = vertices[i].Color.color;
+        }
+
+        const u16* indices = mb->getIndices();
+        out.indices.assign(indices, indices + mb->getIndexCount() - mb->getIndexCount() % 3);
+    }
+
+    // Expands every vertex of `buffer` into `out`
+    inline void Decompress(const Buffer& buffer, S3DVertex* out) {
+        const vector3df origin = buffer.bounds.MinEdge;
+        const vector3df step = buffer.bounds.getExtent() / 65535.0f;
+        const bool uniformColor = buffer.colors.empty();
+
+        for (size_t i = 0; i < buffer.vertices.size(); ++i) {
+            const Vertex& s = buffer.vertices[i];
+            S3DVertex& d = out[i];
+            d.Pos.set(origin.X + s.x * step.X, origin.Y + s.y * step.Y, origin.Z + s.z * step.Z);
+            d.Normal = DecodeNormal(s.normalX, s.normalY);
+            d.TCoords.set(HalfToFloat(s.u), HalfToFloat(s.v));
+            d.Color.color = uniformColor ? buffer.color : buffer.colors[i];
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include "WindowResolution.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <X11/Xlib.h>
+#endif
+
+namespace {
+    dimension2d<u32> fromNullDevice() {
+        dimension2d<u32> resolution(1024, 768); // Default fallback
+
+        // 1. Create a temporary NULL device
+        IrrlichtDevice *nullDevice = createDevice(EDT_NULL);
+        
+        if (nullDevice) {
+            IVideoModeList* modeList = nullDevice->getVideoModeList();
+            if (modeList) {
+                resolution = modeList->getDesktopResolution();
+            }
+            
+            // 2. Drop the null device to free memory
+            nullDevice->drop();
+        }
+
+        return resolution;
+    }
+}
+
+dimension2d<u32> WindowResolution::Get()
+{
+#if defined(_WIN32)
+    int width = GetSystemMetrics(SM_CXSCREEN);
+    int height = GetSystemMetrics(SM_CYSCREEN);
+    if (width > 0 && height > 0)
+        return dimension2d<u32>((u32)width, (u32)height);
+#elif defined(__linux__)
+    if (Display* display = XOpenDisplay(nullptr)) {
+        Screen* screen = DefaultScreenOfDisplay(display);
+        dimension2d<u32> resolution((u32)WidthOfScreen(screen), (u32)HeightOfScreen(screen));
+        XCloseDisplay(display);
+        if (resolution.Width > 0 && resolution.Height > 0)
+            return resolution;
+    }
+#endif
+    return fromNullDevice();
+}
@@ -7,22 +7,9 @@ using namespace core;
 using namespace video;
 
 namespace WindowResolution {
-    inline dimension2d<u32> Get() {
-        dimension2d<u32> resolution(1024, 768); // Default fallback
-
-        // 1. Create a temporary NULL device
-        IrrlichtDevice *nullDevice = createDevice(EDT_NULL);
-        
-        if (nullDevice) {
-            IVideoModeList* modeList = nullDevice->getVideoModeList();
-            if (modeList) {
-                resolution = modeList->getDesktopResolution();
-            }
-            
-            // 2. Drop the null device to free memory
-            nullDevice->drop();
-        }
-
-        return resolution;
-    }
+    // Desktop resolution, asked of the windowing system directly (Win32 or
+    // X11). Other platforms fall back to a throwaway EDT_NULL device, which
+    // costs a full device startup. The platform headers stay in the .cpp,
+    // X11's macros (None, Bool, Status) would clash with everything else.
+    dimension2d<u32> Get();
 }
@@ -0,0 +1,155 @@
+#include "Autosave.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "helpers/Profiler.h"
+
+namespace {
+    const char* FILE_PREFIX = "autosave-";
+    const char* FILE_EXTENSION = ".jbx";
+}
+
+Autosave::Autosave()
+    : _lastStart(std::chrono::steady_clock::now())
+{
+}
+
+Autosave::~Autosave()
+{
+    Wait();
+}
+
+void Autosave::Configure(const Settings& settings)
+{
+    _settings = settings;
+    _settings.keep = std::max(_settings.keep, 1u);
+    _lastStart = std::chrono::steady_clock::now();
+
+    if (_settings.intervalSeconds > 0.0)
+        std::cout << "Autosave every " << _settings.intervalSeconds << " s, keeping " << _settings.keep
+                  << " in " << _settings.directory << "/" << std::endl;
+    else
+        std::cout << "Autosave off" << std::endl;
+}
+
+bool Autosave::IsDue() const
+{
+    if (_settings.intervalSeconds <= 0.0 || _job.valid())
+        return false;
+
+    std::chrono::duration<f64> elapsed = std::chrono::steady_clock::now() - _lastStart;
+    return elapsed.count() >= _settings.intervalSeconds;
+}
+
+bool Autosave::Start(std::shared_ptr<const MeshSnapshot> snapshot, const ProjectFile::CameraState& camera)
+{
+    _lastStart = std::chrono::steady_clock::now();
+    if (!snapshot || _job.valid())
+        return false;
+
+    // Copy-on-write makes "unchanged" a pointer comparison
+    if (_lastSaved && snapshot->SharesAllBuffers(*_lastSaved))
+        return false;
+
+    _lastSaved = snapshot;
+    std::string path = _nextPath();
+    Settings settings = _settings;
+    _job = std::async(std::launch::async, [path, settings, snapshot, camera]() {
+        return _write(path, settings, snapshot, camera);
+    });
+    return true;
+}
+
+void Autosave::Poll()
+{
+    if (_job.valid() && _job.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        // A failed save is retried with whatever the next snapshot holds
+        if (!_job.get())
+            _lastSaved.reset();
+    }
+}
+
+void Autosave::Wait()
+{
+    if (_job.valid())
+        _job.get();
+}
+
+std::string Autosave::_nextPath() const
+{
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    s32 milliseconds = (s32)(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    char name[64];
+    std::strftime(name, sizeof(name), "%Y%m%d-%H%M%S", &local);
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%03d", milliseconds);
+
+    return (std::filesystem::path(_settings.directory) / (std::string(FILE_PREFIX) + name + suffix + FILE_EXTENSION)).string();
+}
+
+bool Autosave::_write(const std::string& path, const Settings& settings,
+                      std::shared_ptr<const MeshSnapshot> snapshot, ProjectFile::CameraState camera)
+{
+    Profiler::Scope scope("Autosave write");
+
+    std::error_code error;
+    std::filesystem::create_directories(settings.directory, error);
+    if (error) {
+        std::cout << "Autosave failed, cannot create " << settings.directory << std::endl;
+        return false;
+    }
+
+    ProjectFile::ProjectData data;
+    data.camera = camera;
+    for (const auto& buffer : snapshot->buffers) {
+        ProjectFile::BufferView view;
+        view.vertices = buffer->vertices.data();
+        view.vertexCount = (u32)buffer->vertices.size();
+        view.indices = buffer->indices.data();
+        view.indexCount = (u32)buffer->indices.size();
+        view.bounds = buffer->bounds;
+        data.buffers.push_back(view);
+    }
+
+    if (!ProjectFile::Save(path, data, true)) {
+        std::cout << "Autosave failed: " << path << std::endl;
+        return false;
+    }
+
+    _prune(settings);
+
+    std::cout << "Autosaved " << path << " (" << snapshot->copiedBuffers << " of " << snapshot->buffers.size()
+              << " buffers copied) in " << scope.ElapsedMilliseconds() << " ms" << std::endl;
+    return true;
+}
+
+void Autosave::_prune(const Settings& settings)
+{
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(settings.directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file(error) && name.rfind(FILE_PREFIX, 0) == 0 && entry.path().extension() == FILE_EXTENSION)
+            files.push_back(entry.path());
+    }
+
+    if (files.size() <= settings.keep)
+        return;
+
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i + settings.keep < files.size(); ++i)
+        std::filesystem::remove(files[i], error);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "io/MeshSnapshot.h"
+#include "io/ProjectFile.h"
+
+using namespace irr;
+
+// Periodic crash insurance. The editor hands over a copy-on-write snapshot
+// captured on the main thread; a worker writes it as a project file, fsyncs
+// it and prunes old autosaves, so a frame never waits on the disk.
+//
+// Files are "<directory>/autosave-YYYYMMDD-HHMMSS-mmm.jbx" (names sort by
+// time) and hold the geometry and camera; open one like any project.
+class Autosave {
+public:
+    struct Settings {
+        f64 intervalSeconds = 120.0; // 0 disables autosave
+        u32 keep = 5;                // Newest files kept, older ones are deleted
+        std::string directory = "autosave";
+    };
+
+    Autosave(); // Default settings until Configure()
+    ~Autosave();
+
+    Autosave(const Autosave&) = delete;
+    Autosave& operator=(const Autosave&) = delete;
+
+    void Configure(const Settings& settings);
+    const Settings& GetSettings() const { return _settings; }
+
+    // True when the interval has passed and no save is in flight
+    bool IsDue() const;
+
+    // Starts writing `snapshot` on a worker. Returns false (and restarts the
+    // interval) when nothing changed since the last autosave.
+    bool Start(std::shared_ptr<const MeshSnapshot> snapshot, const ProjectFile::CameraState& camera);
+
+    // Collects a finished save; call once per frame
+    void Poll();
+
+    // Blocks until the save in flight (if any) is done
+    void Wait();
+
+private:
+    Settings _settings;
+    std::chrono::steady_clock::time_point _lastStart;
+    std::shared_ptr<const MeshSnapshot> _lastSaved;
+    std::future<bool> _job;
+
+    std::string _nextPath() const;
+    static bool _write(const std::string& path, const Settings& settings,
+                       std::shared_ptr<const MeshSnapshot> snapshot, ProjectFile::CameraState camera);
+    static void _prune(const Settings& settings);
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+using namespace irr;
+
+// Output file behind a large memory buffer. Numbers are formatted straight
+// into the buffer with std::to_chars (shortest round-trip form, no locale),
+// so the disk, not the formatting, sets the pace.
+//
+// Data goes to "<path>.tmp" and only replaces <path> when Close() succeeds.
+class BufferedWriter {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 8 << 20; // 8 MB
+    static constexpr size_t MAX_NUMBER_LENGTH = 32;
+
+    explicit BufferedWriter(size_t capacity = DEFAULT_CAPACITY)
+        : _file(nullptr), _buffer(new char[capacity]), _capacity(capacity), _used(0), _written(0), _failed(false)
+    {
+    }
+
+    ~BufferedWriter() { Abort(); }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool Open(const std::string& path) {
+        Abort();
+        _path = path;
+        _file = fopen(_temporaryPath().c_str(), "wb");
+        _failed = _file == nullptr;
+        _used = 0;
+        _written = 0;
+        return _file != nullptr;
+    }
+
+    // Flushes and moves the file into place; false if anything failed on the way
+    bool Close() {
+        if (!_file) return false;
+        _flush();
+        bool ok = fclose(_file) == 0 && !_failed;
+        _file = nullptr;
+
+        std::error_code error;
+        if (ok) std::filesystem::rename(_temporaryPath(), _path, error);
+        if (!ok || error) {
+            std::filesystem::remove(_temporaryPath(), error);
+            return false;
+        }
+        return true;
+    }
+
+    // Drops the partial file
+    void Abort() {
+        if (!_file) return;
+        fclose(_file);
+        _file = nullptr;
+        std::error_code error;
+        std::filesystem::remove(_temporaryPath(), error);
+    }
+
+    void Write(const void* data, size_t size) {
+        if (_used + size > _capacity) {
+            _flush();
+            if (size > _capacity) {
+                _failed |= !_file || fwrite(data, 1, size, _file) != size;
+                _written += size;
+                return;
+            }
+        }
+        memcpy(_buffer.get() + _used, data, size);
+        _used += size;
+    }
+
+    void WriteText(const char* text) { Write(text, strlen(text)); }
+
+    void WriteChar(char c) {
+        if (_used == _capacity) _flush();
+        _buffer[_used++] = c;
+    }
+
+    void WriteFloat(f32 value) {
+        _reserveNumber();
+        _used = std::to_chars(_buffer.get() + _used, _buffer.get() + _capacity, value).ptr - _buffer.get();
+    }
+
+    void WriteUInt(u32 value) {
+        _reserveNumber();
+        _used = std::to_chars(_buffer.get() + _used, _buffer.get() + _capacity, value).ptr - _buffer.get();
+    }
+
+    u64 GetBytesWritten() const { return _written + _used; }
+    bool HasFailed() const { return _failed; }
+
+private:
+    FILE* _file;
+    std::unique_ptr<char[]> _buffer;
+    size_t _capacity;
+    size_t _used;
+    u64 _written;
+    bool _failed;
+    std::string _path;
+
+    std::string _temporaryPath() const { return _path + ".tmp"; }
+
+    void _reserveNumber() {
+        if (_used + MAX_NUMBER_LENGTH > _capacity) _flush();
+    }
+
+    void _flush() {
+        if (_used == 0) return;
+        _failed |= !_file || fwrite(_buffer.get(), 1, _used, _file) != _used;
+        _written += _used;
+        _used = 0;
+    }
+};
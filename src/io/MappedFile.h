@@ -0,0 +1,36 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <string>
+
+using namespace irr;
+
+// Read-only file mapped copy-on-write: pages are shared with the page cache
+// until written, so edits never reach the file and untouched data costs no
+// extra memory.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return _data != nullptr; }
+    u8* GetData() const { return _data; }
+    size_t GetSize() const { return _size; }
+    const std::string& GetPath() const { return _path; }
+
+private:
+    u8* _data;
+    size_t _size;
+    std::string _path;
+
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#endif
+};
@@ -0,0 +1,288 @@
+#include "MeshExporter.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+#include "helpers/PsxQuantize.h"
+#include "io/BufferedWriter.h"
+
+namespace {
+    // Faces in output order: a quad (four corners) or a triangle (fourth is unused)
+    struct Face {
+        u32 corners[4];
+        u32 count;
+    };
+
+    // Two triangles sharing an edge in opposite directions make a quad. The
+    // quad is returned in output winding, starting on the shared diagonal.
+    bool pairQuad(const u16* first, const u16* second, Face& face) {
+        for (u32 e = 0; e < 3; ++e) {
+            u16 u = first[e], v = first[(e + 1) % 3], w = first[(e + 2) % 3];
+            for (u32 k = 0; k < 3; ++k) {
+                if (second[k] != v || second[(k + 1) % 3] != u) continue;
+                u16 x = second[(k + 2) % 3];
+                if (x == u || x == v || x == w) return false;
+
+                // Irrlicht winding is u, x, v, w; the reversed loop from u is u, w, v, x
+                face.corners[0] = u;
+                face.corners[1] = w;
+                face.corners[2] = v;
+                face.corners[3] = x;
+                face.count = 4;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Walks a buffer's triangles, merging consecutive pairs into quads
+    template<class Fn>
+    void forEachFace(const MeshSnapshot::Buffer& buffer, Fn&& fn) {
+        const u16* indices = buffer.indices.data();
+        const u32 triangleCount = (u32)buffer.indices.size() / 3;
+
+        for (u32 t = 0; t < triangleCount; ++t) {
+            Face face;
+            if (t + 1 < triangleCount && pairQuad(indices + t * 3, indices + t * 3 + 3, face)) {
+                ++t;
+            } else {
+                const u16* tri = indices + t * 3;
+                face.corners[0] = tri[0];
+                face.corners[1] = tri[2];
+                face.corners[2] = tri[1];
+                face.count = 3;
+            }
+            fn(face);
+        }
+    }
+
+    void countFaces(const MeshSnapshot& snapshot, MeshExporter::Report& report, u32& faceCount) {
+        faceCount = 0;
+        for (const auto& buffer : snapshot.buffers) {
+            report.vertices += (u32)buffer->vertices.size();
+            report.triangles += (u32)buffer->indices.size() / 3;
+            forEachFace(*buffer, [&](const Face& face) {
+                if (face.count == 4) report.quads++;
+                faceCount++;
+            });
+        }
+    }
+
+    f64 elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+bool MeshExporter::ExportObj(const std::string& path, const MeshSnapshot& snapshot, Report& report)
+{
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+
+    BufferedWriter writer;
+    if (!writer.Open(path)) {
+        std::cout << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    writer.WriteText("# Exported by Juice Box\n");
+
+    // Every vertex carries its own texcoord and normal, so all three share one index
+    u32 base = 1;
+    for (const auto& buffer : snapshot.buffers) {
+        writer.WriteText("o buffer");
+        writer.WriteUInt(base);
+        writer.WriteChar('\n');
+
+        for (const S3DVertex& vertex : buffer->vertices) {
+            writer.Write("v ", 2);
+            writer.WriteFloat(-vertex.Pos.X);
+            writer.WriteChar(' ');
+            writer.WriteFloat(vertex.Pos.Y);
+            writer.WriteChar(' ');
+            writer.WriteFloat(vertex.Pos.Z);
+            writer.Write("\nvt ", 4);
+            writer.WriteFloat(vertex.TCoords.X);
+            writer.WriteChar(' ');
+            writer.WriteFloat(1.0f - vertex.TCoords.Y);
+            writer.Write("\nvn ", 4);
+            writer.WriteFloat(-vertex.Normal.X);
+            writer.WriteChar(' ');
+            writer.WriteFloat(vertex.Normal.Y);
+            writer.WriteChar(' ');
+            writer.WriteFloat(vertex.Normal.Z);
+            writer.WriteChar('\n');
+        }
+
+        forEachFace(*buffer, [&](const Face& face) {
+            writer.WriteChar('f');
+            for (u32 c = 0; c < face.count; ++c) {
+                u32 index = base + face.corners[c];
+                writer.WriteChar(' ');
+                writer.WriteUInt(index);
+                writer.WriteChar('/');
+                writer.WriteUInt(index);
+                writer.WriteChar('/');
+                writer.WriteUInt(index);
+            }
+            writer.WriteChar('\n');
+
+            report.triangles += face.count - 2;
+            if (face.count == 4) report.quads++;
+        });
+
+        base += (u32)buffer->vertices.size();
+        report.vertices += (u32)buffer->vertices.size();
+    }
+
+    report.bytes = writer.GetBytesWritten();
+    if (!writer.Close()) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+
+    report.milliseconds = elapsedMilliseconds(start);
+    return true;
+}
+
+bool MeshExporter::ExportPly(const std::string& path, const MeshSnapshot& snapshot, Report& report)
+{
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+
+    // The header needs the face count, so pair quads once up front (index compares only)
+    u32 faceCount = 0;
+    countFaces(snapshot, report, faceCount);
+
+    BufferedWriter writer;
+    if (!writer.Open(path)) {
+        std::cout << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    writer.WriteText(
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "comment Exported by Juice Box\n"
+        "element vertex ");
+    writer.WriteUInt(report.vertices);
+    writer.WriteText(
+        "\nproperty float x\nproperty float y\nproperty float z\n"
+        "property float nx\nproperty float ny\nproperty float nz\n"
+        "property float s\nproperty float t\n"
+        "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n"
+        "element face ");
+    writer.WriteUInt(faceCount);
+    writer.WriteText("\nproperty list uchar int vertex_indices\nend_header\n");
+
+    for (const auto& buffer : snapshot.buffers) {
+        for (const S3DVertex& vertex : buffer->vertices) {
+            f32 values[8] = {
+                -vertex.Pos.X, vertex.Pos.Y, vertex.Pos.Z,
+                -vertex.Normal.X, vertex.Normal.Y, vertex.Normal.Z,
+                vertex.TCoords.X, 1.0f - vertex.TCoords.Y
+            };
+            u8 color[4] = {
+                (u8)vertex.Color.getRed(), (u8)vertex.Color.getGreen(),
+                (u8)vertex.Color.getBlue(), (u8)vertex.Color.getAlpha()
+            };
+            writer.Write(values, sizeof(values));
+            writer.Write(color, sizeof(color));
+        }
+    }
+
+    s32 base = 0;
+    for (const auto& buffer : snapshot.buffers) {
+        forEachFace(*buffer, [&](const Face& face) {
+            u8 record[1 + 4 * 4];
+            record[0] = (u8)face.count;
+            for (u32 c = 0; c < face.count; ++c) {
+                s32 index = base + (s32)face.corners[c];
+                memcpy(record + 1 + c * 4, &index, 4);
+            }
+            writer.Write(record, 1 + face.count * 4);
+        });
+        base += (s32)buffer->vertices.size();
+    }
+
+    report.bytes = writer.GetBytesWritten();
+    if (!writer.Close()) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+
+    report.milliseconds = elapsedMilliseconds(start);
+    return true;
+}
+
+bool MeshExporter::ExportPsx(const std::string& path, const MeshSnapshot& snapshot, Report& report)
+{
+    static constexpr u32 VERSION = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+
+    aabbox3df bounds;
+    bool first = true;
+    for (const auto& buffer : snapshot.buffers) {
+        if (buffer->vertices.empty()) continue;
+        if (first) bounds = buffer->bounds;
+        else bounds.addInternalBox(buffer->bounds);
+        first = false;
+    }
+    const s32 fractionBits = first ? PsxQuantize::MAX_FRACTION_BITS : PsxQuantize::ChooseFractionBits(bounds);
+
+    BufferedWriter writer;
+    if (!writer.Open(path)) {
+        std::cout << "Failed to create " << path << std::endl;
+        return false;
+    }
+
+    u32 header[3] = { 0, VERSION, (u32)snapshot.buffers.size() };
+    memcpy(header, "JPSX", 4);
+    u8 layout[4] = { (u8)fractionBits, (u8)sizeof(PsxQuantize::Vertex), 0, 0 };
+    writer.Write(header, sizeof(header));
+    writer.Write(layout, sizeof(layout));
+
+    std::vector<PsxQuantize::Vertex> vertices;
+    for (const auto& buffer : snapshot.buffers) {
+        u32 counts[2] = { (u32)buffer->vertices.size(), (u32)buffer->indices.size() };
+        writer.Write(counts, sizeof(counts));
+
+        vertices.resize(buffer->vertices.size());
+        PsxQuantize::Quantize(buffer->vertices.data(), counts[0], fractionBits, vertices.data());
+        writer.Write(vertices.data(), vertices.size() * sizeof(PsxQuantize::Vertex));
+        writer.Write(buffer->indices.data(), buffer->indices.size() * sizeof(u16));
+        if (buffer->indices.size() % 2) {
+            u16 padding = 0;
+            writer.Write(&padding, sizeof(padding));
+        }
+
+        report.vertices += counts[0];
+        report.triangles += counts[1] / 3;
+    }
+
+    report.bytes = writer.GetBytesWritten();
+    if (!writer.Close()) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+
+    report.milliseconds = elapsedMilliseconds(start);
+    return true;
+}
+
+bool MeshExporter::Export(const std::string& path, const MeshSnapshot& snapshot, Report& report)
+{
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if (extension == ".obj")
+        return ExportObj(path, snapshot, report);
+    if (extension == ".ply")
+        return ExportPly(path, snapshot, report);
+    if (extension == ".psx")
+        return ExportPsx(path, snapshot, report);
+
+    std::cout << "Unsupported export format: " << path << std::endl;
+    return false;
+}
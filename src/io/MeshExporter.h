@@ -0,0 +1,47 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <string>
+#include <iostream>
+
+#include "io/MeshSnapshot.h"
+
+using namespace irr;
+
+// OBJ and binary PLY export from a mesh snapshot, so it can run on a worker
+// thread. Coordinates are converted back to right-handed (X mirrored, V
+// flipped, winding reversed), the inverse of ObjImporter. Consecutive
+// triangles that form a quad are written as one quad, starting on their
+// shared diagonal so a re-import splits it the same way.
+namespace MeshExporter {
+    struct Report {
+        u64 bytes = 0;
+        u32 vertices = 0;
+        u32 triangles = 0;
+        u32 quads = 0;
+        f64 milliseconds = 0.0;
+
+        f64 MegabytesPerSecond() const {
+            return milliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0;
+        }
+
+        void Print(const char* label) const {
+            std::cout << label << ": " << vertices << " vertices, " << triangles << " triangles, "
+                      << quads << " quads, " << bytes << " bytes in " << milliseconds << " ms, "
+                      << MegabytesPerSecond() << " MB/s" << std::endl;
+        }
+    };
+
+    bool ExportObj(const std::string& path, const MeshSnapshot& snapshot, Report& report);
+    bool ExportPly(const std::string& path, const MeshSnapshot& snapshot, Report& report);
+
+    // Compact PlayStation-style mesh (see PsxQuantize). Little-endian:
+    //   "JPSX", u32 version, u32 buffer count, u8 fraction bits, u8 vertex
+    //   size (12), u16 zero; then per buffer u32 vertex count, u32 index
+    //   count, the vertices and the u16 triangle indices, padded to 4 bytes.
+    // Coordinates stay in the editor's left-handed space, ready to draw.
+    bool ExportPsx(const std::string& path, const MeshSnapshot& snapshot, Report& report);
+
+    // Picks the format from the extension (.obj, .ply or .psx)
+    bool Export(const std::string& path, const MeshSnapshot& snapshot, Report& report);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <memory>
+#include <vector>
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Immutable copy of a mesh's standard buffers. Captured on the main thread,
+// then safe to read from any other thread while editing carries on.
+//
+// Snapshots are copy-on-write per buffer: given the previous snapshot of the
+// same mesh, buffers whose changed IDs, sizes and bounds still match are
+// shared instead of copied, so capturing after a small edit only copies the
+// buffers that edit touched.
+struct MeshSnapshot {
+    struct Buffer {
+        std::vector<S3DVertex> vertices;
+        std::vector<u16> indices;
+        aabbox3df bounds;
+
+        // Where the copy came from, used to decide whether it can be reused
+        const IMeshBuffer* source = nullptr;
+        u32 vertexChangedId = 0;
+        u32 indexChangedId = 0;
+
+        bool Matches(const IMeshBuffer* mb) const {
+            return source == mb &&
+                   vertexChangedId == mb->getChangedID_Vertex() &&
+                   indexChangedId == mb->getChangedID_Index() &&
+                   vertices.size() == mb->getVertexCount() &&
+                   indices.size() == mb->getIndexCount() - mb->getIndexCount() % 3 &&
+                   bounds == mb->getBoundingBox();
+        }
+    };
+
+    std::vector<std::shared_ptr<const Buffer>> buffers;
+    u32 copiedBuffers = 0; // Buffers copied by this capture (the rest are shared)
+
+    static std::shared_ptr<const Buffer> CaptureBuffer(const IMeshBuffer* mb) {
+        auto buffer = std::make_shared<Buffer>();
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+        buffer->vertices.assign(vertices, vertices + mb->getVertexCount());
+        buffer->indices.assign(indices, indices + mb->getIndexCount() - mb->getIndexCount() % 3);
+        buffer->bounds = mb->getBoundingBox();
+        buffer->source = mb;
+        buffer->vertexChangedId = mb->getChangedID_Vertex();
+        buffer->indexChangedId = mb->getChangedID_Index();
+        return buffer;
+    }
+
+    // `previous` must come from the same mesh: buffer pointers are only
+    // meaningful while the buffers they name are alive.
+    static std::shared_ptr<const MeshSnapshot> Capture(const IMesh* mesh, const MeshSnapshot* previous = nullptr) {
+        auto snapshot = std::make_shared<MeshSnapshot>();
+        for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+            const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+            if (mb->getVertexType() != EVT_STANDARD || mb->getIndexType() != EIT_16BIT)
+                continue;
+
+            size_t slot = snapshot->buffers.size();
+            if (previous && slot < previous->buffers.size() && previous->buffers[slot]->Matches(mb)) {
+                snapshot->buffers.push_back(previous->buffers[slot]);
+            } else {
+                snapshot->buffers.push_back(CaptureBuffer(mb));
+                snapshot->copiedBuffers++;
+            }
+        }
+        return snapshot;
+    }
+
+    // True when both snapshots share every buffer, i.e. nothing changed in between
+    bool SharesAllBuffers(const MeshSnapshot& other) const {
+        return buffers == other.buffers;
+    }
+
+    u32 GetVertexCount() const {
+        u32 count = 0;
+        for (const auto& buffer : buffers) count += (u32)buffer->vertices.size();
+        return count;
+    }
+};
@@ -0,0 +1,383 @@
+#include "ObjImporter.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "helpers/KeyTable.h"
+#include "helpers/Parallel.h"
+#include "helpers/ScratchArena.h"
+
+namespace {
+    constexpr s32 NONE = INT_MIN; // Corner without a texcoord or normal
+
+    const f64 POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Face corner as written in the chunk. Negative OBJ indices are relative
+    // to the elements seen so far, which for a chunk is only known after the
+    // chunks before it are merged; `relative` marks which ones still need a base.
+    struct Corner {
+        s32 index[3]; // Position, texcoord, normal
+        u8 relative;
+    };
+
+    struct Chunk {
+        std::vector<char> text;
+        std::vector<vector3df> positions;
+        std::vector<vector2df> texcoords;
+        std::vector<vector3df> normals;
+        std::vector<u32> faceSizes;
+        std::vector<Corner> corners;
+        u32 skippedFaces = 0;
+
+        void Clear() {
+            text.clear();
+            positions.clear();
+            texcoords.clear();
+            normals.clear();
+            faceSizes.clear();
+            corners.clear();
+            skippedFaces = 0;
+        }
+    };
+
+    inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+    inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    inline const char* skipBlanks(const char* p, const char* end) {
+        while (p < end && isBlank(*p)) ++p;
+        return p;
+    }
+
+    // Decimal float with optional sign, fraction and exponent; no locale, no allocation
+    bool parseFloat(const char*& p, const char* end, f32& out) {
+        p = skipBlanks(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+        u64 mantissa = 0;
+        s32 exponent = 0;
+        s32 digits = 0;
+        while (p < end && isDigit(*p)) {
+            if (digits < 19) mantissa = mantissa * 10 + (u64)(*p - '0'), ++digits;
+            else ++exponent; // Digits past u64 precision only scale the value
+            ++p;
+        }
+        bool any = digits > 0 || exponent > 0;
+
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && isDigit(*p)) {
+                if (digits < 19) mantissa = mantissa * 10 + (u64)(*p - '0'), ++digits, --exponent;
+                ++p;
+                any = true;
+            }
+        }
+        if (!any) return false;
+
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            bool negativeExponent = false;
+            if (q < end && (*q == '-' || *q == '+')) negativeExponent = *q++ == '-';
+            if (q < end && isDigit(*q)) {
+                s32 value = 0;
+                while (q < end && isDigit(*q)) {
+                    if (value < 10000) value = value * 10 + (*q - '0');
+                    ++q;
+                }
+                exponent += negativeExponent ? -value : value;
+                p = q;
+            }
+        }
+
+        f64 result = (f64)mantissa;
+        if (exponent < 0) result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent] : result * pow(10.0, exponent);
+        else if (exponent > 0) result = exponent <= 22 ? result * POWERS_OF_TEN[exponent] : result * pow(10.0, exponent);
+
+        out = (f32)(negative ? -result : result);
+        return true;
+    }
+
+    bool parseInt(const char*& p, const char* end, s32& out) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+        if (p >= end || !isDigit(*p)) return false;
+
+        s64 value = 0;
+        while (p < end && isDigit(*p)) {
+            if (value < INT_MAX) value = value * 10 + (*p - '0');
+            ++p;
+        }
+        if (value > INT_MAX) value = INT_MAX;
+        out = (s32)(negative ? -value : value);
+        return true;
+    }
+
+    // OBJ indices are 1-based, negative ones count back from the latest element
+    inline void setIndex(Corner& corner, u32 slot, s32 value, u32 localCount) {
+        if (value > 0) {
+            corner.index[slot] = value - 1;
+        } else {
+            corner.index[slot] = (s32)localCount + value;
+            corner.relative |= (u8)(1 << slot);
+        }
+    }
+
+    void parseFace(const char* p, const char* end, Chunk& chunk) {
+        const size_t firstCorner = chunk.corners.size();
+        const u32 counts[3] = { (u32)chunk.positions.size(), (u32)chunk.texcoords.size(), (u32)chunk.normals.size() };
+
+        while (true) {
+            p = skipBlanks(p, end);
+            s32 value = 0;
+            if (!parseInt(p, end, value)) break;
+
+            Corner corner = { { 0, NONE, NONE }, 0 };
+            if (value == 0) { chunk.corners.resize(firstCorner); chunk.skippedFaces++; return; }
+            setIndex(corner, 0, value, counts[0]);
+
+            // v, v/t, v//n, v/t/n
+            for (u32 slot = 1; slot < 3 && p < end && *p == '/'; ++slot) {
+                ++p;
+                if (parseInt(p, end, value) && value != 0) setIndex(corner, slot, value, counts[slot]);
+            }
+            chunk.corners.push_back(corner);
+        }
+
+        u32 size = (u32)(chunk.corners.size() - firstCorner);
+        if (size < 3) {
+            chunk.corners.resize(firstCorner);
+            chunk.skippedFaces++;
+            return;
+        }
+        chunk.faceSizes.push_back(size);
+    }
+
+    void parseChunk(Chunk& chunk) {
+        const char* p = chunk.text.data();
+        const char* end = p + chunk.text.size();
+
+        while (p < end) {
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            if (!lineEnd) lineEnd = end;
+
+            const char* q = skipBlanks(p, lineEnd);
+            if (lineEnd - q >= 2) {
+                if (q[0] == 'v' && isBlank(q[1])) {
+                    vector3df position;
+                    q += 2;
+                    parseFloat(q, lineEnd, position.X);
+                    parseFloat(q, lineEnd, position.Y);
+                    parseFloat(q, lineEnd, position.Z);
+                    position.X = -position.X;
+                    chunk.positions.push_back(position);
+                }
+                else if (q[0] == 'v' && q[1] == 't') {
+                    vector2df texcoord;
+                    q += 2;
+                    parseFloat(q, lineEnd, texcoord.X);
+                    parseFloat(q, lineEnd, texcoord.Y);
+                    texcoord.Y = 1.0f - texcoord.Y;
+                    chunk.texcoords.push_back(texcoord);
+                }
+                else if (q[0] == 'v' && q[1] == 'n') {
+                    vector3df normal;
+                    q += 2;
+                    parseFloat(q, lineEnd, normal.X);
+                    parseFloat(q, lineEnd, normal.Y);
+                    parseFloat(q, lineEnd, normal.Z);
+                    normal.X = -normal.X;
+                    chunk.normals.push_back(normal);
+                }
+                else if (q[0] == 'f' && isBlank(q[1])) {
+                    parseFace(q + 2, lineEnd, chunk);
+                }
+                // Groups, smoothing groups and materials are ignored
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    // Fills `chunk` with the carried-over partial line plus the next block of
+    // the file, cut after the last complete line. Returns false at end of file.
+    bool readChunk(FILE* file, std::vector<char>& carry, Chunk& chunk, u64& bytes) {
+        chunk.Clear();
+        chunk.text.swap(carry);
+        carry.clear();
+
+        while (true) {
+            size_t offset = chunk.text.size();
+            chunk.text.resize(offset + ObjImporter::CHUNK_SIZE);
+            size_t read = fread(chunk.text.data() + offset, 1, ObjImporter::CHUNK_SIZE, file);
+            chunk.text.resize(offset + read);
+            bytes += read;
+
+            if (read < ObjImporter::CHUNK_SIZE)
+                return false; // Last chunk takes everything, including an unterminated final line
+
+            // Cut after the last newline; a line longer than a chunk keeps reading
+            for (size_t i = chunk.text.size(); i > offset; --i) {
+                if (chunk.text[i - 1] == '\n') {
+                    carry.assign(chunk.text.begin() + i, chunk.text.end());
+                    chunk.text.resize(i);
+                    return true;
+                }
+            }
+        }
+    }
+}
+
+SMesh* ObjImporter::Load(const std::string& path, Report& report)
+{
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cout << "Failed to open " << path << std::endl;
+        return nullptr;
+    }
+
+    // 1. Read a batch of chunks, parse them in parallel, merge in file order
+    std::vector<vector3df> positions;
+    std::vector<vector2df> texcoords;
+    std::vector<vector3df> normals;
+    std::vector<u32> faceSizes;
+    std::vector<Corner> corners;
+
+    std::vector<Chunk> batch(Parallel::WorkerCount());
+    std::vector<char> carry;
+    bool more = true;
+
+    while (more) {
+        u32 filled = 0;
+        while (filled < batch.size() && more) {
+            more = readChunk(file, carry, batch[filled], report.bytes);
+            ++filled;
+        }
+
+        Parallel::For(filled, 1, [&](u32 begin, u32 end) {
+            for (u32 c = begin; c < end; ++c) parseChunk(batch[c]);
+        });
+
+        for (u32 c = 0; c < filled; ++c) {
+            Chunk& chunk = batch[c];
+            const s32 bases[3] = { (s32)positions.size(), (s32)texcoords.size(), (s32)normals.size() };
+
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            faceSizes.insert(faceSizes.end(), chunk.faceSizes.begin(), chunk.faceSizes.end());
+
+            size_t firstCorner = corners.size();
+            corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+            for (size_t i = firstCorner; i < corners.size(); ++i) {
+                Corner& corner = corners[i];
+                for (u32 slot = 0; slot < 3 && corner.relative; ++slot)
+                    if (corner.relative & (1 << slot)) corner.index[slot] += bases[slot];
+                corner.relative = 0;
+            }
+            report.skippedFaces += chunk.skippedFaces;
+        }
+    }
+    fclose(file);
+
+    // 2. Build buffers, splitting whenever the next face might not fit in 16-bit indices
+    SMesh* mesh = new SMesh();
+    SMeshBuffer* buffer = nullptr;
+    ScratchArena arena;
+    KeyTable table;
+    std::vector<u16> local;
+    const SColor white(255, 255, 255, 255);
+    const s32 counts[3] = { (s32)positions.size(), (s32)texcoords.size(), (s32)normals.size() };
+    report.positions = (u32)positions.size();
+    report.hasNormals = !normals.empty();
+
+    auto finishBuffer = [&]() {
+        if (!buffer) return;
+        buffer->recalculateBoundingBox();
+        mesh->addMeshBuffer(buffer);
+        buffer->drop();
+        buffer = nullptr;
+    };
+
+    size_t cornerOffset = 0;
+    size_t remainingCorners = corners.size();
+    for (u32 size : faceSizes) {
+        const Corner* face = corners.data() + cornerOffset;
+        cornerOffset += size;
+        remainingCorners -= size;
+
+        bool valid = size <= MAX_VERTICES;
+        for (u32 i = 0; valid && i < size; ++i) {
+            for (u32 slot = 0; slot < 3; ++slot) {
+                s32 index = face[i].index[slot];
+                if (index == NONE && slot > 0) continue;
+                if (index < 0 || index >= counts[slot]) valid = false;
+            }
+        }
+        if (!valid) {
+            report.skippedFaces++;
+            continue;
+        }
+
+        if (!buffer || buffer->Vertices.size() + size > MAX_VERTICES) {
+            finishBuffer();
+            buffer = new SMeshBuffer();
+            buffer->Vertices.reallocate((u32)std::min<size_t>(MAX_VERTICES, remainingCorners + size));
+            buffer->Indices.reallocate((u32)std::min<size_t>(MAX_VERTICES * 6, (remainingCorners + size) * 3));
+            arena.Reset();
+            table.Init(arena, MAX_VERTICES);
+        }
+
+        // Corners sharing position, texcoord and normal share a vertex
+        local.resize(size);
+        for (u32 i = 0; i < size; ++i) {
+            const Corner& corner = face[i];
+            bool inserted = false;
+            u32 vertex = table.FindOrInsert(corner.index[0], corner.index[1], corner.index[2], inserted);
+
+            if (inserted) {
+                S3DVertex v;
+                v.Pos = positions[corner.index[0]];
+                v.Normal = corner.index[2] != NONE ? normals[corner.index[2]] : vector3df(0, 0, 0);
+                v.TCoords = corner.index[1] != NONE ? texcoords[corner.index[1]] : vector2df(0, 0);
+                v.Color = white;
+                buffer->Vertices.push_back(v);
+                if (corner.index[2] == NONE) report.hasNormals = false;
+            }
+            local[i] = (u16)vertex;
+        }
+
+        // Reversed fan; a quad becomes (2,1,0),(3,2,0)
+        for (u32 i = 1; i + 1 < size; ++i) {
+            buffer->Indices.push_back(local[i + 1]);
+            buffer->Indices.push_back(local[i]);
+            buffer->Indices.push_back(local[0]);
+        }
+
+        report.triangles += size - 2;
+        if (size == 4) report.quads++;
+        else if (size > 4) report.polygons++;
+    }
+    finishBuffer();
+
+    if (mesh->getMeshBufferCount() == 0) {
+        std::cout << "No faces found in " << path << std::endl;
+        mesh->drop();
+        return nullptr;
+    }
+
+    mesh->recalculateBoundingBox();
+    report.buffers = mesh->getMeshBufferCount();
+    for (u32 b = 0; b < report.buffers; ++b) report.vertices += mesh->getMeshBuffer(b)->getVertexCount();
+    report.milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return mesh;
+}
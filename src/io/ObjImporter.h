@@ -0,0 +1,50 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <string>
+#include <iostream>
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Wavefront OBJ importer.
+//
+// The file is read in fixed size chunks cut at line ends. Each batch of
+// chunks is parsed on worker threads, then merged in file order, so the
+// result never depends on thread timing. Faces are fan triangulated with
+// quads kept as two consecutive triangles sharing the 0-2 diagonal (the
+// layout face selection expects). Coordinates are converted the same way
+// Irrlicht's own OBJ loader does: X mirrored, V flipped, winding reversed.
+namespace ObjImporter {
+    inline constexpr size_t CHUNK_SIZE = 4 << 20; // 4 MB of text per task
+    inline constexpr u32 MAX_VERTICES = 65535;
+
+    struct Report {
+        u64 bytes = 0;
+        u32 positions = 0;
+        u32 vertices = 0;   // After splitting by texcoord/normal
+        u32 triangles = 0;
+        u32 quads = 0;
+        u32 polygons = 0;   // Faces with more than four corners
+        u32 buffers = 0;
+        u32 skippedFaces = 0;
+        bool hasNormals = false;
+        f64 milliseconds = 0.0;
+
+        f64 MegabytesPerSecond() const {
+            return milliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0;
+        }
+
+        void Print(const char* label) const {
+            std::cout << label << ": " << positions << " positions, " << vertices << " vertices, "
+                      << triangles << " triangles (" << quads << " quads, " << polygons << " polygons, "
+                      << skippedFaces << " skipped) in " << buffers << " buffers, "
+                      << milliseconds << " ms, " << MegabytesPerSecond() << " MB/s" << std::endl;
+        }
+    };
+
+    // Returns a new mesh (caller drops it) or nullptr if the file can't be read
+    SMesh* Load(const std::string& path, Report& report);
+}
@@ -0,0 +1,454 @@
+#include "ProjectFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    struct Piece {
+        const void* data;
+        size_t size;
+    };
+
+    // One section to write: its table entry and where the payload comes from
+    struct Chunk {
+        ProjectFile::Section section = {};
+        std::vector<Piece> pieces;
+        ProjectFile::TextureInfo info = {}; // Texture chunks: the first piece points here
+        bool reused = false;
+    };
+
+    struct Writer {
+        FILE* file = nullptr;
+        u64 position = 0;
+
+        bool Write(const void* data, size_t size) {
+            if (size == 0) return true;
+            if (fwrite(data, 1, size, file) != size) return false;
+            position += size;
+            return true;
+        }
+
+        bool Pad() {
+            static const u8 zeros[ProjectFile::ALIGNMENT] = {};
+            u64 padding = (ProjectFile::ALIGNMENT - position % ProjectFile::ALIGNMENT) % ProjectFile::ALIGNMENT;
+            return Write(zeros, (size_t)padding);
+        }
+
+        // Writes the payload on an aligned offset and records where it went
+        bool WriteChunk(Chunk& chunk) {
+            if (!Pad()) return false;
+            chunk.section.offset = position;
+            for (const Piece& piece : chunk.pieces) {
+                if (!Write(piece.data, piece.size)) return false;
+            }
+            chunk.section.size = position - chunk.section.offset;
+            return true;
+        }
+    };
+
+    // Header and table of contents of the project already at the target path
+    struct Existing {
+        ProjectFile::Header header = {};
+        std::vector<ProjectFile::Section> toc;
+        u64 size = 0;
+    };
+
+    u64 aligned(u64 value) {
+        return (value + ProjectFile::ALIGNMENT - 1) / ProjectFile::ALIGNMENT * ProjectFile::ALIGNMENT;
+    }
+
+    u64 payloadSize(const Chunk& chunk) {
+        u64 size = 0;
+        for (const Piece& piece : chunk.pieces) size += piece.size;
+        return size;
+    }
+
+    // Hash::Bytes chained over the pieces; zero is kept for "unknown"
+    u64 hashPieces(const std::vector<Piece>& pieces) {
+        u64 hash = 0;
+        for (const Piece& piece : pieces) hash = Hash::Bytes(piece.data, piece.size, hash);
+        return hash ? hash : 1;
+    }
+
+    // Splits the project into chunks in file order, each with a content hash
+    std::vector<Chunk> buildChunks(const ProjectFile::ProjectData& data) {
+        // Reserved up front: the texture chunk's pieces point into the vector
+        std::vector<Chunk> chunks;
+        chunks.reserve(data.buffers.size() * 2 + 2);
+
+        for (u32 b = 0; b < data.buffers.size(); ++b) {
+            const ProjectFile::BufferView& view = data.buffers[b];
+
+            Chunk vertices;
+            vertices.section.type = ProjectFile::SECTION_VERTICES;
+            vertices.section.buffer = b;
+            vertices.section.count = view.vertexCount;
+            vertices.section.bounds[0] = view.bounds.MinEdge.X;
+            vertices.section.bounds[1] = view.bounds.MinEdge.Y;
+            vertices.section.bounds[2] = view.bounds.MinEdge.Z;
+            vertices.section.bounds[3] = view.bounds.MaxEdge.X;
+            vertices.section.bounds[4] = view.bounds.MaxEdge.Y;
+            vertices.section.bounds[5] = view.bounds.MaxEdge.Z;
+            vertices.pieces.push_back({ view.vertices, view.vertexCount * sizeof(S3DVertex) });
+            vertices.section.hash = view.vertexHash ? view.vertexHash : ProjectFile::HashPayload(view.vertices, view.vertexCount * sizeof(S3DVertex));
+            chunks.push_back(vertices);
+
+            Chunk indices;
+            indices.section.type = ProjectFile::SECTION_INDICES;
+            indices.section.buffer = b;
+            indices.section.count = view.indexCount;
+            indices.pieces.push_back({ view.indices, view.indexCount * sizeof(u16) });
+            indices.section.hash = view.indexHash ? view.indexHash : ProjectFile::HashPayload(view.indices, view.indexCount * sizeof(u16));
+            chunks.push_back(indices);
+        }
+
+        const ProjectFile::TextureView& texture = data.texture;
+        if (texture.pixels) {
+            chunks.emplace_back();
+            Chunk& chunk = chunks.back();
+            chunk.section.type = ProjectFile::SECTION_TEXTURE;
+            chunk.section.count = 1;
+            chunk.info = { texture.width, texture.height, (u32)texture.format, 0 };
+            chunk.pieces.push_back({ &chunk.info, sizeof(ProjectFile::TextureInfo) });
+
+            // Rows one by one, the pitch may be wider than the texels
+            u32 rowSize = texture.width * IImage::getBitsPerPixelFromFormat(texture.format) / 8;
+            for (u32 y = 0; y < texture.height; ++y)
+                chunk.pieces.push_back({ (const u8*)texture.pixels + (size_t)y * texture.pitch, rowSize });
+            chunk.section.hash = hashPieces(chunk.pieces);
+        }
+
+        Chunk camera;
+        camera.section.type = ProjectFile::SECTION_CAMERA;
+        camera.section.count = 1;
+        camera.pieces.push_back({ &data.camera, sizeof(ProjectFile::CameraState) });
+        camera.section.hash = hashPieces(camera.pieces);
+        chunks.push_back(camera);
+
+        return chunks;
+    }
+
+    bool readExisting(const std::string& path, Existing& existing) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        bool ok = fseek(file, 0, SEEK_END) == 0;
+        long size = ok ? ftell(file) : -1;
+        ok = size >= (long)sizeof(ProjectFile::Header) && fseek(file, 0, SEEK_SET) == 0 &&
+             fread(&existing.header, sizeof(ProjectFile::Header), 1, file) == 1;
+
+        const ProjectFile::Header& header = existing.header;
+        existing.size = (u64)size;
+        ok = ok && header.magic == ProjectFile::MAGIC && header.version == ProjectFile::VERSION &&
+             header.vertexSize == sizeof(S3DVertex) && header.fileSize <= existing.size &&
+             header.tocOffset <= header.fileSize &&
+             header.sectionCount <= (header.fileSize - header.tocOffset) / sizeof(ProjectFile::Section);
+
+        if (ok) {
+            existing.toc.resize(header.sectionCount);
+            ok = fseek(file, (long)header.tocOffset, SEEK_SET) == 0 &&
+                 fread(existing.toc.data(), sizeof(ProjectFile::Section), header.sectionCount, file) == header.sectionCount;
+        }
+        fclose(file);
+        return ok;
+    }
+
+    // Points chunks at identical sections already in the file. Each old
+    // section is claimed at most once: loading maps sections straight into
+    // mesh buffers, and two buffers must never share memory.
+    u32 reuseSections(const Existing& existing, std::vector<Chunk>& chunks) {
+        std::vector<bool> claimed(existing.toc.size(), false);
+        u32 reused = 0;
+
+        for (Chunk& chunk : chunks) {
+            u64 size = payloadSize(chunk);
+            for (size_t s = 0; s < existing.toc.size(); ++s) {
+                const ProjectFile::Section& old = existing.toc[s];
+                if (claimed[s] || old.hash == 0 || old.hash != chunk.section.hash || old.type != chunk.section.type ||
+                    old.count != chunk.section.count || old.size != size || old.offset + old.size > existing.header.fileSize)
+                    continue;
+
+                claimed[s] = true;
+                chunk.section.offset = old.offset;
+                chunk.section.size = old.size;
+                chunk.reused = true;
+                reused++;
+                break;
+            }
+        }
+        return reused;
+    }
+
+    bool writeHeader(Writer& writer, u32 sectionCount, u64 tocOffset) {
+        ProjectFile::Header header = {};
+        header.magic = ProjectFile::MAGIC;
+        header.version = ProjectFile::VERSION;
+        header.sectionCount = sectionCount;
+        header.vertexSize = sizeof(S3DVertex);
+        header.tocOffset = tocOffset;
+        header.fileSize = writer.position;
+        return fseek(writer.file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, writer.file) == 1;
+    }
+
+    // Pushes the file's data through the OS cache onto the disk
+    bool syncFile(FILE* file) {
+        if (fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // Makes a rename durable. Windows has no directory handle to sync; NTFS
+    // journals the rename itself.
+    void syncDirectory(const std::string& path) {
+#ifndef _WIN32
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+#endif
+    }
+
+    // Writes every chunk into a fresh file and renames it over the target,
+    // so a failed save never leaves half a file
+    bool writeFull(const std::string& path, std::vector<Chunk>& chunks, bool sync) {
+        std::string temporary = path + ".tmp";
+        Writer writer;
+        writer.file = fopen(temporary.c_str(), "wb");
+        if (!writer.file) {
+            std::cout << "Failed to create " << temporary << std::endl;
+            return false;
+        }
+
+        ProjectFile::Header header = {};
+        bool ok = writer.Write(&header, sizeof(header));
+
+        std::vector<ProjectFile::Section> toc;
+        for (size_t c = 0; ok && c < chunks.size(); ++c) {
+            chunks[c].reused = false;
+            ok = writer.WriteChunk(chunks[c]);
+            toc.push_back(chunks[c].section);
+        }
+
+        // Table of contents last, then patch the header now that offsets are known
+        ok = ok && writer.Pad();
+        u64 tocOffset = writer.position;
+        ok = ok && writer.Write(toc.data(), toc.size() * sizeof(ProjectFile::Section));
+        ok = ok && writeHeader(writer, (u32)toc.size(), tocOffset);
+        ok = ok && (!sync || syncFile(writer.file));
+        ok = fclose(writer.file) == 0 && ok;
+
+        std::error_code error;
+        if (ok) std::filesystem::rename(temporary, path, error);
+        if (ok && !error && sync) syncDirectory(path);
+        if (!ok || error) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    // Appends the changed chunks and a new table of contents, then points the
+    // header at it. Until that last 64-byte write the file still describes
+    // the previous save, so a crash part way loses only the new save; the
+    // loader ignores the unreferenced tail.
+    bool appendChanged(const std::string& path, const Existing& existing, std::vector<Chunk>& chunks, bool sync) {
+        Writer writer;
+        writer.file = fopen(path.c_str(), "r+b");
+        if (!writer.file)
+            return false;
+
+        writer.position = existing.size;
+        bool ok = fseek(writer.file, 0, SEEK_END) == 0;
+
+        std::vector<ProjectFile::Section> toc;
+        for (size_t c = 0; ok && c < chunks.size(); ++c) {
+            if (!chunks[c].reused)
+                ok = writer.WriteChunk(chunks[c]);
+            toc.push_back(chunks[c].section);
+        }
+
+        ok = ok && writer.Pad();
+        u64 tocOffset = writer.position;
+        ok = ok && writer.Write(toc.data(), toc.size() * sizeof(ProjectFile::Section));
+
+        // The new data must be on disk before the header can point at it
+        ok = ok && (!sync || syncFile(writer.file));
+        ok = ok && writeHeader(writer, (u32)toc.size(), tocOffset);
+        ok = ok && (!sync || syncFile(writer.file));
+        ok = fclose(writer.file) == 0 && ok;
+        return ok;
+    }
+
+    bool inBounds(const ProjectFile::Section& section, size_t fileSize) {
+        return section.offset <= fileSize && section.size <= fileSize - section.offset && section.offset % 4 == 0;
+    }
+}
+
+bool ProjectFile::Save(const std::string& path, const ProjectData& data, bool sync, SaveReport* report)
+{
+    std::vector<Chunk> chunks = buildChunks(data);
+
+    // Incremental when the target is a project we can extend and the result
+    // would not be mostly dead chunks; otherwise compact with a full rewrite
+    Existing existing;
+    bool append = readExisting(path, existing);
+    if (append) {
+        reuseSections(existing, chunks);
+
+        u64 live = sizeof(Header), appended = 0;
+        for (const Chunk& chunk : chunks) {
+            live += aligned(payloadSize(chunk));
+            if (!chunk.reused) appended += aligned(payloadSize(chunk));
+        }
+        u64 tocSize = chunks.size() * sizeof(Section);
+        f64 total = (f64)(aligned(existing.size) + appended + tocSize);
+        f64 dead = total - (f64)(live + tocSize);
+        append = dead <= total * COMPACT_DEAD_RATIO;
+    }
+
+    bool saved = append && appendChanged(path, existing, chunks, sync);
+    bool compacted = false;
+    if (!saved) {
+        saved = writeFull(path, chunks, sync);
+        compacted = saved;
+    }
+
+    if (!saved) {
+        std::cout << "Failed to save " << path << std::endl;
+        return false;
+    }
+
+    if (report) {
+        *report = SaveReport();
+        report->compacted = compacted && existing.size > 0;
+        for (const Chunk& chunk : chunks) {
+            if (chunk.reused) {
+                report->chunksReused++;
+                report->bytesReused += chunk.section.size;
+            } else {
+                report->chunksWritten++;
+                report->bytesWritten += chunk.section.size;
+            }
+        }
+    }
+    return true;
+}
+
+bool ProjectFile::Load(const std::string& path, IVideoDriver* driver, LoadedProject& out)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(path))
+        return false;
+
+    const u8* base = file->GetData();
+    const size_t size = file->GetSize();
+    const Header* header = (const Header*)base;
+
+    if (size < sizeof(Header) || header->magic != MAGIC || header->version != VERSION ||
+        header->vertexSize != sizeof(S3DVertex) || header->fileSize > size ||
+        header->tocOffset > header->fileSize || header->sectionCount > (header->fileSize - header->tocOffset) / sizeof(Section)) {
+        std::cout << "Not a valid project file: " << path << std::endl;
+        return false;
+    }
+
+    const Section* toc = (const Section*)(base + header->tocOffset);
+    std::vector<const Section*> vertexSections, indexSections;
+    out = LoadedProject();
+
+    for (u32 s = 0; s < header->sectionCount; ++s) {
+        const Section& section = toc[s];
+        if (!inBounds(section, size)) {
+            std::cout << "Corrupt section in " << path << std::endl;
+            return false;
+        }
+
+        if (section.type == SECTION_VERTICES || section.type == SECTION_INDICES) {
+            u32 elementSize = section.type == SECTION_VERTICES ? sizeof(S3DVertex) : sizeof(u16);
+            if (section.size != (u64)section.count * elementSize || section.buffer >= header->sectionCount) {
+                std::cout << "Corrupt mesh section in " << path << std::endl;
+                return false;
+            }
+
+            std::vector<const Section*>& list = section.type == SECTION_VERTICES ? vertexSections : indexSections;
+            if (list.size() <= section.buffer) list.resize(section.buffer + 1, nullptr);
+            list[section.buffer] = &section;
+        }
+        else if (section.type == SECTION_CAMERA && section.size >= sizeof(CameraState)) {
+            memcpy(&out.camera, base + section.offset, sizeof(CameraState));
+            out.hasCamera = true;
+        }
+        else if (section.type == SECTION_TEXTURE && section.size >= sizeof(TextureInfo) && driver && !out.texture) {
+            const TextureInfo* info = (const TextureInfo*)(base + section.offset);
+            u64 texels = (u64)info->width * info->height * IImage::getBitsPerPixelFromFormat((ECOLOR_FORMAT)info->format) / 8;
+            if (texels == 0 || texels > section.size - sizeof(TextureInfo)) continue;
+
+            // The image wraps the mapped texels; the upload copies them to the GPU
+            out.texture = driver->createImageFromData(
+                (ECOLOR_FORMAT)info->format,
+                dimension2d<u32>(info->width, info->height),
+                (void*)(info + 1),
+                true,
+                false
+            );
+        }
+    }
+
+    // Point each buffer at its mapped sections
+    SMesh* mesh = new SMesh();
+    for (u32 b = 0; b < vertexSections.size(); ++b) {
+        const Section* vertices = vertexSections[b];
+        const Section* indices = b < indexSections.size() ? indexSections[b] : nullptr;
+        if (!vertices || !indices) continue;
+
+        // A bad index would read outside the buffer when drawing
+        const u16* indexData = (const u16*)(base + indices->offset);
+        bool valid = indices->count % 3 == 0;
+        for (u32 i = 0; valid && i < indices->count; ++i) valid = indexData[i] < vertices->count;
+        if (!valid) {
+            std::cout << "Corrupt indices in " << path << std::endl;
+            mesh->drop();
+            if (out.texture) out.texture->drop();
+            out = LoadedProject();
+            return false;
+        }
+
+        out.hashes.push_back({ vertices->hash, indices->hash });
+
+        SMeshBuffer* buffer = new SMeshBuffer();
+        buffer->Vertices.set_pointer((S3DVertex*)(base + vertices->offset), vertices->count, false, false);
+        buffer->Indices.set_pointer((u16*)indexData, indices->count, false, false);
+        buffer->setBoundingBox(aabbox3df(
+            vertices->bounds[0], vertices->bounds[1], vertices->bounds[2],
+            vertices->bounds[3], vertices->bounds[4], vertices->bounds[5]
+        ));
+        mesh->addMeshBuffer(buffer);
+        buffer->drop();
+    }
+
+    if (mesh->getMeshBufferCount() == 0) {
+        std::cout << "Project has no mesh: " << path << std::endl;
+        mesh->drop();
+        if (out.texture) out.texture->drop();
+        out = LoadedProject();
+        return false;
+    }
+
+    mesh->recalculateBoundingBox();
+    out.mesh = mesh;
+    out.file = file;
+    return true;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "io/MappedFile.h"
+#include "helpers/Hash.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+using namespace scene;
+
+// Native project format (.jbx).
+//
+// [Header][section][section]...[table of contents]
+//
+// Sections start on ALIGNMENT byte boundaries and hold data in exactly the
+// layout the editor uses in memory (S3DVertex arrays, 16-bit indices, raw
+// texels), so loading maps the file and points the mesh buffers straight at
+// it. Files are little-endian.
+//
+// Saves are incremental. Every section carries a content hash; saving over
+// an existing project keeps the sections whose hash still matches, appends
+// only the changed ones plus a new table of contents, and then rewrites the
+// header to point at it. Sections no table references anymore are dead
+// space, and once they would make up more than COMPACT_DEAD_RATIO of the
+// file the save rewrites it from scratch instead.
+namespace ProjectFile {
+    inline constexpr u32 MAGIC = 0x3158424A; // "JBX1"
+    inline constexpr u32 VERSION = 1;
+    inline constexpr u32 ALIGNMENT = 64;
+    inline constexpr f64 COMPACT_DEAD_RATIO = 0.5;
+
+    enum SectionType : u32 {
+        SECTION_VERTICES = 1, // S3DVertex[count] for one mesh buffer
+        SECTION_INDICES = 2,  // u16[count] for one mesh buffer
+        SECTION_TEXTURE = 3,  // TextureInfo followed by tightly packed texels
+        SECTION_CAMERA = 4    // CameraState
+    };
+
+    struct Header {
+        u32 magic;
+        u32 version;
+        u32 sectionCount;
+        u32 vertexSize;   // sizeof(S3DVertex) when written, guards against layout changes
+        u64 tocOffset;
+        u64 fileSize;     // Up to the end of the table; an interrupted append leaves junk past it
+        u8 reserved[32];
+    };
+
+    struct Section {
+        u32 type;
+        u32 buffer;       // Mesh buffer the section belongs to
+        u32 count;        // Elements (vertices, indices)
+        u32 flags;
+        u64 offset;
+        u64 size;
+        f32 bounds[6];    // Vertex sections: bounding box, so loading never scans positions
+        u64 hash;         // Hash::Bytes of the payload, 0 if unknown
+    };
+
+    struct TextureInfo {
+        u32 width;
+        u32 height;
+        u32 format;       // ECOLOR_FORMAT
+        u32 reserved;
+    };
+
+    // Orbit of the model viewport camera
+    struct CameraState {
+        f32 radius;
+        f32 theta;
+        f32 phi;
+        f32 reserved;
+    };
+
+    static_assert(sizeof(Header) == 64, "Header layout is part of the file format");
+    static_assert(sizeof(Section) == 64, "Section layout is part of the file format");
+    static_assert(sizeof(TextureInfo) == 16 && sizeof(CameraState) == 16, "Section payload layout is part of the file format");
+
+    // What to write. Views only point at data owned elsewhere, so callers can
+    // pass live buffers or a snapshot.
+    struct BufferView {
+        const S3DVertex* vertices = nullptr;
+        u32 vertexCount = 0;
+        const u16* indices = nullptr;
+        u32 indexCount = 0;
+        aabbox3df bounds;
+
+        // Content hashes if the caller already knows them, 0 to hash while saving
+        u64 vertexHash = 0;
+        u64 indexHash = 0;
+    };
+
+    struct BufferHashes {
+        u64 vertices = 0;
+        u64 indices = 0;
+    };
+
+    struct TextureView {
+        const void* pixels = nullptr;
+        u32 width = 0;
+        u32 height = 0;
+        u32 pitch = 0;
+        ECOLOR_FORMAT format = ECF_A8R8G8B8;
+    };
+
+    struct ProjectData {
+        std::vector<BufferView> buffers;
+        TextureView texture;
+        CameraState camera = {};
+    };
+
+    // Result of a load. The mesh and texture image point into `file`, which
+    // must outlive them (or be detached from first).
+    struct LoadedProject {
+        std::shared_ptr<MappedFile> file;
+        SMesh* mesh = nullptr;
+        IImage* texture = nullptr;
+        CameraState camera = {};
+        bool hasCamera = false;
+        std::vector<BufferHashes> hashes; // Per mesh buffer, as stored (0 if unknown)
+    };
+
+    struct SaveReport {
+        u32 chunksWritten = 0;
+        u32 chunksReused = 0;
+        u64 bytesWritten = 0;
+        u64 bytesReused = 0;
+        bool compacted = false;
+    };
+
+    // Content hash that sections are matched by between saves
+    inline u64 HashPayload(const void* data, size_t size) {
+        u64 hash = Hash::Bytes(data, size);
+        return hash ? hash : 1; // 0 means unknown
+    }
+
+    // With `sync` the data is on disk (fsync) before it replaces `path`, and
+    // the rename is synced too, so the file survives a crash or power loss.
+    // Over an existing project only the changed sections are written; see
+    // above. `report`, if given, says what was written and reused.
+    bool Save(const std::string& path, const ProjectData& data, bool sync = false, SaveReport* report = nullptr);
+    bool Load(const std::string& path, IVideoDriver* driver, LoadedProject& out);
+}
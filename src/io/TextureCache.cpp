@@ -0,0 +1,240 @@
+#include "TextureCache.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "helpers/Hash.h"
+#include "helpers/Parallel.h"
+#include "helpers/Profiler.h"
+
+namespace {
+    // One spelling per file, so "assets/./crate.png" and "assets/crate.png" share an entry
+    std::string normalisePath(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+}
+
+TextureCache::TextureCache()
+    : _driver(nullptr),
+      _fileSystem(nullptr),
+      _placeholder(nullptr),
+      _pending(0),
+      _stopping(false)
+{
+    // Leave a core for the main thread; decoding is rarely the bottleneck
+    u32 workers = std::clamp(Parallel::WorkerCount() - 1, 1u, MAX_WORKERS);
+    for (u32 i = 0; i < workers; ++i)
+        _workers.emplace_back(&TextureCache::_work, this);
+}
+
+TextureCache::~TextureCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _requests.clear();
+    }
+    _wake.notify_all();
+    for (std::thread& worker : _workers)
+        worker.join();
+
+    for (Decoded& decoded : _decoded) {
+        if (decoded.image) decoded.image->drop();
+    }
+}
+
+void TextureCache::Attach(IVideoDriver* driver, io::IFileSystem* fileSystem)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _driver = driver;
+        _fileSystem = fileSystem;
+    }
+    _createPlaceholder();
+    _wake.notify_all();
+}
+
+ITexture* TextureCache::Request(const std::string& path, Callback onReady)
+{
+    std::string key = normalisePath(path);
+    auto it = _entries.find(key);
+
+    if (it == _entries.end()) {
+        Entry& entry = _entries[key];
+
+        // Already loaded some other way (driver->getTexture, an earlier session)
+        entry.texture = _driver ? _driver->findTexture(key.c_str()) : nullptr;
+        if (!entry.texture) {
+            if (onReady) entry.waiting.push_back(std::move(onReady));
+            _pending++;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _requests.push_back(key);
+            }
+            _wake.notify_one();
+            return _placeholder;
+        }
+        it = _entries.find(key);
+    }
+
+    Entry& entry = it->second;
+    if (entry.texture) {
+        if (onReady) onReady(entry.texture);
+        return entry.texture;
+    }
+
+    if (!entry.failed && onReady)
+        entry.waiting.push_back(std::move(onReady));
+    return _placeholder;
+}
+
+void TextureCache::Update(f64 budgetMilliseconds)
+{
+    if (_pending == 0 || !_driver)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    for (bool first = true;; first = false) {
+        if (!first && std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMilliseconds)
+            break;
+
+        Decoded decoded;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_decoded.empty())
+                break;
+            decoded = std::move(_decoded.front());
+            _decoded.pop_front();
+        }
+        _upload(decoded);
+    }
+}
+
+void TextureCache::_work()
+{
+    for (;;) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this]() { return _stopping || !_requests.empty(); });
+            if (_stopping)
+                return;
+            path = std::move(_requests.front());
+            _requests.pop_front();
+        }
+
+        // Reading needs no driver, so it overlaps device creation at boot
+        std::vector<u8> bytes;
+        bool read = _read(path, bytes);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this]() { return _stopping || _driver; });
+            if (_stopping)
+                return;
+        }
+
+        Decoded decoded;
+        if (read) {
+            decoded = _decode(path, bytes);
+        } else {
+            decoded.path = path;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) {
+            if (decoded.image) decoded.image->drop();
+            return;
+        }
+        _decoded.push_back(std::move(decoded));
+    }
+}
+
+bool TextureCache::_read(const std::string& path, std::vector<u8>& bytes)
+{
+    Profiler::Scope scope("Texture read");
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cout << "Failed to open texture " << path << std::endl;
+        return false;
+    }
+
+    bytes.resize((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read((char*)bytes.data(), bytes.size())) {
+        std::cout << "Failed to read texture " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TextureCache::Decoded TextureCache::_decode(const std::string& path, std::vector<u8>& bytes)
+{
+    Profiler::Scope scope("Texture decode");
+    Decoded decoded;
+    decoded.path = path;
+    decoded.hash = Hash::Bytes(bytes.data(), bytes.size());
+
+    // Irrlicht's image loaders keep no state between calls, so decoding from
+    // a private memory file is safe off the main thread
+    io::IReadFile* memoryFile = _fileSystem->createMemoryReadFile(bytes.data(), (s32)bytes.size(), path.c_str(), false);
+    if (memoryFile) {
+        decoded.image = _driver->createImageFromFile(memoryFile);
+        memoryFile->drop();
+    }
+    if (!decoded.image)
+        std::cout << "Failed to decode texture " << path << std::endl;
+    return decoded;
+}
+
+void TextureCache::_upload(Decoded& decoded)
+{
+    Entry& entry = _entries[decoded.path];
+    _pending--;
+
+    if (decoded.image) {
+        auto same = _byHash.find(decoded.hash);
+        if (same != _byHash.end()) {
+            entry.texture = same->second;
+        } else {
+            Profiler::Scope scope("Texture upload");
+            entry.texture = _driver->addTexture(decoded.path.c_str(), decoded.image);
+            if (entry.texture)
+                _byHash[decoded.hash] = entry.texture;
+        }
+        decoded.image->drop();
+        decoded.image = nullptr;
+    }
+
+    if (!entry.texture) {
+        entry.failed = true;
+        entry.waiting.clear();
+        return;
+    }
+
+    // Callbacks may request more textures, which can rehash the map
+    std::vector<Callback> waiting = std::move(entry.waiting);
+    ITexture* texture = entry.texture;
+    for (Callback& callback : waiting)
+        callback(texture);
+}
+
+void TextureCache::_createPlaceholder()
+{
+    // Magenta and black checks: obviously not the real texture
+    IImage* image = _driver->createImage(ECF_A8R8G8B8, core::dimension2d<u32>(PLACEHOLDER_SIZE, PLACEHOLDER_SIZE));
+    if (!image)
+        return;
+
+    for (u32 y = 0; y < PLACEHOLDER_SIZE; ++y) {
+        for (u32 x = 0; x < PLACEHOLDER_SIZE; ++x) {
+            bool odd = ((x / 2) + (y / 2)) % 2 == 1;
+            image->setPixel(x, y, odd ? SColor(255, 255, 0, 255) : SColor(255, 0, 0, 0));
+        }
+    }
+
+    _placeholder = _driver->addTexture("#placeholder", image);
+    image->drop();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace irr;
+using namespace video;
+
+// Texture loading off the main thread. Workers read and decode image files;
+// the main thread uploads the results in Update() within a time budget, so
+// a frame never waits on the disk or a decoder. Until its upload lands a
+// request is answered with a placeholder texture.
+//
+// Requests are deduplicated by path, and uploads by content hash: two files
+// with the same bytes share one texture.
+//
+// The cache exists before the device does: files requested early are read
+// while the device is created and decoded as soon as Attach() hands over
+// the driver.
+class TextureCache {
+public:
+    static constexpr u32 MAX_WORKERS = 2;
+    static constexpr f64 DEFAULT_UPLOAD_BUDGET_MS = 2.0;
+    static constexpr u32 PLACEHOLDER_SIZE = 8;
+
+    using Callback = std::function<void(ITexture*)>;
+
+    TextureCache();
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Main thread, once the device exists. Creates the placeholder and lets
+    // the workers decode.
+    void Attach(IVideoDriver* driver, io::IFileSystem* fileSystem);
+
+    // Starts reading a file before anyone needs it; safe before Attach()
+    void Prefetch(const std::string& path) { Request(path); }
+
+    // The texture if it is already uploaded, otherwise the placeholder (null
+    // before Attach). `onReady` runs on the main thread once the real texture
+    // is uploaded (immediately if it already is); failed loads never call back.
+    ITexture* Request(const std::string& path, Callback onReady = nullptr);
+
+    // Main thread, once per frame. Uploads decoded images until the budget
+    // is spent, always at least one so loading can't stall.
+    void Update(f64 budgetMilliseconds = DEFAULT_UPLOAD_BUDGET_MS);
+
+    ITexture* GetPlaceholder() const { return _placeholder; }
+    bool IsPlaceholder(const ITexture* texture) const { return texture && texture == _placeholder; }
+    u32 GetPendingCount() const { return _pending; }
+
+private:
+    struct Entry {
+        ITexture* texture = nullptr;
+        bool failed = false;
+        std::vector<Callback> waiting;
+    };
+
+    struct Decoded {
+        std::string path;
+        u64 hash = 0;
+        IImage* image = nullptr;
+    };
+
+    IVideoDriver* _driver;        // Written under _mutex by Attach
+    io::IFileSystem* _fileSystem;
+    ITexture* _placeholder;
+
+    // Main thread only
+    std::unordered_map<std::string, Entry> _entries;
+    std::unordered_map<u64, ITexture*> _byHash;
+    u32 _pending;
+
+    // Shared with the workers
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<std::string> _requests;
+    std::deque<Decoded> _decoded;
+    bool _stopping;
+    std::vector<std::thread> _workers;
+
+    void _work();
+    bool _read(const std::string& path, std::vector<u8>& bytes);
+    Decoded _decode(const std::string& path, std::vector<u8>& bytes);
+    void _upload(Decoded& decoded);
+    void _createPlaceholder();
+};
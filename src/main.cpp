@@ -2,14 +2,19 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
 
 #include "Application.h"
 #include "JuiceBoxEventListener.h"
 #include "ImGuiInputHandler.h"
 #include "editor/Editor.h"
+#include "ThumbnailBatch.h"
 
 // Helpers
 #include "helpers/Mesh.h"
+#include "helpers/BootProfiler.h"
 
 // ImGui includes
 #include "imgui.h"
@@ -36,15 +41,77 @@ void forwardEventToImGui(const SEvent& event) {
 bool ImGuiInputHandler::wantCaptureMouse = false;
 bool ImGuiInputHandler::wantCaptureKeyboard = false;
 
-int main() {
+int main(int argc, char** argv) {
     /* ================================
     SETUP
     =================================*/
+    BootProfiler::Start();
+
+    // juicebox [--autosave-interval=<seconds>] [--autosave-keep=<count>] [--reference=<mesh.obj>]...
+    //         [model.obj | project.jbx]
+    // juicebox --thumbnails=<dir> [--thumbnail-size=<px>] [--threads=<count>] <model.obj | project.jbx>...
+    Autosave::Settings autosave;
+    ThumbnailBatch::Settings thumbnails;
+    bool thumbnailMode = false;
+    std::vector<std::string> references;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--autosave-interval=", 0) == 0) {
+            autosave.intervalSeconds = std::atof(arg.c_str() + 20);
+        } else if (arg.rfind("--autosave-keep=", 0) == 0) {
+            autosave.keep = (u32)std::max(std::atoi(arg.c_str() + 16), 1);
+        } else if (arg.rfind("--reference=", 0) == 0) {
+            references.push_back(arg.substr(12));
+        } else if (arg.rfind("--thumbnails=", 0) == 0) {
+            thumbnailMode = true;
+            thumbnails.directory = arg.substr(13);
+        } else if (arg.rfind("--thumbnail-size=", 0) == 0) {
+            thumbnails.size = (u32)std::max(std::atoi(arg.c_str() + 17), 0);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            thumbnails.threads = (u32)std::max(std::atoi(arg.c_str() + 10), 1);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    // Batch mode: no window, no GUI, no editor
+    if (thumbnailMode) {
+        // The device's framebuffer is this size too, so clamp before creating it
+        thumbnails.size = core::clamp(thumbnails.size, ThumbnailBatch::MIN_SIZE, ThumbnailBatch::MAX_SIZE);
+        Application app;
+        if (!app.BeginHeadless(dimension2d<u32>(thumbnails.size, thumbnails.size)))
+            return 1;
+
+        ThumbnailBatch batch(app, thumbnails);
+        std::vector<ThumbnailBatch::Report> reports = batch.Run(files);
+        Profiler::Print();
+        bool failed = std::any_of(reports.begin(), reports.end(), [](const ThumbnailBatch::Report& r) { return !r.written; });
+        return failed ? 1 : 0;
+    }
+
+    // Texture workers start with the application, so the default texture is
+    // read from disk while the device is being created
     Application app;
+    app.textures->Prefetch(Model::DEFAULT_TEXTURE_PATH);
+    BootProfiler::Phase("Application");
+
     app.BeginCore();
     app.BeginGUI();
 
     Editor editor(app);
+    BootProfiler::Phase("Editor");
+    editor.ConfigureAutosave(autosave);
+
+    if (!files.empty()) {
+        editor.OpenFile(files.back());
+        BootProfiler::Phase("Open file");
+    }
+
+    for (const std::string& reference : references)
+        editor.AddReference(reference);
+    if (!references.empty())
+        BootProfiler::Phase("References");
 
     /* ================================
     MAIN LOOP 
@@ -76,6 +143,124 @@ int main() {
             std::cout << "FACE MODE" << std::endl;
         }
 
+        if (app.receiver.IsKeyPressed(KEY_KEY_X)) {
+            editor.ExtrudeFaces();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_I)) {
+            editor.InsetFaces();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_M)) {
+            editor.CleanupMesh();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_U)) {
+            editor.PackUVs();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_N)) {
+            editor.UnwrapUVs();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_G)) {
+            editor.BuildTextureAtlas();
+        }
+
+        // Project: F5 saves, F9 loads
+        if (app.receiver.IsKeyPressed(KEY_F5)) {
+            editor.SaveProject(Editor::PROJECT_PATH);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_F9)) {
+            editor.LoadProject(Editor::PROJECT_PATH);
+        }
+
+        // Export: F6 writes OBJ, F7 writes PLY, F8 writes PSX
+        if (app.receiver.IsKeyPressed(KEY_F6)) {
+            editor.ExportMesh(Editor::EXPORT_OBJ_PATH);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_F7)) {
+            editor.ExportMesh(Editor::EXPORT_PLY_PATH);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_F8)) {
+            editor.ExportMesh(Editor::EXPORT_PSX_PATH);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_P)) {
+            editor.TogglePsxPreview();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_T)) {
+            editor.TogglePaintMode();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_MINUS)) {
+            editor.ScaleBrush(0.8f);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_PLUS)) {
+            editor.ScaleBrush(1.25f);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_C)) {
+            editor.CycleBrushColor();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_B)) {
+            editor.CycleBrushMode();
+        }
+
+        if (app.receiver.ControlDown && app.receiver.IsKeyPressed(KEY_KEY_Z)) {
+            editor.UndoPaint();
+        }
+
+        if (app.receiver.ControlDown && app.receiver.IsKeyPressed(KEY_KEY_Y)) {
+            editor.RedoPaint();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_L)) {
+            editor.CycleTextureMode();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_K)) {
+            editor.RecolorClutEntry();
+        }
+
+        // Primitives: 1-6 add cube, sphere, cylinder, torus, plane, cone; PgUp/PgDn change detail
+        for (s32 i = 0; i < PrimitiveType::PRIMITIVE_COUNT; ++i) {
+            if (app.receiver.IsKeyPressed((EKEY_CODE)(KEY_KEY_1 + i))) {
+                editor.AddPrimitive((PrimitiveType)i);
+            }
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_PRIOR)) {
+            editor.ScalePrimitiveDetail(2.0f);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_NEXT)) {
+            editor.ScalePrimitiveDetail(0.5f);
+        }
+
+        // Proportional editing: O toggles, [ and ] resize, F cycles the falloff
+        if (app.receiver.IsKeyPressed(KEY_KEY_O)) {
+            editor.ToggleProportionalEditing();
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_OEM_4)) {
+            editor.ScaleProportionalRadius(0.8f);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_OEM_6)) {
+            editor.ScaleProportionalRadius(1.25f);
+        }
+
+        if (app.receiver.IsKeyPressed(KEY_KEY_F)) {
+            editor.CycleFalloff();
+        }
+
         if (app.device->isWindowActive()) {
             /* ================================
             USER INTERACTION
@@ -93,6 +278,7 @@ int main() {
             app.driver->beginScene(true, true, SColor(255, 40, 40, 40));
             editor.Draw();
             app.driver->endScene();
+            BootProfiler::FirstFrame();
             app.receiver.UpdateLastPosition();
             app.receiver.EndFrame();
         }
@@ -0,0 +1,520 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUICEBOX_BRUSH_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JUICEBOX_BRUSH_AVX2 1
+#endif
+
+using namespace irr;
+
+// Row kernels behind the painter's brushes. A stamp is applied one texel row
+// at a time in two steps: a coverage kernel writes a weight (0..256) per
+// texel, then a compositing kernel moves each texel towards a target colour
+// by its weight. Texels are 32-bit with four 8-bit channels; the kernels
+// treat every channel alike, so the byte order does not matter. Indexed
+// canvases use the same weights with the *Index kernels.
+//
+// Each kernel has a scalar version and SSE2 (4 texels) and AVX2 (8 texels)
+// paths picked at compile time like PsxQuantize; AVX2 needs the build to
+// target it (configure with JUICEBOX_AVX2=ON). The vector paths do the same
+// arithmetic in the same order, so every path gives the same bytes, which
+// bench/BrushKernelsBench checks (JUICEBOX_BENCHMARKS=ON).
+namespace BrushKernels {
+    inline constexpr u32 FULL_WEIGHT = 256;
+    inline constexpr u32 HALF_WEIGHT = 128;
+
+    // (d * (256 - w) + s * w) >> 8 per channel, which is d + (s - d) * w / 256
+    // rounded down, and never leaves 16 bits in the vector paths
+    inline u32 BlendTexel(u32 d, u32 s, u32 w) {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 dc = (d >> shift) & 0xFFu;
+            u32 sc = (s >> shift) & 0xFFu;
+            result |= ((dc * (FULL_WEIGHT - w) + sc * w) >> 8) << shift;
+        }
+        return result;
+    }
+
+    // Largest per-channel difference over the colour channels (not alpha)
+    inline u32 ColorDistance(u32 a, u32 b) {
+        u32 largest = 0;
+        for (u32 shift = 0; shift < 24; shift += 8) {
+            s32 difference = (s32)((a >> shift) & 0xFFu) - (s32)((b >> shift) & 0xFFu);
+            largest = std::max(largest, (u32)std::abs(difference));
+        }
+        return largest;
+    }
+
+    // Squared distance over the colour channels, used to find a palette entry
+    inline u32 ColorDistanceSq(u32 a, u32 b) {
+        u32 sum = 0;
+        for (u32 shift = 0; shift < 24; shift += 8) {
+            s32 difference = (s32)((a >> shift) & 0xFFu) - (s32)((b >> shift) & 0xFFu);
+            sum += (u32)(difference * difference);
+        }
+        return sum;
+    }
+
+    // Nearest entry, the first one on ties
+    inline u32 NearestColor(u32 texel, const u32* palette, u32 paletteCount) {
+        u32 best = palette[0];
+        u32 bestDistance = ColorDistanceSq(texel, palette[0]);
+        for (u32 p = 1; p < paletteCount; ++p) {
+            u32 distance = ColorDistanceSq(texel, palette[p]);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = palette[p];
+            }
+        }
+        return best;
+    }
+
+    namespace Scalar {
+        // Weights for one row of a round brush: texels x0 .. x0 + count - 1
+        // of a row `dy` below a brush centred at `centerX`
+
+        // Hard brush: full strength inside the radius, nothing outside
+        inline void HardRound(s32 x0, f32 centerX, f32 dy, u32 count, f32 radius, f32 strength, u16* weights) {
+            const f32 radiusSq = radius * radius;
+            const f32 dySq = dy * dy;
+            const u16 weight = (u16)std::min((u32)(strength + 0.5f), FULL_WEIGHT);
+            for (u32 i = 0; i < count; ++i) {
+                f32 dx = (f32)(x0 + (s32)i) - centerX;
+                weights[i] = dx * dx + dySq < radiusSq ? weight : 0;
+            }
+        }
+
+        // Soft brush: full strength inside `core`, then a linear falloff to the rim
+        inline void SoftRound(s32 x0, f32 centerX, f32 dy, u32 count, f32 radius, f32 core, f32 strength, u16* weights) {
+            const f32 dySq = dy * dy;
+            const f32 inverseFalloff = 1.0f / std::max(radius - core, 0.0001f);
+            for (u32 i = 0; i < count; ++i) {
+                f32 dx = (f32)(x0 + (s32)i) - centerX;
+                f32 distance = std::sqrt(dx * dx + dySq);
+                f32 coverage = std::min(1.0f - (distance - core) * inverseFalloff, 1.0f);
+                weights[i] = distance < radius
+                    ? (u16)std::min((u32)(coverage * strength + 0.5f), FULL_WEIGHT)
+                    : 0;
+            }
+        }
+
+        // Alpha blend towards `color`
+        inline void Blend(u32* texels, const u16* weights, u32 count, u32 color) {
+            for (u32 i = 0; i < count; ++i)
+                texels[i] = BlendTexel(texels[i], color, weights[i]);
+        }
+
+        // Colour replacement: only texels within `tolerance` of `target` on
+        // every colour channel move towards `color`
+        inline void Replace(u32* texels, const u16* weights, u32 count, u32 target, u32 tolerance, u32 color) {
+            for (u32 i = 0; i < count; ++i) {
+                if (ColorDistance(texels[i], target) <= tolerance)
+                    texels[i] = BlendTexel(texels[i], color, weights[i]);
+            }
+        }
+
+        // Palette snapping: texels move towards their nearest palette entry
+        inline void Snap(u32* texels, const u16* weights, u32 count, const u32* palette, u32 paletteCount) {
+            for (u32 i = 0; i < count; ++i) {
+                if (weights[i])
+                    texels[i] = BlendTexel(texels[i], NearestColor(texels[i], palette, paletteCount), weights[i]);
+            }
+        }
+
+        // Index of the nearest palette entry for each texel, the first on ties
+        inline void NearestIndex(const u32* texels, u32 count, const u32* palette, u32 paletteCount, u8* indices) {
+            for (u32 i = 0; i < count; ++i) {
+                u32 best = 0;
+                u32 bestDistance = ColorDistanceSq(texels[i], palette[0]);
+                for (u32 p = 1; p < paletteCount; ++p) {
+                    u32 distance = ColorDistanceSq(texels[i], palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices[i] = (u8)best;
+            }
+        }
+
+        // Indexed texels can't be partly covered: at least half weight takes the index
+        inline void PaintIndex(u8* indices, const u16* weights, u32 count, u8 index) {
+            for (u32 i = 0; i < count; ++i) {
+                if (weights[i] >= HALF_WEIGHT)
+                    indices[i] = index;
+            }
+        }
+
+        inline void ReplaceIndex(u8* indices, const u16* weights, u32 count, u8 target, u8 index) {
+            for (u32 i = 0; i < count; ++i) {
+                if (weights[i] >= HALF_WEIGHT && indices[i] == target)
+                    indices[i] = index;
+            }
+        }
+    }
+
+#ifdef JUICEBOX_BRUSH_SSE2
+    namespace Sse2 {
+        // Eight 16-bit weights from four: each texel's weight over its four channels
+        inline void ExpandWeights(__m128i weights4, __m128i& low, __m128i& high) {
+            __m128i pairs = _mm_unpacklo_epi16(weights4, weights4);
+            low = _mm_unpacklo_epi32(pairs, pairs);
+            high = _mm_unpackhi_epi32(pairs, pairs);
+        }
+
+        // Four texels towards four colours, weights already expanded
+        inline __m128i Blend4(__m128i texels, __m128i colors, __m128i weightLow, __m128i weightHigh) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i full = _mm_set1_epi16((s16)FULL_WEIGHT);
+            __m128i low = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpacklo_epi8(texels, zero), _mm_sub_epi16(full, weightLow)),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(colors, zero), weightLow));
+            __m128i high = _mm_add_epi16(
+                _mm_mullo_epi16(_mm_unpackhi_epi8(texels, zero), _mm_sub_epi16(full, weightHigh)),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(colors, zero), weightHigh));
+            return _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+        }
+
+        // Four 32-bit weights narrowed to u16 and stored
+        inline void StoreWeights(__m128i weights, u16* out) {
+            __m128i packed = _mm_packs_epi32(weights, weights);
+            _mm_storel_epi64((__m128i*)out, _mm_min_epi16(packed, _mm_set1_epi16((s16)FULL_WEIGHT)));
+        }
+
+        // Sum of squares over the colour channels of four texel/colour pairs
+        inline __m128i DistanceSq4(__m128i texels, __m128i colors) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+            texels = _mm_and_si128(texels, colorMask);
+            colors = _mm_and_si128(colors, colorMask);
+            __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(texels, zero), _mm_unpacklo_epi8(colors, zero));
+            __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(texels, zero), _mm_unpackhi_epi8(colors, zero));
+            low = _mm_madd_epi16(low, low);   // Pairs of channels per 32 bits
+            high = _mm_madd_epi16(high, high);
+            low = _mm_add_epi32(low, _mm_srli_epi64(low, 32));
+            high = _mm_add_epi32(high, _mm_srli_epi64(high, 32));
+            return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+    }
+#endif
+
+#ifdef JUICEBOX_BRUSH_AVX2
+    namespace Avx2 {
+        inline void ExpandWeights(__m128i weights8, __m256i& low, __m256i& high) {
+            // (w, w) per 32 bits, then unpacked within lanes to match the texels
+            __m256i pairs = _mm256_mullo_epi32(_mm256_cvtepu16_epi32(weights8), _mm256_set1_epi32(0x00010001));
+            low = _mm256_unpacklo_epi32(pairs, pairs);
+            high = _mm256_unpackhi_epi32(pairs, pairs);
+        }
+
+        inline __m256i Blend8(__m256i texels, __m256i colors, __m256i weightLow, __m256i weightHigh) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i full = _mm256_set1_epi16((s16)FULL_WEIGHT);
+            __m256i low = _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(texels, zero), _mm256_sub_epi16(full, weightLow)),
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(colors, zero), weightLow));
+            __m256i high = _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(texels, zero), _mm256_sub_epi16(full, weightHigh)),
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(colors, zero), weightHigh));
+            return _mm256_packus_epi16(_mm256_srli_epi16(low, 8), _mm256_srli_epi16(high, 8));
+        }
+
+        inline void StoreWeights(__m256i weights, u16* out) {
+            __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(weights), _mm256_extracti128_si256(weights, 1));
+            _mm_storeu_si128((__m128i*)out, _mm_min_epi16(packed, _mm_set1_epi16((s16)FULL_WEIGHT)));
+        }
+
+        inline __m256i DistanceSq8(__m256i texels, __m256i colors) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+            texels = _mm256_and_si256(texels, colorMask);
+            colors = _mm256_and_si256(colors, colorMask);
+            __m256i low = _mm256_sub_epi16(_mm256_unpacklo_epi8(texels, zero), _mm256_unpacklo_epi8(colors, zero));
+            __m256i high = _mm256_sub_epi16(_mm256_unpackhi_epi8(texels, zero), _mm256_unpackhi_epi8(colors, zero));
+            low = _mm256_madd_epi16(low, low);
+            high = _mm256_madd_epi16(high, high);
+            low = _mm256_add_epi32(low, _mm256_srli_epi64(low, 32));
+            high = _mm256_add_epi32(high, _mm256_srli_epi64(high, 32));
+            return _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(low), _mm256_castsi256_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+    }
+#endif
+
+    inline void HardRound(s32 x0, f32 centerX, f32 dy, u32 count, f32 radius, f32 strength, u16* weights) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_SSE2)
+        const __m128 dySq = _mm_set1_ps(dy * dy);
+        const __m128 radiusSq = _mm_set1_ps(radius * radius);
+        const __m128 center = _mm_set1_ps(centerX);
+        const __m128i weight = _mm_set1_epi32((s32)std::min((u32)(strength + 0.5f), FULL_WEIGHT));
+        const __m128i offsets = _mm_setr_epi32(0, 1, 2, 3);
+        for (; i + 4 <= count; i += 4) {
+            __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x0 + (s32)i), offsets)), center);
+            __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), dySq);
+            __m128i inside = _mm_castps_si128(_mm_cmplt_ps(distanceSq, radiusSq));
+            Sse2::StoreWeights(_mm_and_si128(inside, weight), weights + i);
+        }
+#endif
+        Scalar::HardRound(x0 + (s32)i, centerX, dy, count - i, radius, strength, weights + i);
+    }
+
+    inline void SoftRound(s32 x0, f32 centerX, f32 dy, u32 count, f32 radius, f32 core, f32 strength, u16* weights) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_AVX2)
+        {
+            const __m256 dySq = _mm256_set1_ps(dy * dy);
+            const __m256 inverseFalloff = _mm256_set1_ps(1.0f / std::max(radius - core, 0.0001f));
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 half = _mm256_set1_ps(0.5f);
+            const __m256 coreV = _mm256_set1_ps(core);
+            const __m256 radiusV = _mm256_set1_ps(radius);
+            const __m256 strengthV = _mm256_set1_ps(strength);
+            const __m256 center = _mm256_set1_ps(centerX);
+            const __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            for (; i + 8 <= count; i += 8) {
+                __m256 dx = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x0 + (s32)i), offsets)), center);
+                __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), dySq));
+                __m256 coverage = _mm256_min_ps(_mm256_sub_ps(one, _mm256_mul_ps(_mm256_sub_ps(distance, coreV), inverseFalloff)), one);
+                __m256i weight = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(coverage, strengthV), half));
+                __m256i inside = _mm256_castps_si256(_mm256_cmp_ps(distance, radiusV, _CMP_LT_OQ));
+                Avx2::StoreWeights(_mm256_and_si256(inside, weight), weights + i);
+            }
+        }
+#endif
+#if defined(JUICEBOX_BRUSH_SSE2)
+        {
+            const __m128 dySq = _mm_set1_ps(dy * dy);
+            const __m128 inverseFalloff = _mm_set1_ps(1.0f / std::max(radius - core, 0.0001f));
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 coreV = _mm_set1_ps(core);
+            const __m128 radiusV = _mm_set1_ps(radius);
+            const __m128 strengthV = _mm_set1_ps(strength);
+            const __m128 center = _mm_set1_ps(centerX);
+            const __m128i offsets = _mm_setr_epi32(0, 1, 2, 3);
+            for (; i + 4 <= count; i += 4) {
+                __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x0 + (s32)i), offsets)), center);
+                __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), dySq));
+                __m128 coverage = _mm_min_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(distance, coreV), inverseFalloff)), one);
+                __m128i weight = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, strengthV), half));
+                __m128i inside = _mm_castps_si128(_mm_cmplt_ps(distance, radiusV));
+                Sse2::StoreWeights(_mm_and_si128(inside, weight), weights + i);
+            }
+        }
+#endif
+        Scalar::SoftRound(x0 + (s32)i, centerX, dy, count - i, radius, core, strength, weights + i);
+    }
+
+    inline void Blend(u32* texels, const u16* weights, u32 count, u32 color) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_AVX2)
+        const __m256i colors8 = _mm256_set1_epi32((s32)color);
+        for (; i + 8 <= count; i += 8) {
+            __m256i weightLow, weightHigh;
+            Avx2::ExpandWeights(_mm_loadu_si128((const __m128i*)(weights + i)), weightLow, weightHigh);
+            __m256i texels8 = _mm256_loadu_si256((const __m256i*)(texels + i));
+            _mm256_storeu_si256((__m256i*)(texels + i), Avx2::Blend8(texels8, colors8, weightLow, weightHigh));
+        }
+#endif
+#if defined(JUICEBOX_BRUSH_SSE2)
+        const __m128i colors4 = _mm_set1_epi32((s32)color);
+        for (; i + 4 <= count; i += 4) {
+            __m128i weightLow, weightHigh;
+            Sse2::ExpandWeights(_mm_loadl_epi64((const __m128i*)(weights + i)), weightLow, weightHigh);
+            __m128i texels4 = _mm_loadu_si128((const __m128i*)(texels + i));
+            _mm_storeu_si128((__m128i*)(texels + i), Sse2::Blend4(texels4, colors4, weightLow, weightHigh));
+        }
+#endif
+        Scalar::Blend(texels + i, weights + i, count - i, color);
+    }
+
+    inline void Replace(u32* texels, const u16* weights, u32 count, u32 target, u32 tolerance, u32 color) {
+        u32 i = 0;
+        tolerance = std::min(tolerance, 255u);
+#if defined(JUICEBOX_BRUSH_AVX2)
+        {
+            const __m256i colors8 = _mm256_set1_epi32((s32)color);
+            const __m256i targets = _mm256_set1_epi32((s32)target);
+            const __m256i tolerances = _mm256_set1_epi8((char)tolerance);
+            const __m256i alphaBytes = _mm256_set1_epi32((s32)0xFF000000u);
+            const __m256i allSet = _mm256_set1_epi32(-1);
+            for (; i + 8 <= count; i += 8) {
+                __m256i texels8 = _mm256_loadu_si256((const __m256i*)(texels + i));
+                __m256i difference = _mm256_or_si256(_mm256_subs_epu8(texels8, targets), _mm256_subs_epu8(targets, texels8));
+                __m256i within = _mm256_cmpeq_epi8(_mm256_subs_epu8(difference, tolerances), _mm256_setzero_si256());
+                __m256i match = _mm256_cmpeq_epi32(_mm256_or_si256(within, alphaBytes), allSet);
+
+                // Weights of texels that don't match drop to zero, leaving them as they are
+                __m128i masked = _mm_and_si128(
+                    _mm_loadu_si128((const __m128i*)(weights + i)),
+                    _mm_packs_epi32(_mm256_castsi256_si128(match), _mm256_extracti128_si256(match, 1)));
+                __m256i weightLow, weightHigh;
+                Avx2::ExpandWeights(masked, weightLow, weightHigh);
+                _mm256_storeu_si256((__m256i*)(texels + i), Avx2::Blend8(texels8, colors8, weightLow, weightHigh));
+            }
+        }
+#endif
+#if defined(JUICEBOX_BRUSH_SSE2)
+        {
+            const __m128i colors4 = _mm_set1_epi32((s32)color);
+            const __m128i targets = _mm_set1_epi32((s32)target);
+            const __m128i tolerances = _mm_set1_epi8((char)tolerance);
+            const __m128i alphaBytes = _mm_set1_epi32((s32)0xFF000000u);
+            const __m128i allSet = _mm_set1_epi32(-1);
+            for (; i + 4 <= count; i += 4) {
+                __m128i texels4 = _mm_loadu_si128((const __m128i*)(texels + i));
+                __m128i difference = _mm_or_si128(_mm_subs_epu8(texels4, targets), _mm_subs_epu8(targets, texels4));
+                __m128i within = _mm_cmpeq_epi8(_mm_subs_epu8(difference, tolerances), _mm_setzero_si128());
+                __m128i match = _mm_cmpeq_epi32(_mm_or_si128(within, alphaBytes), allSet);
+
+                __m128i masked = _mm_and_si128(_mm_loadl_epi64((const __m128i*)(weights + i)), _mm_packs_epi32(match, match));
+                __m128i weightLow, weightHigh;
+                Sse2::ExpandWeights(masked, weightLow, weightHigh);
+                _mm_storeu_si128((__m128i*)(texels + i), Sse2::Blend4(texels4, colors4, weightLow, weightHigh));
+            }
+        }
+#endif
+        Scalar::Replace(texels + i, weights + i, count - i, target, tolerance, color);
+    }
+
+    // The palette is searched for all texels of a group at once; groups
+    // the brush doesn't touch are skipped
+    inline void Snap(u32* texels, const u16* weights, u32 count, const u32* palette, u32 paletteCount) {
+        if (paletteCount == 0)
+            return;
+
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_AVX2)
+        for (; i + 8 <= count; i += 8) {
+            __m128i weights8 = _mm_loadu_si128((const __m128i*)(weights + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(weights8, _mm_setzero_si128())) == 0xFFFF)
+                continue;
+
+            __m256i texels8 = _mm256_loadu_si256((const __m256i*)(texels + i));
+            __m256i best = _mm256_set1_epi32((s32)palette[0]);
+            __m256i bestDistance = Avx2::DistanceSq8(texels8, best);
+            for (u32 p = 1; p < paletteCount; ++p) {
+                __m256i candidate = _mm256_set1_epi32((s32)palette[p]);
+                __m256i distance = Avx2::DistanceSq8(texels8, candidate);
+                __m256i closer = _mm256_cmpgt_epi32(bestDistance, distance);
+                best = _mm256_blendv_epi8(best, candidate, closer);
+                bestDistance = _mm256_min_epi32(bestDistance, distance);
+            }
+
+            __m256i weightLow, weightHigh;
+            Avx2::ExpandWeights(weights8, weightLow, weightHigh);
+            _mm256_storeu_si256((__m256i*)(texels + i), Avx2::Blend8(texels8, best, weightLow, weightHigh));
+        }
+#endif
+#if defined(JUICEBOX_BRUSH_SSE2)
+        for (; i + 4 <= count; i += 4) {
+            __m128i weights4 = _mm_loadl_epi64((const __m128i*)(weights + i));
+            if ((_mm_movemask_epi8(_mm_cmpeq_epi16(weights4, _mm_setzero_si128())) & 0xFF) == 0xFF)
+                continue;
+
+            __m128i texels4 = _mm_loadu_si128((const __m128i*)(texels + i));
+            __m128i best = _mm_set1_epi32((s32)palette[0]);
+            __m128i bestDistance = Sse2::DistanceSq4(texels4, best);
+            for (u32 p = 1; p < paletteCount; ++p) {
+                __m128i candidate = _mm_set1_epi32((s32)palette[p]);
+                __m128i distance = Sse2::DistanceSq4(texels4, candidate);
+                __m128i closer = _mm_cmpgt_epi32(bestDistance, distance);
+                best = _mm_or_si128(_mm_and_si128(closer, candidate), _mm_andnot_si128(closer, best));
+                bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+            }
+
+            __m128i weightLow, weightHigh;
+            Sse2::ExpandWeights(weights4, weightLow, weightHigh);
+            _mm_storeu_si128((__m128i*)(texels + i), Sse2::Blend4(texels4, best, weightLow, weightHigh));
+        }
+#endif
+        Scalar::Snap(texels + i, weights + i, count - i, palette, paletteCount);
+    }
+
+    inline void NearestIndex(const u32* texels, u32 count, const u32* palette, u32 paletteCount, u8* indices) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_AVX2)
+        for (; i + 8 <= count; i += 8) {
+            __m256i texels8 = _mm256_loadu_si256((const __m256i*)(texels + i));
+            __m256i best = _mm256_setzero_si256();
+            __m256i bestDistance = Avx2::DistanceSq8(texels8, _mm256_set1_epi32((s32)palette[0]));
+            for (u32 p = 1; p < paletteCount; ++p) {
+                __m256i distance = Avx2::DistanceSq8(texels8, _mm256_set1_epi32((s32)palette[p]));
+                __m256i closer = _mm256_cmpgt_epi32(bestDistance, distance);
+                best = _mm256_blendv_epi8(best, _mm256_set1_epi32((s32)p), closer);
+                bestDistance = _mm256_min_epi32(bestDistance, distance);
+            }
+            __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+            _mm_storel_epi64((__m128i*)(indices + i), _mm_packus_epi16(packed, packed));
+        }
+#endif
+#if defined(JUICEBOX_BRUSH_SSE2)
+        for (; i + 4 <= count; i += 4) {
+            __m128i texels4 = _mm_loadu_si128((const __m128i*)(texels + i));
+            __m128i best = _mm_setzero_si128();
+            __m128i bestDistance = Sse2::DistanceSq4(texels4, _mm_set1_epi32((s32)palette[0]));
+            for (u32 p = 1; p < paletteCount; ++p) {
+                __m128i distance = Sse2::DistanceSq4(texels4, _mm_set1_epi32((s32)palette[p]));
+                __m128i closer = _mm_cmpgt_epi32(bestDistance, distance);
+                best = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((s32)p)), _mm_andnot_si128(closer, best));
+                bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+            }
+            __m128i packed = _mm_packs_epi32(best, best);
+            s32 bytes = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+            memcpy(indices + i, &bytes, 4);
+        }
+#endif
+        Scalar::NearestIndex(texels + i, count - i, palette, paletteCount, indices + i);
+    }
+
+    inline void PaintIndex(u8* indices, const u16* weights, u32 count, u8 index) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_SSE2)
+        const __m128i threshold = _mm_set1_epi16((s16)(HALF_WEIGHT - 1));
+        const __m128i value = _mm_set1_epi8((char)index);
+        for (; i + 16 <= count; i += 16) {
+            __m128i covered = _mm_packs_epi16(
+                _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(weights + i)), threshold),
+                _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(weights + i + 8)), threshold));
+            __m128i current = _mm_loadu_si128((const __m128i*)(indices + i));
+            _mm_storeu_si128((__m128i*)(indices + i), _mm_or_si128(_mm_and_si128(covered, value), _mm_andnot_si128(covered, current)));
+        }
+#endif
+        Scalar::PaintIndex(indices + i, weights + i, count - i, index);
+    }
+
+    inline void ReplaceIndex(u8* indices, const u16* weights, u32 count, u8 target, u8 index) {
+        u32 i = 0;
+#if defined(JUICEBOX_BRUSH_SSE2)
+        const __m128i threshold = _mm_set1_epi16((s16)(HALF_WEIGHT - 1));
+        const __m128i targets = _mm_set1_epi8((char)target);
+        const __m128i value = _mm_set1_epi8((char)index);
+        for (; i + 16 <= count; i += 16) {
+            __m128i current = _mm_loadu_si128((const __m128i*)(indices + i));
+            __m128i covered = _mm_and_si128(
+                _mm_packs_epi16(
+                    _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(weights + i)), threshold),
+                    _mm_cmpgt_epi16(_mm_loadu_si128((const __m128i*)(weights + i + 8)), threshold)),
+                _mm_cmpeq_epi8(current, targets));
+            _mm_storeu_si128((__m128i*)(indices + i), _mm_or_si128(_mm_and_si128(covered, value), _mm_andnot_si128(covered, current)));
+        }
+#endif
+        Scalar::ReplaceIndex(indices + i, weights + i, count - i, target, index);
+    }
+
+    // Indices to colours. A table lookup per texel; SSE2 has no gather and
+    // AVX2's is no faster than scalar loads for a 1 KB table.
+    inline void ExpandIndices(const u8* indices, u32 count, const u32* clut, u32* out) {
+        for (u32 i = 0; i < count; ++i)
+            out[i] = clut[indices[i]];
+    }
+}
@@ -0,0 +1,127 @@
+#include "PaintHistory.h"
+#include <algorithm>
+#include <cstring>
+
+void PaintHistory::Reset(const TiledCanvas& canvas)
+{
+    _tileBytes = (u64)TiledCanvas::TILE_SIZE * TiledCanvas::TILE_SIZE * canvas.GetTexelSize();
+
+    _undo.clear();
+    _redo.clear();
+    _bytes = 0;
+    _recording = false;
+    _open = Record();
+    _savedIn.assign(canvas.GetTileCount(), 0);
+    _stroke = 0;
+}
+
+void PaintHistory::BeginStroke()
+{
+    if (_recording)
+        EndStroke();
+
+    // Stroke 0 marks tiles never saved
+    if (++_stroke == 0) {
+        std::fill(_savedIn.begin(), _savedIn.end(), 0);
+        _stroke = 1;
+    }
+    _recording = true;
+    _open = Record();
+}
+
+void PaintHistory::Touch(const rect<s32>& area, const TiledCanvas& canvas)
+{
+    if (!_recording || area.getWidth() <= 0 || area.getHeight() <= 0)
+        return;
+
+    u32 firstX, firstY, lastX, lastY;
+    canvas.TileRange(area, firstX, firstY, lastX, lastY);
+    for (u32 ty = firstY; ty <= lastY; ++ty) {
+        for (u32 tx = firstX; tx <= lastX; ++tx) {
+            const u32 index = ty * canvas.GetTilesX() + tx;
+            if (_savedIn[index] == _stroke)
+                continue;
+            _savedIn[index] = _stroke;
+
+            Tile tile;
+            tile.index = index;
+            tile.texels.reset(new u8[_tileBytes]);
+            memcpy(tile.texels.get(), canvas.GetTile(index), _tileBytes);
+
+            const rect<s32> bounds = canvas.TileRect(index);
+            if (_open.tiles.empty()) {
+                _open.bounds = bounds;
+            } else {
+                _open.bounds.addInternalPoint(bounds.UpperLeftCorner);
+                _open.bounds.addInternalPoint(bounds.LowerRightCorner);
+            }
+            _open.tiles.push_back(std::move(tile));
+            _open.bytes += _tileBytes;
+        }
+    }
+}
+
+void PaintHistory::EndStroke()
+{
+    if (!_recording)
+        return;
+    _recording = false;
+    if (_open.tiles.empty())
+        return;
+
+    // A new stroke ends the redo branch
+    _clearRedo();
+    _bytes += _open.bytes;
+    _undo.push_back(std::move(_open));
+    _open = Record();
+
+    while (_bytes > MAX_BYTES && _undo.size() > 1) {
+        _bytes -= _undo.front().bytes;
+        _undo.pop_front();
+    }
+}
+
+bool PaintHistory::Undo(TiledCanvas& canvas, rect<s32>& changed)
+{
+    if (_recording)
+        EndStroke();
+    if (_undo.empty())
+        return false;
+
+    Record record = std::move(_undo.back());
+    _undo.pop_back();
+    _swap(record, canvas);
+    changed = record.bounds;
+    _redo.push_back(std::move(record));
+    return true;
+}
+
+bool PaintHistory::Redo(TiledCanvas& canvas, rect<s32>& changed)
+{
+    if (_recording)
+        EndStroke();
+    if (_redo.empty())
+        return false;
+
+    Record record = std::move(_redo.back());
+    _redo.pop_back();
+    _swap(record, canvas);
+    changed = record.bounds;
+    _undo.push_back(std::move(record));
+    return true;
+}
+
+void PaintHistory::_swap(Record& record, TiledCanvas& canvas)
+{
+    // Saved tiles were resident when saved, and canvas tiles are never freed
+    // without resetting the history too
+    for (Tile& tile : record.tiles)
+        canvas.Swap(tile.index, tile.texels);
+}
+
+void PaintHistory::_clearRedo()
+{
+    for (const Record& record : _redo)
+        _bytes -= record.bytes;
+    _redo.clear();
+}
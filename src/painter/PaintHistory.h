@@ -0,0 +1,72 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "painter/TiledCanvas.h"
+
+using namespace irr;
+using namespace core;
+
+// Undo/redo for the painter, kept per TiledCanvas tile. During a stroke,
+// the first write to a tile copies it aside, so a record only holds the
+// tiles the stroke touched and memory follows the painted area, not the
+// texture size.
+//
+// Undo exchanges each saved tile with the canvas's by pointer. The record
+// then holds what was painted, which is exactly what redo needs, so neither
+// direction copies texels. The price is the canvas's 64x64 granularity: a
+// dab that grazes a tile saves all of it, so MAX_BYTES covers fewer strokes
+// than smaller tiles would.
+class PaintHistory {
+public:
+    // Oldest strokes are forgotten past this
+    static constexpr u64 MAX_BYTES = 64ull * 1024 * 1024;
+
+    // New canvas; forgets everything. Call after resetting `canvas`.
+    void Reset(const TiledCanvas& canvas);
+
+    void BeginStroke();
+    // Saves the tiles under `area` not yet saved by this stroke. Call before
+    // writing to them, once the canvas tiles under `area` are resident.
+    void Touch(const rect<s32>& area, const TiledCanvas& canvas);
+    void EndStroke();
+    bool IsRecording() const { return _recording; }
+
+    // Swap the tiles of the last (next) stroke with the canvas. `changed`
+    // receives the texels that need uploading.
+    bool Undo(TiledCanvas& canvas, rect<s32>& changed);
+    bool Redo(TiledCanvas& canvas, rect<s32>& changed);
+
+    bool CanUndo() const { return !_undo.empty(); }
+    bool CanRedo() const { return !_redo.empty(); }
+    u64 GetBytes() const { return _bytes; }
+
+private:
+    struct Tile {
+        u32 index; // TiledCanvas tile number
+        std::unique_ptr<u8[]> texels;
+    };
+
+    struct Record {
+        std::vector<Tile> tiles;
+        rect<s32> bounds;
+        u64 bytes = 0;
+    };
+
+    u64 _tileBytes = 0;
+
+    std::deque<Record> _undo;
+    std::vector<Record> _redo;
+    u64 _bytes = 0;
+
+    bool _recording = false;
+    Record _open;
+    std::vector<u32> _savedIn; // Per tile: stroke that saved it
+    u32 _stroke = 0;
+
+    void _swap(Record& record, TiledCanvas& canvas);
+    void _clearRedo();
+};
@@ -0,0 +1,588 @@
+#include "Painter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+
+#include "helpers/Profiler.h"
+#include "painter/BrushKernels.h"
+#include "painter/PaletteQuantize.h"
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+
+Painter::Painter(Application& application)
+    : _application(application),
+      _texture(nullptr),
+      _glName(0),
+      _mirrorStale(false),
+      _width(0),
+      _height(0),
+      _base(nullptr),
+      _basePitch(0),
+      _stroking(false),
+      _strokeTravelled(0.0f)
+{
+}
+
+Painter::~Painter()
+{
+    Detach();
+}
+
+bool Painter::Attach(ITexture* texture)
+{
+    Detach();
+    if (!texture)
+        return false;
+
+    if (texture->getColorFormat() != ECF_A8R8G8B8) {
+        std::cout << "Painting needs an A8R8G8B8 texture" << std::endl;
+        return false;
+    }
+
+    // Nothing is copied yet; tiles come over from the texture as brushes reach them
+    const dimension2d<u32>& size = texture->getSize();
+    if (!texture->lock(ETLM_READ_WRITE))
+        return false;
+
+    _width = size.Width;
+    _height = size.Height;
+
+    // A read-write unlock makes the OpenGL driver upload the texture, which
+    // leaves it bound. That is the only public way to learn its GL name, so
+    // take it from the binding and check the size before trusting it.
+    texture->unlock();
+    _glName = 0;
+    if (_application.driver->getDriverType() == EDT_OPENGL) {
+        GLint name = 0, width = 0, height = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &name);
+        if (name) {
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        }
+        if (name && (u32)width == _width && (u32)height == _height)
+            _glName = (u32)name;
+        else
+            std::cout << "Painter: no direct texture access, uploading through lock()" << std::endl;
+    }
+
+    _texture = texture;
+    _texture->grab();
+    _mirrorStale = false;
+    _canvas.Reset(_width, _height, 4);
+    _tileDirty.assign(_canvas.GetTileCount(), rect<s32>(0, 0, 0, 0));
+    _dirtyTiles.clear();
+    _history.Reset(_canvas);
+    return true;
+}
+
+void Painter::Detach()
+{
+    if (!_texture)
+        return;
+
+    EndStroke();
+    Flush();
+    WriteBack();
+    _texture->drop();
+    _texture = nullptr;
+    _glName = 0;
+    _canvas.Reset(0, 0, 4);
+    _history.Reset(_canvas);
+    _tileDirty.clear();
+    _tileDirty.shrink_to_fit();
+    _clut.clear();
+    _staging.clear();
+    _staging.shrink_to_fit();
+    _width = _height = 0;
+}
+
+void Painter::Stamp(const vector2df& uv, const Brush& brush)
+{
+    if (_stroking)
+        EndStroke();
+
+    _history.BeginStroke();
+    rect<s32> area = _stamp(uv, brush);
+    _unlockBase();
+    _history.EndStroke();
+    if (area.getArea() > 0)
+        _markDirty(area);
+}
+
+void Painter::BeginStroke(const Brush& brush)
+{
+    if (_stroking)
+        EndStroke();
+
+    _stroking = _texture != nullptr;
+    _strokeBrush = brush;
+    _strokeTravelled = 0.0f;
+    if (_stroking)
+        _history.BeginStroke();
+}
+
+void Painter::EndStroke()
+{
+    if (!_stroking)
+        return;
+
+    // Stamps still queued belong to this stroke's undo step
+    if (!_queued.empty())
+        _applyQueued();
+    _history.EndStroke();
+    _stroking = false;
+}
+
+bool Painter::Undo()
+{
+    EndStroke();
+    rect<s32> changed;
+    if (!_texture || !_history.Undo(_canvas, changed))
+        return false;
+    _markDirty(changed);
+    return true;
+}
+
+bool Painter::Redo()
+{
+    EndStroke();
+    rect<s32> changed;
+    if (!_texture || !_history.Redo(_canvas, changed))
+        return false;
+    _markDirty(changed);
+    return true;
+}
+
+void Painter::StrokeTo(const vector2df& uv, bool connect)
+{
+    if (!_stroking)
+        return;
+
+    const vector2df texel(uv.X * _width, uv.Y * _height);
+    if (!connect) {
+        _queueStamp(uv);
+        _strokeLast = texel;
+        _strokeTravelled = 0.0f;
+        return;
+    }
+
+    const vector2df delta = texel - _strokeLast;
+    const f32 length = delta.getLength();
+    if (length <= 0.0f)
+        return;
+    const f32 radius = core::clamp(_strokeBrush.radius, MIN_BRUSH_RADIUS, MAX_BRUSH_RADIUS);
+    const f32 spacing = std::max(radius * _strokeBrush.spacing, 0.5f);
+
+    // Carry the distance since the last stamp so spacing holds across samples
+    f32 along = spacing - std::min(_strokeTravelled, spacing);
+    for (; along <= length; along += spacing) {
+        const vector2df point = _strokeLast + delta * (along / length);
+        _queueStamp(vector2df(point.X / _width, point.Y / _height));
+    }
+    _strokeTravelled = length - (along - spacing);
+    _strokeLast = texel;
+}
+
+void Painter::_queueStamp(const vector2df& uv)
+{
+    // Fast strokes apply their stamps in several batches rather than skip any
+    if (_queued.size() >= MAX_QUEUED_STAMPS)
+        _applyQueued();
+    _queued.push_back(uv);
+}
+
+rect<s32> Painter::_stamp(const vector2df& uv, const Brush& brush)
+{
+    if (!_texture)
+        return rect<s32>(0, 0, 0, 0);
+
+    const f32 radius = core::clamp(brush.radius, MIN_BRUSH_RADIUS, MAX_BRUSH_RADIUS);
+    // Tiling UVs wrap like the texture does. Stamps near an edge are clipped
+    // rather than continued on the other side.
+    const f32 centerX = (uv.X - std::floor(uv.X)) * _width - 0.5f;
+    const f32 centerY = (uv.Y - std::floor(uv.Y)) * _height - 0.5f;
+
+    rect<s32> area(
+        std::max((s32)std::floor(centerX - radius), 0),
+        std::max((s32)std::floor(centerY - radius), 0),
+        std::min((s32)std::ceil(centerX + radius) + 1, (s32)_width),
+        std::min((s32)std::ceil(centerY + radius) + 1, (s32)_height));
+    if (area.getWidth() <= 0 || area.getHeight() <= 0)
+        return rect<s32>(0, 0, 0, 0);
+
+    const f32 hardness = core::clamp(brush.hardness, 0.0f, 1.0f);
+    const f32 strength = core::clamp(brush.opacity, 0.0f, 1.0f) * brush.color.getAlpha() / 255.0f * 256.0f;
+    const u32 color = brush.color.color | 0xFF000000u; // Paint keeps the texel opaque
+    // Indexed texels are always on the palette, there is nothing to snap
+    if (brush.mode == BrushMode::SNAP && (_palette.empty() || IsIndexed()))
+        return rect<s32>(0, 0, 0, 0);
+
+    _makeResident(area);
+    _history.Touch(area, _canvas); // Before the first write
+
+    const s32 x0 = area.UpperLeftCorner.X;
+    const s32 x1 = area.LowerRightCorner.X;
+    const u32 count = (u32)area.getWidth();
+    _weights.resize(count);
+    const u8 index = IsIndexed() ? (u8)_nearestIndex(brush.color) : 0;
+    const u8 targetIndex = IsIndexed() ? (u8)_nearestIndex(brush.target) : 0;
+
+    for (s32 y = area.UpperLeftCorner.Y; y < area.LowerRightCorner.Y; ++y) {
+        const f32 dy = y - centerY;
+        if (hardness >= 1.0f)
+            BrushKernels::HardRound(x0, centerX, dy, count, radius, strength, _weights.data());
+        else
+            BrushKernels::SoftRound(x0, centerX, dy, count, radius, radius * hardness, strength, _weights.data());
+
+        // The row is contiguous only within a tile
+        for (s32 x = x0; x < x1;) {
+            const s32 end = std::min(x1, (x / (s32)TiledCanvas::TILE_SIZE + 1) * (s32)TiledCanvas::TILE_SIZE);
+            const u32 span = (u32)(end - x);
+            const u16* weights = &_weights[x - x0];
+
+            if (IsIndexed()) {
+                u8* indices = _canvas.Texel(x, y);
+                if (brush.mode == BrushMode::REPLACE)
+                    BrushKernels::ReplaceIndex(indices, weights, span, targetIndex, index);
+                else
+                    BrushKernels::PaintIndex(indices, weights, span, index);
+            } else {
+                u32* row = (u32*)_canvas.Texel(x, y);
+                switch (brush.mode) {
+                    case BrushMode::REPLACE:
+                        BrushKernels::Replace(row, weights, span, brush.target.color, brush.tolerance, color);
+                        break;
+                    case BrushMode::SNAP:
+                        BrushKernels::Snap(row, weights, span, _palette.data(), (u32)_palette.size());
+                        break;
+                    default:
+                        BrushKernels::Blend(row, weights, span, color);
+                        break;
+                }
+            }
+            x = end;
+        }
+    }
+
+    return area;
+}
+
+void Painter::_applyQueued()
+{
+    // One dirty region for the whole batch
+    rect<s32> batch(0, 0, 0, 0);
+    for (const vector2df& uv : _queued) {
+        rect<s32> area = _stamp(uv, _strokeBrush);
+        if (area.getArea() <= 0)
+            continue;
+        if (batch.getArea() <= 0) {
+            batch = area;
+        } else {
+            batch.addInternalPoint(area.UpperLeftCorner);
+            batch.addInternalPoint(area.LowerRightCorner);
+        }
+    }
+    _queued.clear();
+    _unlockBase();
+
+    if (batch.getArea() > 0)
+        _markDirty(batch);
+}
+
+SColor Painter::Sample(const vector2df& uv) const
+{
+    if (!_texture)
+        return SColor(0);
+
+    u32 x = std::min((u32)((uv.X - std::floor(uv.X)) * _width), _width - 1);
+    u32 y = std::min((u32)((uv.Y - std::floor(uv.Y)) * _height), _height - 1);
+    if (IsIndexed())
+        return SColor(_clut[*_canvas.Texel(x, y)]);
+    if (_canvas.IsResident(_canvas.TileAt(x, y)))
+        return SColor(*(const u32*)_canvas.Texel(x, y));
+
+    // Never painted, so the texture still has it
+    const u8* texels = (const u8*)_texture->lock(ETLM_READ_ONLY);
+    if (!texels)
+        return SColor(0);
+    SColor color(*(const u32*)(texels + (size_t)y * _texture->getPitch() + x * 4));
+    _texture->unlock();
+    return color;
+}
+
+u32 Painter::SampleIndex(const vector2df& uv) const
+{
+    if (!_texture || !IsIndexed())
+        return 0;
+
+    u32 x = std::min((u32)((uv.X - std::floor(uv.X)) * _width), _width - 1);
+    u32 y = std::min((u32)((uv.Y - std::floor(uv.Y)) * _height), _height - 1);
+    return *_canvas.Texel(x, y);
+}
+
+bool Painter::ConvertToIndexed(u32 colors)
+{
+    if (!_texture || (colors != CLUT_4BIT && colors != CLUT_8BIT))
+        return false;
+
+    EndStroke();
+    if (IsIndexed())
+        ConvertToDirect();
+
+    Profiler::Scope scope("Paint quantize");
+    const u32 count = _width * _height;
+
+    // The palette needs every texel: the texture's, with the painted tiles over them
+    std::vector<u32> pixels(count);
+    if (const u8* base = _lockBase()) {
+        for (u32 y = 0; y < _height; ++y)
+            memcpy(&pixels[(size_t)y * _width], base + (size_t)y * _basePitch, _width * 4);
+    }
+    _unlockBase();
+    for (u32 tile : _canvas.GetResident()) {
+        const rect<s32> bounds = _canvas.TileRect(tile);
+        for (s32 y = bounds.UpperLeftCorner.Y; y < bounds.LowerRightCorner.Y; ++y)
+            memcpy(&pixels[(size_t)y * _width + bounds.UpperLeftCorner.X], _canvas.Texel(bounds.UpperLeftCorner.X, y), bounds.getWidth() * 4);
+    }
+
+    _clut = PaletteQuantize::BuildPalette(pixels.data(), count, colors);
+    _clut.resize(colors, 0xFF000000u); // Unused entries are black, like an unfilled PS1 CLUT
+    std::vector<u8> indices(count);
+    PaletteQuantize::Map(pixels.data(), count, _clut, indices.data());
+    pixels.clear();
+    pixels.shrink_to_fit();
+
+    // Every texel has an index now, so every tile is resident
+    _canvas.Reset(_width, _height, 1);
+    for (u32 tile = 0; tile < _canvas.GetTileCount(); ++tile) {
+        _canvas.Allocate(tile);
+        const rect<s32> bounds = _canvas.TileRect(tile);
+        for (s32 y = bounds.UpperLeftCorner.Y; y < bounds.LowerRightCorner.Y; ++y)
+            memcpy(_canvas.Texel(bounds.UpperLeftCorner.X, y), &indices[(size_t)y * _width + bounds.UpperLeftCorner.X], bounds.getWidth());
+    }
+
+    _history.Reset(_canvas);
+    _markDirty(rect<s32>(0, 0, _width, _height));
+    return true;
+}
+
+void Painter::ConvertToDirect()
+{
+    if (!IsIndexed())
+        return;
+
+    // Every tile stays resident: the texture now shows the quantized colours,
+    // not the texels a tile would be read back from
+    EndStroke();
+    TiledCanvas direct;
+    direct.Reset(_width, _height, 4);
+    for (u32 tile = 0; tile < _canvas.GetTileCount(); ++tile) {
+        BrushKernels::ExpandIndices(_canvas.GetTile(tile), TiledCanvas::TILE_SIZE * TiledCanvas::TILE_SIZE, _clut.data(),
+                                    (u32*)direct.Allocate(tile));
+    }
+    _canvas = std::move(direct);
+    _clut.clear();
+    _history.Reset(_canvas);
+}
+
+void Painter::SetClutColor(u32 index, SColor color)
+{
+    if (!IsIndexed() || index >= _clut.size())
+        return;
+
+    // Only the display copy changes; every index stays as it is
+    _clut[index] = color.color | 0xFF000000u;
+    _markDirty(rect<s32>(0, 0, _width, _height));
+}
+
+u64 Painter::GetCanvasBytes() const
+{
+    return _canvas.GetBytes() + _clut.size() * sizeof(u32);
+}
+
+void Painter::Flush()
+{
+    if (!_queued.empty()) {
+        Profiler::Scope scope("Paint stamps");
+        _applyQueued();
+    }
+    if (_dirtyTiles.empty())
+        return;
+
+    Profiler::Scope scope("Paint upload");
+    if (_glName) {
+        _uploadGl();
+        _mirrorStale = true;
+    } else {
+        _uploadLocked();
+    }
+    for (u32 tile : _dirtyTiles)
+        _tileDirty[tile] = rect<s32>(0, 0, 0, 0);
+    _dirtyTiles.clear();
+}
+
+void Painter::WriteBack()
+{
+    if (!_texture || !_mirrorStale)
+        return;
+
+    // One full upload, only when something is about to read the texture.
+    // Tiles never painted already match it.
+    u8* texels = (u8*)_texture->lock(ETLM_READ_WRITE);
+    if (!texels)
+        return;
+    const u32 pitch = _texture->getPitch();
+    for (u32 tile : _canvas.GetResident()) {
+        const rect<s32> bounds = _canvas.TileRect(tile);
+        for (s32 y = bounds.UpperLeftCorner.Y; y < bounds.LowerRightCorner.Y; ++y)
+            _expandRow(bounds.UpperLeftCorner.X, y, bounds.getWidth(), (u32*)(texels + (size_t)y * pitch) + bounds.UpperLeftCorner.X);
+    }
+    _texture->unlock();
+    _mirrorStale = false;
+}
+
+void Painter::_markDirty(const rect<s32>& area)
+{
+    if (area.getWidth() <= 0 || area.getHeight() <= 0)
+        return;
+
+    u32 firstX, firstY, lastX, lastY;
+    _canvas.TileRange(area, firstX, firstY, lastX, lastY);
+    for (u32 ty = firstY; ty <= lastY; ++ty) {
+        for (u32 tx = firstX; tx <= lastX; ++tx) {
+            // A tile never painted still matches what the GPU has
+            const u32 tile = ty * _canvas.GetTilesX() + tx;
+            if (!_canvas.IsResident(tile))
+                continue;
+
+            rect<s32> part = _canvas.TileRect(tile);
+            part.clipAgainst(area);
+            rect<s32>& dirty = _tileDirty[tile];
+            if (dirty.getArea() <= 0) {
+                dirty = part;
+                _dirtyTiles.push_back(tile);
+            } else {
+                dirty.addInternalPoint(part.UpperLeftCorner);
+                dirty.addInternalPoint(part.LowerRightCorner);
+            }
+        }
+    }
+}
+
+void Painter::_makeResident(const rect<s32>& area)
+{
+    u32 firstX, firstY, lastX, lastY;
+    _canvas.TileRange(area, firstX, firstY, lastX, lastY);
+    for (u32 ty = firstY; ty <= lastY; ++ty) {
+        for (u32 tx = firstX; tx <= lastX; ++tx) {
+            const u32 tile = ty * _canvas.GetTilesX() + tx;
+            if (_canvas.IsResident(tile))
+                continue;
+
+            // Indexed canvases are always resident, so this is ARGB. Should
+            // the texture refuse the lock, the tile starts out black.
+            u8* texels = _canvas.Allocate(tile);
+            const u8* base = _lockBase();
+            if (!base)
+                continue;
+            const rect<s32> bounds = _canvas.TileRect(tile);
+            for (s32 y = bounds.UpperLeftCorner.Y; y < bounds.LowerRightCorner.Y; ++y) {
+                memcpy(texels + (size_t)(y - bounds.UpperLeftCorner.Y) * TiledCanvas::TILE_SIZE * 4,
+                       base + (size_t)y * _basePitch + bounds.UpperLeftCorner.X * 4, bounds.getWidth() * 4);
+            }
+        }
+    }
+}
+
+const u8* Painter::_lockBase()
+{
+    // Held until the stamp or batch is done, so a stroke locks once per frame
+    if (!_base && _texture) {
+        _base = (const u8*)_texture->lock(ETLM_READ_ONLY);
+        _basePitch = _texture->getPitch();
+    }
+    return _base;
+}
+
+void Painter::_unlockBase()
+{
+    if (!_base)
+        return;
+    _texture->unlock();
+    _base = nullptr;
+}
+
+void Painter::_uploadGl()
+{
+    // Direct uploads read straight out of the tile, the row length doing the
+    // striding; indexed ones are expanded into a staging rectangle first
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glBindTexture(GL_TEXTURE_2D, _glName);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    for (u32 tile : _dirtyTiles) {
+        const rect<s32>& r = _tileDirty[tile];
+        const rect<s32> bounds = _canvas.TileRect(tile);
+        const void* source = _canvas.GetTile(tile);
+        if (IsIndexed()) {
+            _staging.resize((size_t)r.getWidth() * r.getHeight());
+            for (s32 y = 0; y < r.getHeight(); ++y)
+                _expandRow(r.UpperLeftCorner.X, r.UpperLeftCorner.Y + y, r.getWidth(), &_staging[(size_t)y * r.getWidth()]);
+            source = _staging.data();
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, r.getWidth());
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+        } else {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)TiledCanvas::TILE_SIZE);
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, r.UpperLeftCorner.X - bounds.UpperLeftCorner.X);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, r.UpperLeftCorner.Y - bounds.UpperLeftCorner.Y);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, r.UpperLeftCorner.X, r.UpperLeftCorner.Y, r.getWidth(), r.getHeight(),
+                        GL_BGRA, GL_UNSIGNED_BYTE, source);
+    }
+
+    glPopClientAttrib();
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+}
+
+void Painter::_uploadLocked()
+{
+    u8* texels = (u8*)_texture->lock(ETLM_WRITE_ONLY);
+    if (!texels)
+        return;
+
+    const u32 pitch = _texture->getPitch();
+    for (u32 tile : _dirtyTiles) {
+        const rect<s32>& r = _tileDirty[tile];
+        for (s32 y = r.UpperLeftCorner.Y; y < r.LowerRightCorner.Y; ++y)
+            _expandRow(r.UpperLeftCorner.X, y, r.getWidth(), (u32*)(texels + (size_t)y * pitch) + r.UpperLeftCorner.X);
+    }
+    _texture->unlock();
+}
+
+void Painter::_expandRow(s32 x, s32 y, u32 count, u32* out) const
+{
+    const u8* texels = _canvas.Texel((u32)x, (u32)y);
+    if (IsIndexed())
+        BrushKernels::ExpandIndices(texels, count, _clut.data(), out);
+    else
+        memcpy(out, texels, count * 4);
+}
+
+u32 Painter::_nearestIndex(SColor color) const
+{
+    u8 index = 0;
+    u32 texel = color.color;
+    BrushKernels::Scalar::NearestIndex(&texel, 1, _clut.data(), (u32)_clut.size(), &index);
+    return index;
+}
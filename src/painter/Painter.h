@@ -0,0 +1,160 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <vector>
+
+#include "Application.h"
+#include "painter/PaintHistory.h"
+#include "painter/TiledCanvas.h"
+
+using namespace irr;
+using namespace core;
+using namespace video;
+
+// Texture painting. The painter keeps its own A8R8G8B8 copy of the parts of
+// the model texture it painted, stamps brushes into it in texel space and,
+// once per frame, sends only the changed part of each changed tile to the
+// GPU. The copy is a TiledCanvas: a tile is read from the texture the first
+// time a brush reaches it, so memory and uploads follow the painted area and
+// large reference textures cost little more than small ones.
+//
+// Irrlicht 1.8 can only re-upload a whole texture (lock/unlock), so with the
+// OpenGL driver the dirty rectangles go straight to the texture's GL name
+// with glTexSubImage2D. That leaves Irrlicht's own CPU mirror of the texture
+// behind; WriteBack() brings it up to date before anything reads the texture
+// through lock() (saving a project). Software drivers draw from the locked
+// memory itself, so there the rectangles are copied into it instead.
+//
+// In indexed mode the canvas is one palette index per texel plus a CLUT of
+// 16 or 256 colours (PS1 4-bit and 8-bit textures), a quarter of the
+// memory, undo history included. Every tile is resident in indexed mode,
+// since quantizing assigns every texel an index. The GPU texture stays ARGB, since
+// Irrlicht's materials can't sample indices; dirty rectangles are expanded
+// through the CLUT on their way up. Editing a CLUT entry recolours every
+// texel using it without touching the indices.
+class Painter {
+public:
+    enum class BrushMode {
+        BLEND,   // Alpha blend the colour
+        REPLACE, // Only recolour texels close to `target`
+        SNAP,    // Pull texels to the nearest palette colour
+        COUNT
+    };
+
+    struct Brush {
+        f32 radius = 4.0f;   // Texels
+        f32 hardness = 0.5f; // Fraction of the radius painted at full strength
+        f32 opacity = 1.0f;
+        SColor color = SColor(255, 255, 255, 255);
+        BrushMode mode = BrushMode::BLEND;
+        SColor target = SColor(255, 255, 255, 255); // REPLACE only
+        u32 tolerance = 24;                         // REPLACE: per channel, 0..255
+        f32 spacing = 0.25f; // Distance between stroke stamps, as a fraction of the radius
+    };
+
+    static constexpr u32 CLUT_4BIT = 16;
+    static constexpr u32 CLUT_8BIT = 256;
+
+    static constexpr f32 MIN_BRUSH_RADIUS = 0.5f;
+    static constexpr f32 MAX_BRUSH_RADIUS = 128.0f;
+    // A full queue is applied at once, so one batch never grows past this
+    static constexpr u32 MAX_QUEUED_STAMPS = 256;
+
+    Painter(Application& application);
+    ~Painter();
+
+    Painter(const Painter&) = delete;
+    Painter& operator=(const Painter&) = delete;
+
+    // Copies the texels of `texture` (A8R8G8B8 only). Pending strokes on a
+    // previous texture are written back first.
+    bool Attach(ITexture* texture);
+    void Detach();
+    ITexture* GetTexture() const { return _texture; }
+
+    // Paints one brush stamp centred on `uv` (V down like Irrlicht, repeats)
+    void Stamp(const vector2df& uv, const Brush& brush);
+
+    // Strokes: stamps are laid along the path at the brush spacing, in
+    // texel space, and queued until Flush applies the frame's stamps as one
+    // batch (or the queue fills). `connect` false starts a new segment at `uv` (the pointer left
+    // the mesh or crossed a UV seam).
+    void BeginStroke(const Brush& brush);
+    void StrokeTo(const vector2df& uv, bool connect);
+    void EndStroke();
+    bool IsStroking() const { return _stroking; }
+
+    // Each stroke (or lone Stamp) is one step. Forgotten on Attach.
+    bool Undo();
+    bool Redo();
+    const PaintHistory& GetHistory() const { return _history; }
+
+    // Colour of the texel under `uv` (e.g. to pick a REPLACE target)
+    SColor Sample(const vector2df& uv) const;
+
+    // Quantizes the canvas to `colors` (CLUT_4BIT or CLUT_8BIT) entries.
+    // Undo history is forgotten either way.
+    bool ConvertToIndexed(u32 colors);
+    void ConvertToDirect();
+    bool IsIndexed() const { return !_clut.empty(); }
+    const std::vector<u32>& GetClut() const { return _clut; }
+    u32 SampleIndex(const vector2df& uv) const; // Indexed mode only
+    void SetClutColor(u32 index, SColor color);
+    u64 GetCanvasBytes() const;
+    const TiledCanvas& GetCanvas() const { return _canvas; }
+
+    // Colours SNAP brushes pull towards
+    void SetPalette(const std::vector<u32>& palette) { _palette = palette; }
+
+    // Main thread, once per frame: applies queued stroke stamps, then uploads
+    // the dirty part of each dirty tile
+    void Flush();
+
+    // Makes the ITexture's own storage match the painted texels
+    void WriteBack();
+
+    Brush& GetBrush() { return _brush; }
+    u32 GetWidth() const { return _width; }
+    u32 GetHeight() const { return _height; }
+
+private:
+    Application& _application;
+    ITexture* _texture;
+    u32 _glName;      // 0 when the texture isn't an OpenGL one we can update directly
+    bool _mirrorStale; // Irrlicht's CPU copy is behind (OpenGL path only)
+
+    TiledCanvas _canvas;       // ARGB texels, or palette indices in indexed mode
+    std::vector<u32> _clut;    // Indexed mode
+    std::vector<u32> _staging; // Expanded rectangles on their way to the GPU
+    u32 _width;
+    u32 _height;
+    const u8* _base;           // The texture's texels while locked for reading
+    u32 _basePitch;
+
+    std::vector<u32> _dirtyTiles;
+    std::vector<rect<s32>> _tileDirty; // Per tile, in canvas texels; empty when clean
+    Brush _brush;
+    std::vector<u32> _palette;
+    std::vector<u16> _weights; // One row of brush coverage
+
+    // Current stroke
+    bool _stroking;
+    Brush _strokeBrush;
+    vector2df _strokeLast;  // Texels, unwrapped
+    f32 _strokeTravelled;   // Texels since the last stamp
+    std::vector<vector2df> _queued; // UVs stamped by the next Flush
+
+    PaintHistory _history;
+
+    rect<s32> _stamp(const vector2df& uv, const Brush& brush); // Returns the texels touched
+    void _queueStamp(const vector2df& uv);
+    void _applyQueued();
+    void _markDirty(const rect<s32>& area);
+    void _makeResident(const rect<s32>& area); // Copies tiles in from the texture on first touch
+    const u8* _lockBase();
+    void _unlockBase();
+    void _expandRow(s32 x, s32 y, u32 count, u32* out) const; // Within one tile
+    u32 _nearestIndex(SColor color) const;
+    void _uploadGl();
+    void _uploadLocked();
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <algorithm>
+#include <vector>
+
+#include "helpers/Parallel.h"
+#include "painter/BrushKernels.h"
+
+using namespace irr;
+
+// Turns a direct-colour texture into palette indices plus a colour lookup
+// table (CLUT), like a PS1 4-bit (16 colour) or 8-bit (256 colour) texture.
+//
+// The palette comes from a median cut over the texture's 15-bit colours
+// (5 bits per channel, the PS1's own colour depth); the texels are then
+// mapped to their nearest entry at full precision with the vectorized
+// BrushKernels::NearestIndex, split across threads.
+namespace PaletteQuantize {
+    inline constexpr u32 CHANNEL_BITS = 5;
+    inline constexpr u32 HISTOGRAM_SIZE = 1u << (CHANNEL_BITS * 3);
+
+    inline u32 Channel(u32 bin, u32 channel) { return (bin >> (channel * CHANNEL_BITS)) & 31u; }
+
+    inline u32 ToBin(u32 argb) {
+        return ((argb >> 3) & 31u) | (((argb >> 11) & 31u) << 5) | (((argb >> 19) & 31u) << 10);
+    }
+
+    // Up to `colors` opaque colours; fewer when the texture has fewer
+    inline std::vector<u32> BuildPalette(const u32* texels, size_t count, u32 colors) {
+        std::vector<u32> histogram(HISTOGRAM_SIZE, 0);
+        for (size_t i = 0; i < count; ++i)
+            histogram[ToBin(texels[i])]++;
+
+        std::vector<u32> bins;
+        for (u32 bin = 0; bin < HISTOGRAM_SIZE; ++bin) {
+            if (histogram[bin])
+                bins.push_back(bin);
+        }
+        if (bins.empty() || colors == 0)
+            return std::vector<u32>();
+
+        struct Box {
+            u32 begin, end; // Range of `bins`
+            u64 population;
+            u32 longestChannel;
+            u32 longestSide;
+        };
+        auto measure = [&](u32 begin, u32 end) {
+            Box box = { begin, end, 0, 0, 0 };
+            u32 low[3] = { 31, 31, 31 }, high[3] = { 0, 0, 0 };
+            for (u32 i = begin; i < end; ++i) {
+                box.population += histogram[bins[i]];
+                for (u32 c = 0; c < 3; ++c) {
+                    low[c] = std::min(low[c], Channel(bins[i], c));
+                    high[c] = std::max(high[c], Channel(bins[i], c));
+                }
+            }
+            for (u32 c = 0; c < 3; ++c) {
+                if (high[c] - low[c] > box.longestSide) {
+                    box.longestSide = high[c] - low[c];
+                    box.longestChannel = c;
+                }
+            }
+            return box;
+        };
+
+        std::vector<Box> boxes = { measure(0, (u32)bins.size()) };
+        while (boxes.size() < colors) {
+            // Split the box that is both busy and wide, at its population median
+            size_t pick = boxes.size();
+            u64 bestScore = 0;
+            for (size_t b = 0; b < boxes.size(); ++b) {
+                u64 score = boxes[b].population * boxes[b].longestSide;
+                if (boxes[b].end - boxes[b].begin > 1 && score > bestScore) {
+                    bestScore = score;
+                    pick = b;
+                }
+            }
+            if (pick == boxes.size())
+                break;
+
+            const Box box = boxes[pick];
+            const u32 channel = box.longestChannel;
+            std::sort(bins.begin() + box.begin, bins.begin() + box.end, [&](u32 a, u32 b) {
+                u32 ca = Channel(a, channel), cb = Channel(b, channel);
+                return ca != cb ? ca < cb : a < b;
+            });
+
+            u64 running = 0;
+            u32 split = box.begin + 1;
+            for (u32 i = box.begin; i < box.end - 1; ++i) {
+                running += histogram[bins[i]];
+                split = i + 1;
+                if (running * 2 >= box.population)
+                    break;
+            }
+
+            boxes[pick] = measure(box.begin, split);
+            boxes.push_back(measure(split, box.end));
+        }
+
+        // Population-weighted mean of each box, widened back to 8 bits
+        std::vector<u32> palette;
+        for (const Box& box : boxes) {
+            u64 sum[3] = { 0, 0, 0 };
+            for (u32 i = box.begin; i < box.end; ++i) {
+                for (u32 c = 0; c < 3; ++c)
+                    sum[c] += (u64)Channel(bins[i], c) * histogram[bins[i]];
+            }
+            u32 color = 0xFF000000u;
+            for (u32 c = 0; c < 3; ++c) {
+                u32 value = (u32)((sum[c] + box.population / 2) / box.population);
+                color |= ((value << 3) | (value >> 2)) << (c * 8);
+            }
+            palette.push_back(color);
+        }
+        return palette;
+    }
+
+    inline constexpr u32 MAP_GRAIN = 16384;
+
+    // Indices for every texel of `texels` against `palette`
+    inline void Map(const u32* texels, u32 count, const std::vector<u32>& palette, u8* indices) {
+        Parallel::For(count, MAP_GRAIN, [&](u32 begin, u32 end) {
+            BrushKernels::NearestIndex(texels + begin, end - begin, palette.data(), (u32)palette.size(), indices + begin);
+        });
+    }
+}
@@ -0,0 +1,41 @@
+#include "TiledCanvas.h"
+#include <algorithm>
+
+void TiledCanvas::Reset(u32 width, u32 height, u32 bytesPerTexel)
+{
+    _width = width;
+    _height = height;
+    _texelSize = bytesPerTexel;
+    _tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    _tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    _tiles.clear();
+    _tiles.shrink_to_fit();
+    _tiles.resize((size_t)_tilesX * _tilesY);
+    _resident.clear();
+    _resident.shrink_to_fit();
+}
+
+rect<s32> TiledCanvas::TileRect(u32 tile) const
+{
+    const s32 x = (s32)((tile % _tilesX) * TILE_SIZE);
+    const s32 y = (s32)((tile / _tilesX) * TILE_SIZE);
+    return rect<s32>(x, y, std::min(x + (s32)TILE_SIZE, (s32)_width), std::min(y + (s32)TILE_SIZE, (s32)_height));
+}
+
+void TiledCanvas::TileRange(const rect<s32>& area, u32& firstX, u32& firstY, u32& lastX, u32& lastY) const
+{
+    firstX = (u32)std::max(area.UpperLeftCorner.X, 0) / TILE_SIZE;
+    firstY = (u32)std::max(area.UpperLeftCorner.Y, 0) / TILE_SIZE;
+    lastX = std::min((u32)std::max(area.LowerRightCorner.X - 1, 0) / TILE_SIZE, _tilesX - 1);
+    lastY = std::min((u32)std::max(area.LowerRightCorner.Y - 1, 0) / TILE_SIZE, _tilesY - 1);
+}
+
+u8* TiledCanvas::Allocate(u32 tile)
+{
+    if (!_tiles[tile]) {
+        _tiles[tile].reset(new u8[(size_t)TILE_SIZE * TILE_SIZE * _texelSize]());
+        _resident.push_back(tile);
+    }
+    return _tiles[tile].get();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <memory>
+#include <vector>
+
+using namespace irr;
+using namespace core;
+
+// The painter's canvas, split into TILE_SIZE x TILE_SIZE tiles that only
+// exist once something writes to them. A tile that is not resident still
+// holds the texture's original texels, which the texture itself keeps, so
+// a 4096x4096 reference costs memory for the strokes on it, not for its size.
+//
+// Tiles keep the full TILE_SIZE stride at the right and bottom edges; the
+// part past the canvas is never read.
+class TiledCanvas {
+public:
+    static constexpr u32 TILE_SIZE = 64;
+
+    // New, empty canvas; every tile is dropped
+    void Reset(u32 width, u32 height, u32 bytesPerTexel);
+
+    u32 GetWidth() const { return _width; }
+    u32 GetHeight() const { return _height; }
+    u32 GetTexelSize() const { return _texelSize; }
+    u32 GetTileCount() const { return (u32)_tiles.size(); }
+    u32 GetResidentCount() const { return (u32)_resident.size(); }
+    const std::vector<u32>& GetResident() const { return _resident; } // Tile numbers, oldest first
+    u64 GetBytes() const { return (u64)_resident.size() * TILE_SIZE * TILE_SIZE * _texelSize; }
+
+    u32 TileAt(u32 x, u32 y) const { return (y / TILE_SIZE) * _tilesX + x / TILE_SIZE; }
+    rect<s32> TileRect(u32 tile) const;
+    // Tiles overlapping `area`, clipped to the canvas
+    void TileRange(const rect<s32>& area, u32& firstX, u32& firstY, u32& lastX, u32& lastY) const;
+    u32 GetTilesX() const { return _tilesX; }
+
+    bool IsResident(u32 tile) const { return _tiles[tile] != nullptr; }
+    // Zeroed texels for a tile that was not resident; the caller fills them
+    u8* Allocate(u32 tile);
+    u8* GetTile(u32 tile) { return _tiles[tile].get(); }
+    const u8* GetTile(u32 tile) const { return _tiles[tile].get(); }
+    // Exchanges a resident tile's texels with `texels`, which must hold a whole tile
+    void Swap(u32 tile, std::unique_ptr<u8[]>& texels) { std::swap(_tiles[tile], texels); }
+
+    // Texel (x, y) of a resident tile; the rest of the tile's row follows it
+    u8* Texel(u32 x, u32 y) { return _tiles[TileAt(x, y)].get() + _offset(x, y); }
+    const u8* Texel(u32 x, u32 y) const { return _tiles[TileAt(x, y)].get() + _offset(x, y); }
+
+private:
+    u32 _width = 0;
+    u32 _height = 0;
+    u32 _texelSize = 4;
+    u32 _tilesX = 0;
+    u32 _tilesY = 0;
+
+    std::vector<std::unique_ptr<u8[]>> _tiles; // Null where nothing was written
+    std::vector<u32> _resident;
+
+    size_t _offset(u32 x, u32 y) const { return ((size_t)(y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE) * _texelSize; }
+};
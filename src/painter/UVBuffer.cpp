@@ -0,0 +1,228 @@
+#include "UVBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+#include "helpers/Parallel.h"
+#include "helpers/Profiler.h"
+
+void UVBuffer::Update(IMeshSceneNode* node, ICameraSceneNode* camera, const dimension2d<u32>& size)
+{
+    IMesh* mesh = node ? node->getMesh() : nullptr;
+    if (!mesh || !camera || size.Width == 0 || size.Height == 0) {
+        _valid = false;
+        return;
+    }
+
+    camera->updateAbsolutePosition();
+    const matrix4 worldViewProj = camera->getProjectionMatrix() * camera->getViewMatrix() * node->getAbsoluteTransformation();
+
+    bool current = _valid && mesh == _mesh && size == _size && worldViewProj == _worldViewProj &&
+                   _buffers.size() == mesh->getMeshBufferCount();
+    for (u32 b = 0; current && b < mesh->getMeshBufferCount(); ++b) {
+        const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+        current = _buffers[b] == BufferKey{ mb, mb->getChangedID_Vertex(), mb->getChangedID_Index() };
+    }
+    if (current)
+        return;
+
+    _mesh = mesh;
+    _size = size;
+    _worldViewProj = worldViewProj;
+    _buffers.clear();
+    for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+        const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+        _buffers.push_back(BufferKey{ mb, mb->getChangedID_Vertex(), mb->getChangedID_Index() });
+    }
+    _rebuild(mesh);
+    _valid = true;
+}
+
+bool UVBuffer::Lookup(const position2di& position, const rect<s32>& viewport, Hit& hit) const
+{
+    if (!_valid || viewport.getWidth() <= 0 || viewport.getHeight() <= 0)
+        return false;
+
+    // The screen pixel's centre, scaled into the buffer
+    const f32 px = ((f32)(position.X - viewport.UpperLeftCorner.X) + 0.5f) * _size.Width / viewport.getWidth();
+    const f32 py = ((f32)(position.Y - viewport.UpperLeftCorner.Y) + 0.5f) * _size.Height / viewport.getHeight();
+    if (px < 0.0f || py < 0.0f || px >= (f32)_size.Width || py >= (f32)_size.Height)
+        return false;
+
+    // A pixel only knows the face at its centre. The faces of the four
+    // pixels around the position are tested exactly, and the nearest one
+    // containing it wins, so the result matches the full-resolution render
+    // even when the viewport is larger than the buffer.
+    const s32 left = std::max((s32)std::floor(px - 0.5f), 0);
+    const s32 top = std::max((s32)std::floor(py - 0.5f), 0);
+    const s32 right = std::min(left + 1, (s32)_size.Width - 1);
+    const s32 bottom = std::min(top + 1, (s32)_size.Height - 1);
+
+    const Face* face = nullptr;
+    f32 l[3];
+    f32 nearest = 0.0f;
+    for (s32 y = top; y <= bottom; ++y) {
+        for (s32 x = left; x <= right; ++x) {
+            const u32 id = _ids[(size_t)y * _size.Width + x];
+            if (id == EMPTY)
+                continue;
+            const Face& candidate = _faces[id - 1];
+            f32 weights[3];
+            _weights(candidate, px, py, weights);
+            if (weights[0] < 0.0f || weights[1] < 0.0f || weights[2] < 0.0f)
+                continue;
+            const f32 invW = weights[0] * candidate.invW[0] + weights[1] * candidate.invW[1] + weights[2] * candidate.invW[2];
+            if (invW > nearest) {
+                nearest = invW;
+                face = &candidate;
+                std::copy(weights, weights + 3, l);
+            }
+        }
+    }
+
+    if (!face) {
+        // Only the position's own pixel counts now, its face clamped onto
+        // the position (a silhouette or a face smaller than a pixel)
+        const u32 id = _ids[(size_t)py * _size.Width + (size_t)px];
+        if (id == EMPTY)
+            return false;
+        face = &_faces[id - 1];
+        _weights(*face, px, py, l);
+        for (f32& weight : l)
+            weight = std::max(weight, 0.0f);
+    }
+
+    // Screen weights to perspective-correct ones
+    const f32 p0 = l[0] * face->invW[0];
+    const f32 p1 = l[1] * face->invW[1];
+    const f32 p2 = l[2] * face->invW[2];
+    const f32 depth = 1.0f / (p0 + p1 + p2);
+
+    hit.buffer = face->buffer;
+    hit.triangle = face->triangle;
+    hit.barycentric = vector3df(p0 * depth, p1 * depth, p2 * depth);
+    hit.uv = (face->uv[0] * p0 + face->uv[1] * p1 + face->uv[2] * p2) * depth;
+    return true;
+}
+
+void UVBuffer::_weights(const Face& face, f32 x, f32 y, f32 weights[3])
+{
+    weights[1] = ((x - face.x[0]) * (face.y[2] - face.y[0]) - (face.x[2] - face.x[0]) * (y - face.y[0])) * face.invArea;
+    weights[2] = ((face.x[1] - face.x[0]) * (y - face.y[0]) - (x - face.x[0]) * (face.y[1] - face.y[0])) * face.invArea;
+    weights[0] = 1.0f - weights[1] - weights[2];
+}
+
+void UVBuffer::_rebuild(IMesh* mesh)
+{
+    Profiler::Scope scope("UV buffer");
+
+    const f32 width = (f32)_size.Width;
+    const f32 height = (f32)_size.Height;
+
+    // Project every vertex once; triangles share them
+    struct Projected { f32 x, y, invW; };
+    std::vector<Projected> projected;
+
+    _faces.clear();
+    for (u32 b = 0; b < mesh->getMeshBufferCount(); ++b) {
+        IMeshBuffer* mb = mesh->getMeshBuffer(b);
+        if (mb->getVertexType() != EVT_STANDARD) continue;
+
+        const S3DVertex* vertices = (const S3DVertex*)mb->getVertices();
+        const u16* indices = mb->getIndices();
+        const u32 indexCount = mb->getIndexCount() - mb->getIndexCount() % 3;
+
+        projected.resize(mb->getVertexCount());
+        for (u32 v = 0; v < mb->getVertexCount(); ++v) {
+            const vector3df& pos = vertices[v].Pos;
+            f32 clip[4] = { pos.X, pos.Y, pos.Z, 1.0f };
+            _worldViewProj.multiplyWith1x4Matrix(clip);
+
+            // invW 0 marks a vertex behind the camera
+            if (clip[3] <= 0.0f) {
+                projected[v] = { 0.0f, 0.0f, 0.0f };
+                continue;
+            }
+            const f32 invW = 1.0f / clip[3];
+            projected[v] = { (clip[0] * invW + 1.0f) * 0.5f * width, (1.0f - clip[1] * invW) * 0.5f * height, invW };
+        }
+
+        for (u32 i = 0; i < indexCount; i += 3) {
+            Face face;
+            bool visible = true;
+            for (u32 k = 0; k < 3; ++k) {
+                const Projected& p = projected[indices[i + k]];
+                // Triangles crossing the near plane are skipped, like FindClosestFace
+                if (p.invW <= 0.0f) { visible = false; break; }
+                face.x[k] = p.x;
+                face.y[k] = p.y;
+                face.invW[k] = p.invW;
+                face.uv[k] = vertices[indices[i + k]].TCoords;
+            }
+            if (!visible) continue;
+
+            const f32 minX = std::min({ face.x[0], face.x[1], face.x[2] });
+            const f32 maxX = std::max({ face.x[0], face.x[1], face.x[2] });
+            const f32 minY = std::min({ face.y[0], face.y[1], face.y[2] });
+            const f32 maxY = std::max({ face.y[0], face.y[1], face.y[2] });
+            if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) continue;
+
+            const f32 area = (face.x[1] - face.x[0]) * (face.y[2] - face.y[0]) -
+                             (face.x[2] - face.x[0]) * (face.y[1] - face.y[0]);
+            if (std::fabs(area) < 1e-6f) continue;
+
+            face.invArea = 1.0f / area;
+            face.buffer = b;
+            face.triangle = i / 3;
+            _faces.push_back(face);
+        }
+    }
+
+    const size_t pixels = (size_t)_size.Width * _size.Height;
+    _ids.assign(pixels, EMPTY);
+    _depth.assign(pixels, 0.0f);
+
+    // Each worker owns a band of rows, so no pixel is written by two threads
+    Parallel::For(_size.Height, ROW_GRAIN, [this](u32 begin, u32 end) {
+        _rasterise(begin, end);
+    });
+}
+
+void UVBuffer::_rasterise(u32 firstRow, u32 endRow)
+{
+    const s32 lastColumn = (s32)_size.Width - 1;
+
+    for (u32 f = 0; f < (u32)_faces.size(); ++f) {
+        const Face& face = _faces[f];
+
+        // Pixels whose centre lies inside the triangle's bounds
+        const s32 y0 = std::max((s32)std::ceil(std::min({ face.y[0], face.y[1], face.y[2] }) - 0.5f), (s32)firstRow);
+        const s32 y1 = std::min((s32)std::floor(std::max({ face.y[0], face.y[1], face.y[2] }) - 0.5f), (s32)endRow - 1);
+        const s32 x0 = std::max((s32)std::ceil(std::min({ face.x[0], face.x[1], face.x[2] }) - 0.5f), 0);
+        const s32 x1 = std::min((s32)std::floor(std::max({ face.x[0], face.x[1], face.x[2] }) - 0.5f), lastColumn);
+        if (y0 > y1 || x0 > x1) continue;
+
+        // Barycentrics are affine on screen; step them along each row
+        const f32 stepL1 = (face.y[2] - face.y[0]) * face.invArea;
+        const f32 stepL2 = -(face.y[1] - face.y[0]) * face.invArea;
+        const u32 id = f + 1;
+
+        for (s32 y = y0; y <= y1; ++y) {
+            f32 start[3];
+            _weights(face, (f32)x0 + 0.5f, (f32)y + 0.5f, start);
+            f32 l1 = start[1], l2 = start[2];
+
+            const size_t row = (size_t)y * _size.Width;
+            for (s32 x = x0; x <= x1; ++x, l1 += stepL1, l2 += stepL2) {
+                const f32 l0 = 1.0f - l1 - l2;
+                if (l0 < 0.0f || l1 < 0.0f || l2 < 0.0f) continue;
+
+                // 1/w is affine on screen too; the nearest surface has the largest
+                const f32 invW = l0 * face.invW[0] + l1 * face.invW[1] + l2 * face.invW[2];
+                if (invW > _depth[row + x]) {
+                    _depth[row + x] = invW;
+                    _ids[row + x] = id;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <irrlicht.h>
+#include <vector>
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+// Screen-to-surface lookup for painting. The mesh is rasterised on the CPU
+// into a face-ID buffer at the viewport's render resolution, with a depth
+// test on the perspective-correct 1/w, so each pixel holds the front-most
+// triangle exactly like the GPU render the user is looking at.
+//
+// The buffer is only rebuilt when the world-view-projection, the size or
+// the mesh (buffers and their change IDs) differs from the last build, so
+// a stroke costs one rasterisation at most. A lookup reads the faces of
+// the pixels under the cursor and evaluates their stored screen-space
+// setup at the exact position, giving the same barycentrics and UV as a
+// brute-force pick even when the viewport is larger than the buffer.
+class UVBuffer {
+public:
+    struct Hit {
+        u32 buffer;   // Mesh buffer index
+        u32 triangle; // Triangle within the buffer (first index / 3)
+        vector3df barycentric; // Perspective-correct weights of its corners
+        vector2df uv;
+    };
+
+    // Rebuilds when anything the buffer depends on has changed
+    void Update(IMeshSceneNode* node, ICameraSceneNode* camera, const dimension2d<u32>& size);
+    void Invalidate() { _valid = false; }
+
+    // `position` is in screen pixels inside `viewport`
+    bool Lookup(const position2di& position, const rect<s32>& viewport, Hit& hit) const;
+
+    const dimension2d<u32>& GetSize() const { return _size; }
+
+private:
+    static constexpr u32 EMPTY = 0; // Face IDs are index into _faces + 1
+    static constexpr u32 ROW_GRAIN = 32;
+
+    // Screen-space triangle, in buffer pixels, with what a hit reports
+    struct Face {
+        f32 x[3], y[3];
+        f32 invW[3];
+        f32 invArea;
+        vector2df uv[3];
+        u32 buffer;
+        u32 triangle;
+    };
+
+    struct BufferKey {
+        const IMeshBuffer* buffer;
+        u32 vertexChangedId;
+        u32 indexChangedId;
+        bool operator==(const BufferKey& o) const {
+            return buffer == o.buffer && vertexChangedId == o.vertexChangedId && indexChangedId == o.indexChangedId;
+        }
+    };
+
+    bool _valid = false;
+    const IMesh* _mesh = nullptr;
+    matrix4 _worldViewProj;
+    dimension2d<u32> _size;
+    std::vector<BufferKey> _buffers;
+
+    std::vector<Face> _faces;
+    std::vector<u32> _ids;   // Per pixel: face + 1, or EMPTY
+    std::vector<f32> _depth; // Per pixel: 1/w of the front-most face
+
+    // Screen-space barycentrics of (x, y), in buffer pixels
+    static void _weights(const Face& face, f32 x, f32 y, f32 weights[3]);
+    void _rebuild(IMesh* mesh);
+    void _rasterise(u32 firstRow, u32 endRow);
+};
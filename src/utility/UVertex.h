@@ -278,6 +278,7 @@ inline FaceSelection FindClosestFace(
     // Structure to track triangles that share edges
     struct TriangleInfo {
         u32 bufferIndex;
+        u32 firstIndex;
         u32 idx1, idx2, idx3;
         vector3df worldPos1, worldPos2, worldPos3;
         f32 depthSq;
@@ -328,6 +329,7 @@ inline FaceSelection FindClosestFace(
 
                 TriangleInfo info;
                 info.bufferIndex = b;
+                info.firstIndex = i;
                 info.idx1 = idx1;
                 info.idx2 = idx2;
                 info.idx3 = idx3;
@@ -372,8 +374,16 @@ inline FaceSelection FindClosestFace(
         return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
     };
     
+    // Quads are stored as two consecutive triangles, so the neighbours in the
+    // index buffer are tried before the rest of the buffer
+    u32 partners[2];
+    u32 partnerCount = 0;
+    if (closest.firstIndex + 5 < indexCount) partners[partnerCount++] = closest.firstIndex + 3;
+    if (closest.firstIndex >= 3) partners[partnerCount++] = closest.firstIndex - 3;
+
     // Look for a triangle that shares an edge with the closest one
-    for (u32 i = 0; i < indexCount; i += 3) {
+    for (u32 n = 0; n < partnerCount + indexCount / 3; ++n) {
+        u32 i = n < partnerCount ? partners[n] : (n - partnerCount) * 3;
         u32 idx1 = indices[i];
         u32 idx2 = indices[i + 1];
         u32 idx3 = indices[i + 2];
@@ -390,6 +400,7 @@ inline FaceSelection FindClosestFace(
         
         TriangleInfo other;
         other.bufferIndex = closest.bufferIndex;
+        other.firstIndex = i;
         other.idx1 = idx1;
         other.idx2 = idx2;
         other.idx3 = idx3;
@@ -422,6 +433,8 @@ inline FaceSelection FindClosestFace(
                 result.isSelected = true;
                 result.bufferIndex = closest.bufferIndex;
                 result.isQuad = true;
+                result.triangleIndex1 = closest.firstIndex;
+                result.triangleIndex2 = other.firstIndex;
                 
                 // Store all 4 vertices
                 std::vector<u32> vertIndices(uniqueIndices.begin(), uniqueIndices.end());
@@ -459,6 +472,7 @@ inline FaceSelection FindClosestFace(
     result.worldPos2 = closest.worldPos2;
     result.worldPos3 = closest.worldPos3;
     result.isQuad = false;
+    result.triangleIndex1 = closest.firstIndex;
 
     return result;
 }